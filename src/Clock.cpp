@@ -0,0 +1,72 @@
+#include <canopen_master/Clock.hpp>
+#include <time.h>
+
+using namespace std;
+using namespace canopen_master;
+
+static int64_t monotonicNanoseconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+Clock::~Clock()
+{
+}
+
+Timestamp Clock::nowTimestamp() const
+{
+    return toTimestamp(now());
+}
+
+base::Time SystemClock::now() const
+{
+    return base::Time::now();
+}
+
+SystemClock const& SystemClock::instance()
+{
+    static const SystemClock clock;
+    return clock;
+}
+
+MonotonicClock::MonotonicClock()
+    : offset(toTimestamp(base::Time::now()) - monotonicNanoseconds())
+{
+}
+
+base::Time MonotonicClock::now() const
+{
+    return toTime(nowTimestamp());
+}
+
+Timestamp MonotonicClock::nowTimestamp() const
+{
+    return monotonicNanoseconds() + offset;
+}
+
+CachedClock::CachedClock(base::Time const& time)
+    : time(time)
+{
+}
+
+base::Time CachedClock::now() const
+{
+    return time;
+}
+
+void CachedClock::setTime(base::Time const& time)
+{
+    this->time = time;
+}
+
+void CachedClock::update(Clock const& clock)
+{
+    time = clock.now();
+}
+
+void CachedClock::advance(base::Time const& duration)
+{
+    time = time + duration;
+}
@@ -0,0 +1,102 @@
+#ifndef CANOPEN_MASTER_CLOCK_HPP
+#define CANOPEN_MASTER_CLOCK_HPP
+
+#include <base/Time.hpp>
+#include <cstdint>
+
+namespace canopen_master
+{
+    /** Compact timestamp in nanoseconds, on the same time base as
+     * base::Time
+     *
+     * Zero is reserved to mean "no timestamp"
+     */
+    typedef int64_t Timestamp;
+
+    inline Timestamp toTimestamp(base::Time const& time)
+    {
+        return time.toMicroseconds() * 1000;
+    }
+
+    inline base::Time toTime(Timestamp timestamp)
+    {
+        return base::Time::fromMicroseconds(timestamp / 1000);
+    }
+
+    /** Source of the timestamps used when the caller does not provide one
+     *
+     * StateMachine uses a clock to timestamp the objects written with
+     * set() and the SYNC messages. The default is the system clock.
+     * Replacing it with a CachedClock avoids a clock call per object in
+     * cyclic code, and with a clock driven by a simulation or a replay
+     * makes the timestamps reproducible.
+     */
+    class Clock
+    {
+    public:
+        virtual ~Clock();
+        virtual base::Time now() const = 0;
+
+        /** The current time as a Timestamp
+         *
+         * The default implementation converts now(). Clocks with a
+         * resolution better than a microsecond override it
+         */
+        virtual Timestamp nowTimestamp() const;
+    };
+
+    /** Clock returning base::Time::now() */
+    class SystemClock : public Clock
+    {
+    public:
+        base::Time now() const override;
+
+        /** A process-wide instance, used by default */
+        static SystemClock const& instance();
+    };
+
+    /** Clock reading CLOCK_MONOTONIC, offset to match the system clock
+     * at construction
+     *
+     * The offset is computed once, so the timestamps are not affected
+     * by system time adjustments that happen afterwards
+     */
+    class MonotonicClock : public Clock
+    {
+    public:
+        MonotonicClock();
+        base::Time now() const override;
+        Timestamp nowTimestamp() const override;
+
+    private:
+        /** Offset from CLOCK_MONOTONIC to the system time, in nanoseconds */
+        int64_t offset;
+    };
+
+    /** Clock returning a time set explicitly
+     *
+     * It is meant to be updated once per cycle, e.g. with the reception
+     * time of the frames being processed, or by a simulation
+     */
+    class CachedClock : public Clock
+    {
+    public:
+        explicit CachedClock(base::Time const& time = base::Time());
+
+        base::Time now() const override;
+
+        /** Set the time returned by now() */
+        void setTime(base::Time const& time);
+
+        /** Set the time to the given clock's current time */
+        void update(Clock const& clock = SystemClock::instance());
+
+        /** Advance the time by the given duration */
+        void advance(base::Time const& duration);
+
+    private:
+        base::Time time;
+    };
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <canopen_master/ClockEstimator.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+ClockEstimator::ClockEstimator(size_t windowSize)
+{
+    if (windowSize < 2)
+        throw std::invalid_argument("ClockEstimator needs a window of at least 2 samples");
+    samples.resize(windowSize);
+    selected.resize(windowSize);
+}
+
+void ClockEstimator::reset()
+{
+    sampleCount = 0;
+    nextSample = 0;
+    slope = 1;
+    intercept = 0;
+}
+
+void ClockEstimator::update(int64_t deviceTime, base::Time const& hostTime)
+{
+    if (sampleCount == 0) {
+        hostReference = hostTime;
+        deviceReference = deviceTime;
+    }
+
+    Sample& sample = samples[nextSample];
+    sample.device = deviceTime - deviceReference;
+    sample.host = (hostTime - hostReference).toMicroseconds();
+    nextSample = (nextSample + 1) % samples.size();
+    sampleCount = min(sampleCount + 1, samples.size());
+
+    lastDeviceTime = deviceTime;
+    lastHostTime = hostTime;
+    fit();
+}
+
+void ClockEstimator::fit()
+{
+    // Ordinary least squares first, and then refine the fit on the samples
+    // that are below the line, i.e. the least delayed ones
+    fill(selected.begin(), selected.end(), true);
+    for (int pass = 0; pass < 3 && sampleCount >= 2; ++pass) {
+        double meanDevice = 0, meanHost = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < sampleCount; ++i) {
+            if (!selected[i])
+                continue;
+            meanDevice += samples[i].device;
+            meanHost += samples[i].host;
+            ++count;
+        }
+        if (count < 2)
+            break;
+        meanDevice /= count;
+        meanHost /= count;
+
+        double covariance = 0, variance = 0;
+        for (size_t i = 0; i < sampleCount; ++i) {
+            if (!selected[i])
+                continue;
+            double d = samples[i].device - meanDevice;
+            covariance += d * (samples[i].host - meanHost);
+            variance += d * d;
+        }
+        if (variance <= 0)
+            break;
+
+        slope = covariance / variance;
+        double lineIntercept = meanHost - slope * meanDevice;
+        for (size_t i = 0; i < sampleCount; ++i) {
+            double residual = samples[i].host - slope * samples[i].device - lineIntercept;
+            selected[i] = selected[i] && residual <= 0;
+        }
+    }
+
+    // Delays only make messages arrive later. Use the lower envelope
+    intercept = samples[0].host - slope * samples[0].device;
+    for (size_t i = 1; i < sampleCount; ++i)
+        intercept = min(intercept, samples[i].host - slope * samples[i].device);
+}
+
+int64_t ClockEstimator::unwrap(uint64_t counter, unsigned int bits) const
+{
+    if (sampleCount == 0)
+        return counter;
+
+    uint64_t mask = (bits >= 64) ? ~0ULL : ((1ULL << bits) - 1);
+    uint64_t delta = (counter - lastCounter) & mask;
+    int64_t signedDelta = delta;
+    if (bits < 64 && (delta >> (bits - 1)))
+        signedDelta = static_cast<int64_t>(delta) - static_cast<int64_t>(mask) - 1;
+    return counterTime + signedDelta;
+}
+
+void ClockEstimator::updateCounter(uint64_t counter, unsigned int bits, double tick,
+                                   base::Time const& hostTime)
+{
+    counterTime = unwrap(counter, bits);
+    lastCounter = counter;
+    update(llround(counterTime * tick), hostTime);
+}
+
+base::Time ClockEstimator::counterToHostTime(uint64_t counter, unsigned int bits,
+                                             double tick) const
+{
+    return toHostTime(llround(unwrap(counter, bits) * tick));
+}
+
+void ClockEstimator::updateHeartbeat(base::Time const& hostTime,
+                                     base::Time const& nominalPeriod)
+{
+    int64_t period = nominalPeriod.toMicroseconds();
+    if (period <= 0)
+        throw std::invalid_argument("the heartbeat period must be positive");
+    if (sampleCount == 0) {
+        update(0, hostTime);
+        return;
+    }
+
+    // Account for missed heartbeats
+    double elapsed = (hostTime - lastHostTime).toMicroseconds();
+    int64_t count = llround(elapsed / (period * slope));
+    update(lastDeviceTime + max<int64_t>(1, count) * period, hostTime);
+}
+
+bool ClockEstimator::isValid() const
+{
+    return sampleCount >= 2;
+}
+
+base::Time ClockEstimator::toHostTime(int64_t deviceTime) const
+{
+    double host = slope * (deviceTime - deviceReference) + intercept;
+    return hostReference + base::Time::fromMicroseconds(llround(host));
+}
+
+double ClockEstimator::getDrift() const
+{
+    return slope - 1;
+}
+
+int64_t ClockEstimator::getLastDeviceTime() const
+{
+    return lastDeviceTime;
+}
@@ -0,0 +1,108 @@
+#ifndef CANOPEN_MASTER_CLOCK_ESTIMATOR_HPP
+#define CANOPEN_MASTER_CLOCK_ESTIMATOR_HPP
+
+#include <base/Time.hpp>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Estimation of the offset and drift of a device clock w.r.t. the host
+     *
+     * The estimator is fed with pairs of (device time, host reception time),
+     * either from a device timestamp mapped in a TPDO (updateCounter), or
+     * from the heartbeat arrival times, using the fact that the device
+     * produces heartbeats at a known period of its own clock
+     * (updateHeartbeat).
+     *
+     * The relation between the two clocks is estimated with a linear fit
+     * over the last samples. Since transmission and queueing delays can only
+     * make messages arrive later, the fitted line is then shifted to the
+     * lower envelope of the samples.
+     *
+     * Device times are in microseconds
+     */
+    class ClockEstimator
+    {
+    public:
+        /**
+         * @arg windowSize the number of samples the fit is computed on
+         */
+        explicit ClockEstimator(size_t windowSize = 64);
+
+        /** Add a sample */
+        void update(int64_t deviceTime, base::Time const& hostTime);
+
+        /** Add a sample from a wrapping device counter
+         *
+         * @arg counter the raw counter value
+         * @arg bits the counter width in bits
+         * @arg tick the counter resolution in microseconds
+         */
+        void updateCounter(uint64_t counter, unsigned int bits, double tick,
+                           base::Time const& hostTime);
+
+        /** Add a sample from the arrival of a heartbeat
+         *
+         * @arg nominalPeriod the heartbeat producer time configured on the
+         *   device (object 0x1017)
+         * @throw std::invalid_argument if the period is not positive
+         */
+        void updateHeartbeat(base::Time const& hostTime,
+                             base::Time const& nominalPeriod);
+
+        /** Whether enough samples have been received to estimate the clock */
+        bool isValid() const;
+
+        /** Convert a device time into host time */
+        base::Time toHostTime(int64_t deviceTime) const;
+
+        /** Convert a raw counter value into host time
+         *
+         * The counter is unwrapped relative to the last sample given to
+         * updateCounter, so it must not be more than half a counter period
+         * away from it
+         */
+        base::Time counterToHostTime(uint64_t counter, unsigned int bits,
+                                     double tick) const;
+
+        /** The relative drift of the device clock, i.e. how many host
+         * seconds elapse per device second, minus one */
+        double getDrift() const;
+
+        /** The device time of the last sample */
+        int64_t getLastDeviceTime() const;
+
+        /** Remove all samples */
+        void reset();
+
+    private:
+        struct Sample
+        {
+            double device;
+            double host;
+        };
+
+        std::vector<Sample> samples;
+        /** Samples used in the current pass of the fit */
+        std::vector<char> selected;
+        size_t sampleCount = 0;
+        size_t nextSample = 0;
+
+        /** Host time all host times are relative to, to keep precision */
+        base::Time hostReference;
+        int64_t deviceReference = 0;
+        int64_t lastDeviceTime = 0;
+        base::Time lastHostTime;
+
+        uint64_t lastCounter = 0;
+        int64_t counterTime = 0;
+
+        double slope = 1;
+        double intercept = 0;
+
+        void fit();
+        int64_t unwrap(uint64_t counter, unsigned int bits) const;
+    };
+}
+
+#endif
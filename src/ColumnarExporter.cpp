@@ -0,0 +1,354 @@
+#include <canopen_master/ColumnarExporter.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+using namespace std;
+using namespace canopen_master;
+using namespace canopen_master::columnar;
+
+static std::runtime_error systemError(string const& message)
+{
+    return std::runtime_error(message + ": " + strerror(errno));
+}
+
+static const uint8_t PADDING[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+uint8_t canopen_master::getColumnValueSize(COLUMN_TYPE type)
+{
+    switch(type) {
+        case COLUMN_UINT8:
+        case COLUMN_INT8:
+            return 1;
+        case COLUMN_UINT16:
+        case COLUMN_INT16:
+            return 2;
+        case COLUMN_UINT32:
+        case COLUMN_INT32:
+            return 4;
+    }
+    throw std::invalid_argument("invalid column type " + to_string(type));
+}
+
+ColumnarExporter::ColumnarExporter(string const& path, size_t blockSize)
+    : blockSize(blockSize)
+{
+    if (blockSize == 0)
+        throw std::invalid_argument("the block size must not be zero");
+
+    fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd == -1)
+        throw systemError("failed to create " + path);
+
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.reserved = 0;
+    try {
+        write(&header, sizeof(header));
+    }
+    catch(...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+ColumnarExporter::~ColumnarExporter()
+{
+    if (fd == -1)
+        return;
+    try {
+        close();
+    }
+    catch(std::exception const&) {
+    }
+}
+
+size_t ColumnarExporter::add(StateMachine& machine, uint16_t objectId, uint8_t subId,
+                             COLUMN_TYPE type)
+{
+    if (fd == -1)
+        throw std::logic_error("the exporter is closed");
+
+    ColumnBuffer column;
+    column.descriptor.nodeId = machine.getNodeID();
+    column.descriptor.objectId = objectId;
+    column.descriptor.subId = subId;
+    column.descriptor.type = type;
+    column.descriptor.valueSize = getColumnValueSize(type);
+    column.descriptor.reserved = 0;
+    column.descriptor.firstBlock = 0;
+    column.descriptor.blockCount = 0;
+    column.descriptor.sampleCount = 0;
+    column.timestamps.resize(blockSize);
+    column.values.resize(blockSize * column.descriptor.valueSize);
+    column.machine = &machine;
+
+    size_t index = columns.size();
+    column.subscription = machine.subscribe(objectId, subId,
+        [this, index](StateMachine::ObjectUpdate const& update) {
+            append(index, update);
+        });
+    columns.push_back(move(column));
+    return index;
+}
+
+template<typename T>
+static void store(uint8_t* out, StateMachine::ObjectUpdate const& update)
+{
+    T value = update.as<T>();
+    memcpy(out, &value, sizeof(T));
+}
+
+void ColumnarExporter::append(size_t index, StateMachine::ObjectUpdate const& update)
+{
+    ColumnBuffer& column = columns[index];
+    uint8_t* value = &column.values[column.size * column.descriptor.valueSize];
+    switch(column.descriptor.type) {
+        case COLUMN_UINT8: store<uint8_t>(value, update); break;
+        case COLUMN_INT8: store<int8_t>(value, update); break;
+        case COLUMN_UINT16: store<uint16_t>(value, update); break;
+        case COLUMN_INT16: store<int16_t>(value, update); break;
+        case COLUMN_UINT32: store<uint32_t>(value, update); break;
+        case COLUMN_INT32: store<int32_t>(value, update); break;
+    }
+    column.timestamps[column.size++] = update.timestamp;
+    ++column.descriptor.sampleCount;
+    if (column.size != blockSize)
+        return;
+
+    try {
+        writeBlock(column);
+    }
+    catch(std::runtime_error const&) {
+        // Called from StateMachine::process, which must not fail on a
+        // frame it has already applied
+        ++writeErrors;
+        column.descriptor.sampleCount -= column.size;
+        column.size = 0;
+    }
+}
+
+uint64_t ColumnarExporter::getSampleCount(size_t column) const
+{
+    return columns.at(column).descriptor.sampleCount;
+}
+
+uint64_t ColumnarExporter::getWriteErrorCount() const
+{
+    return writeErrors;
+}
+
+void ColumnarExporter::write(void const* data, size_t size)
+{
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            throw systemError("failed to write the columnar export");
+        }
+        bytes += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+void ColumnarExporter::align()
+{
+    if (offset % 8)
+        write(PADDING, 8 - offset % 8);
+}
+
+void ColumnarExporter::writeBlock(ColumnBuffer& column)
+{
+    if (column.size == 0)
+        return;
+
+    align();
+    Block block;
+    block.offset = offset;
+    block.sampleCount = column.size;
+    block.firstTimestamp = column.timestamps[0];
+    block.lastTimestamp = column.timestamps[column.size - 1];
+
+    size_t valuesSize = column.size * column.descriptor.valueSize;
+    iovec iov[3] = {
+        { column.timestamps.data(), column.size * sizeof(Timestamp) },
+        { column.values.data(), valuesSize },
+        { const_cast<uint8_t*>(PADDING), (8 - valuesSize % 8) % 8 }
+    };
+    ssize_t written = writev(fd, iov, 3);
+    if (written == -1) {
+        if (errno != EINTR)
+            throw systemError("failed to write the columnar export");
+        written = 0;
+    }
+    offset += written;
+
+    // Finish short writes with plain writes
+    size_t skip = written;
+    for (auto const& part : iov) {
+        if (skip >= part.iov_len) {
+            skip -= part.iov_len;
+            continue;
+        }
+        write(static_cast<uint8_t const*>(part.iov_base) + skip, part.iov_len - skip);
+        skip = 0;
+    }
+
+    column.blocks.push_back(block);
+    column.size = 0;
+}
+
+void ColumnarExporter::flush()
+{
+    for (auto& column : columns)
+        writeBlock(column);
+}
+
+void ColumnarExporter::close()
+{
+    if (fd == -1)
+        return;
+
+    for (auto& column : columns)
+        column.machine->unsubscribe(column.subscription);
+
+    try {
+        flush();
+        align();
+
+        Trailer trailer;
+        trailer.footerOffset = offset;
+        trailer.magic = MAGIC;
+        trailer.version = VERSION;
+
+        FooterHeader footer;
+        footer.columnCount = columns.size();
+        footer.reserved = 0;
+        footer.blockCount = 0;
+        for (auto& column : columns) {
+            column.descriptor.firstBlock = footer.blockCount;
+            column.descriptor.blockCount = column.blocks.size();
+            footer.blockCount += column.blocks.size();
+        }
+
+        write(&footer, sizeof(footer));
+        for (auto const& column : columns)
+            write(&column.descriptor, sizeof(Column));
+        for (auto const& column : columns)
+            write(column.blocks.data(), column.blocks.size() * sizeof(Block));
+        write(&trailer, sizeof(trailer));
+    }
+    catch(...) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+
+    int result = ::close(fd);
+    fd = -1;
+    if (result == -1)
+        throw systemError("failed to close the columnar export");
+}
+
+ColumnarReader::ColumnarReader(string const& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw systemError("failed to open " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        ::close(fd);
+        throw systemError("failed to stat " + path);
+    }
+    mappingSize = info.st_size;
+    if (mappingSize < sizeof(FileHeader) + sizeof(FooterHeader) + sizeof(Trailer)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a complete columnar export");
+    }
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw systemError("failed to map " + path);
+
+    uint8_t const* bytes = static_cast<uint8_t const*>(mapping);
+    FileHeader const& header = *reinterpret_cast<FileHeader const*>(bytes);
+    Trailer const& trailer = *reinterpret_cast<Trailer const*>(
+        bytes + mappingSize - sizeof(Trailer));
+    bool valid = header.magic == MAGIC && header.version == VERSION &&
+        trailer.magic == MAGIC && trailer.version == VERSION &&
+        trailer.footerOffset % 8 == 0 &&
+        trailer.footerOffset + sizeof(FooterHeader) + sizeof(Trailer) <= mappingSize;
+
+    if (valid) {
+        FooterHeader const& footer = *reinterpret_cast<FooterHeader const*>(
+            bytes + trailer.footerOffset);
+        columnCount = footer.columnCount;
+        dataEnd = trailer.footerOffset;
+        columns = reinterpret_cast<Column const*>(
+            bytes + trailer.footerOffset + sizeof(FooterHeader));
+        blocks = reinterpret_cast<Block const*>(columns + columnCount);
+        valid = trailer.footerOffset + sizeof(FooterHeader) +
+            columnCount * sizeof(Column) + footer.blockCount * sizeof(Block) +
+            sizeof(Trailer) == mappingSize;
+    }
+    if (!valid) {
+        munmap(mapping, mappingSize);
+        throw std::runtime_error(path + " is not a complete columnar export of "
+                                 "this library version");
+    }
+}
+
+ColumnarReader::~ColumnarReader()
+{
+    munmap(mapping, mappingSize);
+}
+
+size_t ColumnarReader::getColumnCount() const
+{
+    return columnCount;
+}
+
+Column const& ColumnarReader::getColumn(size_t column) const
+{
+    if (column >= columnCount)
+        throw std::out_of_range("no such column");
+    return columns[column];
+}
+
+int ColumnarReader::find(uint8_t nodeId, uint16_t objectId, uint8_t subId) const
+{
+    for (size_t i = 0; i < columnCount; ++i) {
+        Column const& column = columns[i];
+        if (column.nodeId == nodeId && column.objectId == objectId && column.subId == subId)
+            return i;
+    }
+    return -1;
+}
+
+ColumnBlock ColumnarReader::getBlock(size_t column, size_t block) const
+{
+    Column const& descriptor = getColumn(column);
+    if (block >= descriptor.blockCount)
+        throw std::out_of_range("no such block");
+
+    Block const& info = blocks[descriptor.firstBlock + block];
+    if (info.offset + info.sampleCount * (sizeof(Timestamp) + descriptor.valueSize) > dataEnd)
+        throw std::runtime_error("corrupted columnar export");
+    uint8_t const* timestamps = static_cast<uint8_t const*>(mapping) + info.offset;
+    ColumnBlock result;
+    result.type = static_cast<COLUMN_TYPE>(descriptor.type);
+    result.size = info.sampleCount;
+    result.timestamps = reinterpret_cast<Timestamp const*>(timestamps);
+    result.values = timestamps + info.sampleCount * sizeof(Timestamp);
+    return result;
+}
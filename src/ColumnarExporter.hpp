@@ -0,0 +1,264 @@
+#ifndef CANOPEN_MASTER_COLUMNAR_EXPORTER_HPP
+#define CANOPEN_MASTER_COLUMNAR_EXPORTER_HPP
+
+#include <canopen_master/StateMachine.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Type of the values of a column */
+    enum COLUMN_TYPE {
+        COLUMN_UINT8  = 0,
+        COLUMN_INT8   = 1,
+        COLUMN_UINT16 = 2,
+        COLUMN_INT16  = 3,
+        COLUMN_UINT32 = 4,
+        COLUMN_INT32  = 5
+    };
+
+    /** The COLUMN_TYPE of a C++ type */
+    template<typename T> struct ColumnTypeOf;
+    template<> struct ColumnTypeOf<uint8_t>  { static const COLUMN_TYPE value = COLUMN_UINT8; };
+    template<> struct ColumnTypeOf<int8_t>   { static const COLUMN_TYPE value = COLUMN_INT8; };
+    template<> struct ColumnTypeOf<uint16_t> { static const COLUMN_TYPE value = COLUMN_UINT16; };
+    template<> struct ColumnTypeOf<int16_t>  { static const COLUMN_TYPE value = COLUMN_INT16; };
+    template<> struct ColumnTypeOf<uint32_t> { static const COLUMN_TYPE value = COLUMN_UINT32; };
+    template<> struct ColumnTypeOf<int32_t>  { static const COLUMN_TYPE value = COLUMN_INT32; };
+
+    /** Size in bytes of a value of the given type */
+    uint8_t getColumnValueSize(COLUMN_TYPE type);
+
+    /** Layout of the files written by ColumnarExporter
+     *
+     * The file is a header, followed by blocks, followed by a footer that
+     * indexes them. A block holds consecutive samples of a single column,
+     * as an array of Timestamp followed by an array of values. Blocks are
+     * padded to 8 bytes, so that all arrays are aligned when the file is
+     * mapped.
+     *
+     * The footer is a FooterHeader, the Column descriptors, then the
+     * Block descriptors grouped by column. The file ends with a Trailer
+     * that gives the footer's offset. Fields are in host byte order.
+     */
+    namespace columnar
+    {
+        static const uint32_t MAGIC = 0x53544f43; // "COTS"
+        /** Incremented on each incompatible layout change */
+        static const uint32_t VERSION = 1;
+
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t reserved;
+        };
+
+        struct FooterHeader
+        {
+            uint32_t columnCount;
+            uint32_t reserved;
+            uint64_t blockCount;
+        };
+
+        struct Column
+        {
+            uint8_t nodeId;
+            uint8_t subId;
+            uint16_t objectId;
+            /** A COLUMN_TYPE */
+            uint8_t type;
+            uint8_t valueSize;
+            uint16_t reserved;
+            /** Index of the column's first block in the footer */
+            uint32_t firstBlock;
+            uint32_t blockCount;
+            uint64_t sampleCount;
+        };
+
+        struct Block
+        {
+            /** Offset of the timestamps in the file */
+            uint64_t offset;
+            uint64_t sampleCount;
+            Timestamp firstTimestamp;
+            Timestamp lastTimestamp;
+        };
+
+        struct Trailer
+        {
+            uint64_t footerOffset;
+            uint32_t magic;
+            uint32_t version;
+        };
+
+        static_assert(sizeof(FileHeader) == 16 && sizeof(FooterHeader) == 16 &&
+                      sizeof(Column) == 24 && sizeof(Block) == 32 &&
+                      sizeof(Trailer) == 16, "unexpected columnar layout");
+    }
+
+    /** Export of dictionary updates as per-object time series
+     *
+     * Each exported object is a column of (timestamp, value) samples,
+     * appended each time StateMachine::process writes the object. The
+     * samples of a column are accumulated in a buffer allocated when the
+     * column is added, so exporting a sample does not allocate. Once full,
+     * the buffer is written as one block synchronously, i.e. by the thread
+     * that calls StateMachine::process. Use a large enough block size to
+     * keep these writes rare.
+     *
+     * Errors while writing a full block are not reported to
+     * StateMachine::process, as the frame has been processed already. The
+     * samples of the block are dropped instead, and the error is counted,
+     * see getWriteErrorCount.
+     *
+     * Read the files with ColumnarReader. The file is only readable once
+     * close() has written its index. The state machines must outlive the
+     * exporter, or close() must be called before they are destroyed.
+     */
+    class ColumnarExporter
+    {
+    public:
+        /** Create the file, replacing any existing one
+         *
+         * @arg blockSize the number of samples of a column written at once
+         * @throw std::runtime_error if the file cannot be created
+         */
+        explicit ColumnarExporter(std::string const& path, size_t blockSize = 4096);
+
+        /** Closes the file if close() has not been called */
+        ~ColumnarExporter();
+
+        ColumnarExporter(ColumnarExporter const&) = delete;
+        ColumnarExporter& operator =(ColumnarExporter const&) = delete;
+
+        /** Export an object of a state machine
+         *
+         * @return the column index
+         */
+        size_t add(StateMachine& machine, uint16_t objectId, uint8_t subId,
+                   COLUMN_TYPE type);
+
+        /** Export an object defined with CANOPEN_DEFINE_OBJECT */
+        template<typename T>
+        size_t add(StateMachine& machine, int offsetId = 0, int offsetSubId = 0) {
+            return add(machine, T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId,
+                       ColumnTypeOf<typename T::OBJECT_TYPE>::value);
+        }
+
+        /** Append a sample to a column
+         *
+         * Writes the column's block if it is full. Write errors are counted
+         * instead of thrown, see getWriteErrorCount
+         */
+        void append(size_t column, StateMachine::ObjectUpdate const& update);
+
+        /** Number of samples of a column, excluding the ones that were
+         * dropped because of write errors */
+        uint64_t getSampleCount(size_t column) const;
+
+        /** Number of blocks that could not be written by append(), and
+         * whose samples were dropped */
+        uint64_t getWriteErrorCount() const;
+
+        /** Write the samples that are still buffered
+         *
+         * @throw std::runtime_error if the write fails
+         */
+        void flush();
+
+        /** Write the buffered samples and the index, and close the file
+         *
+         * Samples are not exported anymore after this call
+         */
+        void close();
+
+    private:
+        struct ColumnBuffer
+        {
+            columnar::Column descriptor;
+            std::vector<Timestamp> timestamps;
+            std::vector<uint8_t> values;
+            size_t size = 0;
+            std::vector<columnar::Block> blocks;
+            StateMachine* machine;
+            StateMachine::SubscriptionID subscription;
+        };
+
+        int fd;
+        size_t blockSize;
+        uint64_t offset = 0;
+        uint64_t writeErrors = 0;
+        std::vector<ColumnBuffer> columns;
+
+        void write(void const* data, size_t size);
+        /** Pad the file to 8 bytes, which a failed write may have broken */
+        void align();
+        void writeBlock(ColumnBuffer& column);
+    };
+
+    /** A block of samples of a column, as mapped from the file */
+    struct ColumnBlock
+    {
+        COLUMN_TYPE type;
+        size_t size;
+        Timestamp const* timestamps;
+        void const* values;
+
+        /** The values of the block
+         *
+         * @throw std::invalid_argument if T does not match the column type
+         */
+        template<typename T> T const* as() const
+        {
+            if (ColumnTypeOf<T>::value != type)
+                throw std::invalid_argument("wrong type for the values of this column");
+            return static_cast<T const*>(values);
+        }
+    };
+
+    /** Read access to a file written by ColumnarExporter
+     *
+     * The file is memory-mapped. Only the blocks of the columns that are
+     * actually accessed are read from disk.
+     */
+    class ColumnarReader
+    {
+    public:
+        /** @throw std::runtime_error if the file cannot be read, or is not
+         *   a complete columnar export of this library version */
+        explicit ColumnarReader(std::string const& path);
+        ~ColumnarReader();
+
+        ColumnarReader(ColumnarReader const&) = delete;
+        ColumnarReader& operator =(ColumnarReader const&) = delete;
+
+        size_t getColumnCount() const;
+
+        /** @throw std::out_of_range if the column does not exist */
+        columnar::Column const& getColumn(size_t column) const;
+
+        /** Index of the column of the given object, or -1 */
+        int find(uint8_t nodeId, uint16_t objectId, uint8_t subId) const;
+
+        template<typename T>
+        int find(uint8_t nodeId, int offsetId = 0, int offsetSubId = 0) const {
+            return find(nodeId, T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId);
+        }
+
+        /** @throw std::out_of_range if the column or block does not exist
+         * @throw std::runtime_error if the block is outside the file */
+        ColumnBlock getBlock(size_t column, size_t block) const;
+
+    private:
+        size_t mappingSize;
+        void* mapping;
+        uint64_t dataEnd;
+        uint32_t columnCount;
+        columnar::Column const* columns;
+        columnar::Block const* blocks;
+    };
+}
+
+#endif
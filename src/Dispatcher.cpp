@@ -0,0 +1,62 @@
+#include <canopen_master/Dispatcher.hpp>
+#include <algorithm>
+
+using namespace std;
+using namespace canopen_master;
+
+Dispatcher::Dispatcher()
+{
+    fill(machines, machines + 128, nullptr);
+}
+
+void Dispatcher::add(StateMachine& machine)
+{
+    uint8_t nodeId = machine.getNodeID();
+    if (nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+    else if (machines[nodeId])
+        throw std::invalid_argument("a state machine is already registered for this node");
+
+    machines[nodeId] = &machine;
+    ++nodeCount;
+}
+
+void Dispatcher::remove(uint8_t nodeId)
+{
+    if (nodeId > 127 || !machines[nodeId])
+        return;
+
+    machines[nodeId] = nullptr;
+    --nodeCount;
+}
+
+StateMachine* Dispatcher::get(uint8_t nodeId) const
+{
+    if (nodeId > 127)
+        return nullptr;
+    return machines[nodeId];
+}
+
+size_t Dispatcher::getNodeCount() const
+{
+    return nodeCount;
+}
+
+void Dispatcher::setProtocolCounters(ProtocolCounters* counters)
+{
+    protocolCounters = counters;
+}
+
+StateMachine::Update Dispatcher::process(canbus::Message const& msg)
+{
+    if (isBroadcast(msg))
+        return StateMachine::Update(StateMachine::PROCESSED_IGNORED_MESSAGE);
+
+    StateMachine* machine = machines[getNodeID(msg)];
+    if (!machine) {
+        if (protocolCounters)
+            protocolCounters->add(getNodeID(msg), COUNTER_UNREGISTERED_FRAMES);
+        return StateMachine::Update(StateMachine::PROCESSED_NOT_FOR_ME);
+    }
+    return machine->process(msg);
+}
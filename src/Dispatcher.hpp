@@ -0,0 +1,95 @@
+#ifndef CANOPEN_MASTER_DISPATCHER_HPP
+#define CANOPEN_MASTER_DISPATCHER_HPP
+
+#include <canopen_master/FrameRing.hpp>
+#include <canopen_master/StateMachine.hpp>
+
+namespace canopen_master
+{
+    /** Routes received frames to the state machine of the node that sent
+     * them
+     *
+     * The lookup is a table indexed by node ID, so the cost of processing
+     * a frame does not depend on the number of nodes on the bus. State
+     * machines are not owned by the dispatcher.
+     */
+    class Dispatcher
+    {
+    public:
+        /** Size of the batches popped from a FrameRing */
+        static const size_t BATCH_SIZE = 64;
+
+        Dispatcher();
+
+        /** Register a state machine
+         *
+         * @throw std::invalid_argument if a state machine with the same
+         *   node ID is already registered
+         */
+        void add(StateMachine& machine);
+
+        /** Unregister the state machine of the given node, if there is one */
+        void remove(uint8_t nodeId);
+
+        /** The state machine of the given node, or nullptr */
+        StateMachine* get(uint8_t nodeId) const;
+
+        size_t getNodeCount() const;
+
+        /** Count the frames of unregistered nodes in the given counters
+         *
+         * See COUNTER_UNREGISTERED_FRAMES. The counters are not owned. Set
+         * to nullptr to stop counting
+         */
+        void setProtocolCounters(ProtocolCounters* counters);
+
+        /** Process a frame with the state machine of the node that sent it
+         *
+         * Broadcast frames (NMT, SYNC, TIME) are reported as
+         * PROCESSED_IGNORED_MESSAGE, frames from nodes that are not
+         * registered as PROCESSED_NOT_FOR_ME
+         */
+        StateMachine::Update process(canbus::Message const& msg);
+
+        /** Process the frames available in the ring
+         *
+         * The handler is called as handler(msg, update) for each frame.
+         * If processing a frame throws, the exception is propagated and
+         * the frames of the current batch that were not processed yet are
+         * processed by the next call.
+         *
+         * @arg maxCount the maximum number of frames to process
+         * @return the number of frames processed
+         */
+        template<typename Handler>
+        size_t process(FrameRing& ring, Handler handler,
+                       size_t maxCount = BATCH_SIZE)
+        {
+            size_t count = 0;
+            while (count < maxCount) {
+                if (batchBegin == batchEnd) {
+                    batchBegin = 0;
+                    batchEnd = ring.pop(batch, BATCH_SIZE);
+                    if (batchEnd == 0)
+                        break;
+                }
+
+                canbus::Message const& msg = batch[batchBegin++];
+                ++count;
+                handler(msg, process(msg));
+            }
+            return count;
+        }
+
+    private:
+        StateMachine* machines[128];
+        size_t nodeCount = 0;
+        ProtocolCounters* protocolCounters = nullptr;
+
+        canbus::Message batch[BATCH_SIZE];
+        size_t batchBegin = 0;
+        size_t batchEnd = 0;
+    };
+}
+
+#endif
@@ -12,4 +12,13 @@ std::string SDODomainTransferAborted::formatMessage(
         << "0x" << hex << objectId << "/" << dec << static_cast<int>(subId)
         << ", error code: " << hex << rawCode;
     return formatter.str();
-}
\ No newline at end of file
+}
+std::string LSSError::formatMessage(
+    uint8_t command, uint8_t errorCode, uint8_t specificError)
+{
+    std::ostringstream formatter;
+    formatter << "LSS command 0x" << hex << static_cast<int>(command)
+        << " failed, error code: " << dec << static_cast<int>(errorCode)
+        << ", specific error: " << static_cast<int>(specificError);
+    return formatter.str();
+}
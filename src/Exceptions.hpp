@@ -37,6 +37,17 @@ namespace canopen_master
         using std::runtime_error::runtime_error;
     };
 
+    /** A SDO transaction did not get a reply in time */
+    struct SDOTimeout : public std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct PDOPlanningFailed : public std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
     struct EmergencyMessageReceived : public std::runtime_error
     {
         const Emergency message;
@@ -74,6 +85,22 @@ namespace canopen_master
             , rawCode(rawCode) {}
     };
 
+    struct LSSError : public std::runtime_error
+    {
+        const uint8_t command;
+        const uint8_t errorCode;
+        const uint8_t specificError;
+
+        static std::string formatMessage(uint8_t command, uint8_t errorCode,
+                                         uint8_t specificError);
+
+        LSSError(uint8_t command, uint8_t errorCode, uint8_t specificError)
+            : std::runtime_error(formatMessage(command, errorCode, specificError))
+            , command(command)
+            , errorCode(errorCode)
+            , specificError(specificError) {}
+    };
+
     struct PDOMappingTooBig : public std::runtime_error
     {
         PDOMappingTooBig()
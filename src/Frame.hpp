@@ -2,6 +2,8 @@
 #define CANOPEN_MASTER_FRAME_HPP
 
 #include <canmessage.hh>
+#include <algorithm>
+#include <limits>
 
 namespace canopen_master
 {
@@ -147,6 +149,25 @@ namespace canopen_master
         uint32_t result = fromLittleEndian<uint32_t>(data);
         return reinterpret_cast<int32_t const&>(result);
     }
+
+    /** Decode a dictionary value the way StateMachine::get<T> does
+     *
+     * Signed integers are sign-extended from the size of the object
+     *
+     * @arg data the value, little-endian
+     * @arg size the object size, at most 4. Only that many bytes are read
+     */
+    template<typename T> T decodeObjectValue(uint8_t const* data, uint32_t size)
+    {
+        uint8_t buffer[4] = { 0, 0, 0, 0 };
+        size = std::min<uint32_t>(size, 4);
+        std::copy(data, data + size, buffer);
+        if (size > 0 && std::numeric_limits<T>::is_integer &&
+            std::numeric_limits<T>::is_signed && (buffer[size - 1] & 0x80)) {
+            std::fill(buffer + size, buffer + 4, 0xFF);
+        }
+        return fromLittleEndian<T>(buffer);
+    }
 }
 
 #endif
@@ -0,0 +1,100 @@
+#include <canopen_master/FrameReaderThread.hpp>
+#include <pthread.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+void canopen_master::setThreadAffinity(std::thread& thread, int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+        throw std::invalid_argument("invalid CPU " + to_string(cpu));
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+    if (error != 0) {
+        throw std::runtime_error(
+            string("failed to set the thread affinity: ") + strerror(error));
+    }
+}
+
+FrameReaderThread::FrameReaderThread(canbus::Driver& driver, FrameRing& ring)
+    : FrameReaderThread([&driver]() { return driver.read(); }, ring)
+{
+}
+
+FrameReaderThread::FrameReaderThread(ReadFunction read, FrameRing& ring)
+    : read(read)
+    , ring(ring)
+    , quit(false)
+    , readErrors(0)
+{
+}
+
+FrameReaderThread::~FrameReaderThread()
+{
+    stop();
+}
+
+void FrameReaderThread::start(int cpu)
+{
+    if (thread.joinable())
+        throw std::logic_error("the reader thread is already running");
+
+    quit = false;
+    thread = std::thread(&FrameReaderThread::run, this);
+    if (cpu < 0)
+        return;
+
+    try {
+        setThreadAffinity(thread, cpu);
+    }
+    catch(...) {
+        stop();
+        throw;
+    }
+}
+
+void FrameReaderThread::stop()
+{
+    quit = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+bool FrameReaderThread::isRunning() const
+{
+    return thread.joinable();
+}
+
+uint64_t FrameReaderThread::getReadErrorCount() const
+{
+    return readErrors.load(memory_order_relaxed);
+}
+
+void FrameReaderThread::setRecorder(FrameRecorder* recorder)
+{
+    if (thread.joinable())
+        throw std::logic_error("cannot change the recorder of a running reader thread");
+    this->recorder = recorder;
+}
+
+void FrameReaderThread::run()
+{
+    while (!quit.load(memory_order_relaxed)) {
+        canbus::Message msg;
+        try {
+            msg = read();
+        }
+        catch(std::exception const&) {
+            readErrors.fetch_add(1, memory_order_relaxed);
+            continue;
+        }
+        if (recorder)
+            recorder->record(msg);
+        ring.push(msg);
+    }
+}
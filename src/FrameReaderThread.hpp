@@ -0,0 +1,101 @@
+#ifndef CANOPEN_MASTER_FRAME_READER_THREAD_HPP
+#define CANOPEN_MASTER_FRAME_READER_THREAD_HPP
+
+#include <canbus.hh>
+#include <canopen_master/FrameRing.hpp>
+#include <canopen_master/FrameRecorder.hpp>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace canopen_master
+{
+    /** Pin a thread on the given CPU
+     *
+     * @throw std::invalid_argument if the CPU is negative or not below
+     *   CPU_SETSIZE
+     * @throw std::runtime_error if the affinity could not be set
+     */
+    void setThreadAffinity(std::thread& thread, int cpu);
+
+    /** Thread reading frames from a CAN device and queueing them in a
+     * FrameRing
+     *
+     * The protocol thread pops the frames from the ring, usually with
+     * Dispatcher::process. Writes to the device stay on the protocol
+     * thread.
+     *
+     * ~~~ cpp
+     * FrameRing ring(4096);
+     * FrameReaderThread reader(*device, ring);
+     * reader.start(2); // pinned on CPU 2
+     * while (true) {
+     *     dispatcher.process(ring, [](canbus::Message const& msg,
+     *                                 StateMachine::Update const& update) {
+     *         ...
+     *     });
+     * }
+     * ~~~
+     */
+    class FrameReaderThread
+    {
+    public:
+        /** Function returning the next received frame. It is expected to
+         * throw on timeout */
+        typedef std::function<canbus::Message()> ReadFunction;
+
+        /** Read from a canbus driver
+         *
+         * stop() waits for the pending read to return, so the driver's
+         * read timeout bounds the time it takes
+         */
+        FrameReaderThread(canbus::Driver& driver, FrameRing& ring);
+
+        /** Read using an arbitrary function */
+        FrameReaderThread(ReadFunction read, FrameRing& ring);
+
+        /** Stops the thread */
+        ~FrameReaderThread();
+
+        FrameReaderThread(FrameReaderThread const&) = delete;
+        FrameReaderThread& operator =(FrameReaderThread const&) = delete;
+
+        /** Start the thread
+         *
+         * @arg cpu the CPU on which the thread should be pinned, or -1 to
+         *   let the scheduler choose
+         * @throw std::logic_error if the thread is already running
+         * @throw std::invalid_argument if the CPU is out of range
+         * @throw std::runtime_error if the affinity could not be set
+         */
+        void start(int cpu = -1);
+
+        /** Stop the thread and wait for it to finish */
+        void stop();
+
+        bool isRunning() const;
+
+        /** Number of reads that threw, including timeouts */
+        uint64_t getReadErrorCount() const;
+
+        /** Record each received frame before it is queued
+         *
+         * The recorder is then used by the reader thread only. It must be
+         * set before start(), and outlive the thread. Pass nullptr to stop
+         * recording
+         */
+        void setRecorder(FrameRecorder* recorder);
+
+    private:
+        ReadFunction read;
+        FrameRing& ring;
+        std::thread thread;
+        std::atomic<bool> quit;
+        std::atomic<uint64_t> readErrors;
+        FrameRecorder* recorder = nullptr;
+
+        void run();
+    };
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include <canopen_master/FrameRecorder.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+using namespace canopen_master::frame_recorder;
+
+static std::runtime_error systemError(string const& message, string const& path)
+{
+    return std::runtime_error(message + " " + path + ": " + strerror(errno));
+}
+
+canbus::Message FrameRecord::toMessage() const
+{
+    canbus::Message msg = canbus::Message::Zeroed();
+    msg.time = toTime(time);
+    msg.can_id = canId;
+    msg.size = size;
+    memcpy(msg.data, data, 8);
+    return msg;
+}
+
+FrameRecorder::FrameRecorder(string const& path, size_t capacity)
+    : capacity(capacity)
+    , mappingSize(HEADER_SIZE + capacity * sizeof(FrameRecord))
+{
+    if (capacity == 0)
+        throw std::invalid_argument("the recorder capacity must not be zero");
+
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (fd == -1)
+        throw systemError("failed to create", path);
+    // Allocate the blocks now, so that writing to the mapping never fails
+    int error = posix_fallocate(fd, 0, mappingSize);
+    if (error != 0) {
+        close(fd);
+        errno = error;
+        throw systemError("failed to allocate", path);
+    }
+    // Prefault the pages so that the first pass on the ring does not
+    // page-fault on the RX path
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw systemError("failed to map", path);
+
+    header = new(mapping) Header;
+    header->version = VERSION;
+    header->recordSize = sizeof(FrameRecord);
+    header->reserved = 0;
+    header->capacity = capacity;
+    header->recordCount.store(0, memory_order_relaxed);
+    header->magic = MAGIC;
+    records = reinterpret_cast<FrameRecord*>(static_cast<uint8_t*>(mapping) + HEADER_SIZE);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    munmap(mapping, mappingSize);
+}
+
+size_t FrameRecorder::getCapacityFor(base::Time const& duration, double framesPerSecond)
+{
+    return ceil(duration.toSeconds() * framesPerSecond);
+}
+
+size_t FrameRecorder::getCapacity() const
+{
+    return capacity;
+}
+
+uint64_t FrameRecorder::getRecordCount() const
+{
+    return count;
+}
+
+void FrameRecorder::record(canbus::Message const& msg, uint8_t flags)
+{
+    FrameRecord record;
+    record.sequence = count + 1;
+    record.time = msg.time.isNull() ? 0 : toTimestamp(msg.time);
+    record.canId = msg.can_id;
+    record.size = msg.size;
+    record.flags = flags;
+    record.reserved[0] = 0;
+    record.reserved[1] = 0;
+    memcpy(record.data, msg.data, 8);
+    records[next] = record;
+
+    ++count;
+    if (++next == capacity)
+        next = 0;
+    // The record is complete in the file before it is counted
+    header->recordCount.store(count, memory_order_release);
+}
+
+void FrameRecorder::flush()
+{
+    msync(mapping, mappingSize, MS_ASYNC);
+}
+
+FrameRecordReader::FrameRecordReader(string const& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw systemError("failed to open", path);
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw systemError("failed to stat", path);
+    }
+    mappingSize = info.st_size;
+    if (mappingSize < HEADER_SIZE) {
+        close(fd);
+        throw std::runtime_error(path + " is not a frame recording");
+    }
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw systemError("failed to map", path);
+
+    header = static_cast<Header const*>(mapping);
+    records = reinterpret_cast<FrameRecord const*>(
+        static_cast<uint8_t const*>(mapping) + HEADER_SIZE);
+    capacity = header->capacity;
+    if (header->magic != MAGIC || header->version != VERSION ||
+        header->recordSize != sizeof(FrameRecord) || capacity == 0 ||
+        mappingSize < HEADER_SIZE + capacity * sizeof(FrameRecord)) {
+        munmap(mapping, mappingSize);
+        throw std::runtime_error(path + " is not a frame recording with the "
+                                 "layout of this library version");
+    }
+}
+
+FrameRecordReader::~FrameRecordReader()
+{
+    munmap(mapping, mappingSize);
+}
+
+size_t FrameRecordReader::getCapacity() const
+{
+    return capacity;
+}
+
+uint64_t FrameRecordReader::getRecordCount() const
+{
+    return header->recordCount.load(memory_order_acquire);
+}
+
+size_t FrameRecordReader::size() const
+{
+    return min<uint64_t>(getRecordCount(), capacity);
+}
+
+FrameRecord FrameRecordReader::get(size_t index) const
+{
+    uint64_t count = getRecordCount();
+    size_t available = min<uint64_t>(count, capacity);
+    if (index >= available)
+        throw std::out_of_range("no such record");
+
+    uint64_t sequence = count - available + index + 1;
+    FrameRecord record = records[(sequence - 1) % capacity];
+    if (record.sequence != sequence)
+        throw std::runtime_error("frame record corrupted or overwritten");
+    return record;
+}
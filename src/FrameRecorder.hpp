@@ -0,0 +1,159 @@
+#ifndef CANOPEN_MASTER_FRAME_RECORDER_HPP
+#define CANOPEN_MASTER_FRAME_RECORDER_HPP
+
+#include <canmessage.hh>
+#include <canopen_master/Clock.hpp>
+#include <atomic>
+#include <string>
+
+namespace canopen_master
+{
+    enum FRAME_RECORD_FLAGS {
+        /** The frame has been sent by the master */
+        FRAME_RECORD_TRANSMITTED = 0x01
+    };
+
+    /** A frame in a recording, as stored in the file
+     *
+     * The layout is fixed and does not depend on the compiler. Fields are
+     * in host byte order
+     */
+    struct FrameRecord
+    {
+        /** Position of the record in the recording, starting at 1 */
+        uint64_t sequence;
+        /** Reception time of the frame, see Timestamp */
+        int64_t time;
+        uint32_t canId;
+        uint8_t size;
+        /** Combination of FRAME_RECORD_FLAGS */
+        uint8_t flags;
+        uint8_t reserved[2];
+        uint8_t data[8];
+
+        canbus::Message toMessage() const;
+    };
+    static_assert(sizeof(FrameRecord) == 32, "unexpected FrameRecord size");
+
+    namespace frame_recorder
+    {
+        static const uint32_t MAGIC = 0x434f5246; // "CORF"
+        /** Incremented on each incompatible layout change */
+        static const uint32_t VERSION = 1;
+
+        /** File header. Records follow at HEADER_SIZE */
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t recordSize;
+            uint32_t reserved;
+            uint64_t capacity;
+            /** Number of records written since the file was created. The
+             * last min(recordCount, capacity) records are in the file */
+            std::atomic<uint64_t> recordCount;
+        };
+
+        static const size_t HEADER_SIZE = 64;
+        static_assert(sizeof(Header) <= HEADER_SIZE, "header too big");
+    }
+
+    /** Recording of all frames in a memory-mapped ring file
+     *
+     * The file is preallocated and mapped when the recorder is created, so
+     * record() is a copy of the frame into the mapping: it does no system
+     * call and does not format anything. The file holds the last
+     * getCapacity() frames. Since the kernel owns the mapped pages, they
+     * end up on disk even if the process crashes.
+     *
+     * Read recordings with FrameRecordReader. record() must be called
+     * from a single thread, e.g. the one reading the CAN device (see
+     * FrameReaderThread::setRecorder)
+     */
+    class FrameRecorder
+    {
+    public:
+        /** Create the recording file, replacing any existing file
+         *
+         * @arg capacity the number of frames in the ring, see
+         *   getCapacityFor
+         * @throw std::runtime_error if the file cannot be created
+         */
+        FrameRecorder(std::string const& path, size_t capacity);
+
+        /** Unmaps the file. The data stays in the file */
+        ~FrameRecorder();
+
+        FrameRecorder(FrameRecorder const&) = delete;
+        FrameRecorder& operator =(FrameRecorder const&) = delete;
+
+        /** Capacity needed to keep the given duration of traffic */
+        static size_t getCapacityFor(base::Time const& duration,
+                                     double framesPerSecond);
+
+        size_t getCapacity() const;
+
+        /** Number of frames recorded so far */
+        uint64_t getRecordCount() const;
+
+        /** Append a frame to the ring
+         *
+         * @arg flags combination of FRAME_RECORD_FLAGS
+         */
+        void record(canbus::Message const& msg, uint8_t flags = 0);
+
+        /** Ask the kernel to start writing the recording to disk
+         *
+         * This is only needed to survive a system crash, not a crash of
+         * the process. It does not wait for the write to finish
+         */
+        void flush();
+
+    private:
+        size_t capacity;
+        size_t mappingSize;
+        void* mapping;
+        frame_recorder::Header* header;
+        FrameRecord* records;
+        uint64_t count = 0;
+        size_t next = 0;
+    };
+
+    /** Read access to a recording made by FrameRecorder */
+    class FrameRecordReader
+    {
+    public:
+        /** @throw std::runtime_error if the file cannot be read or is not
+         *   a recording with the layout of this library version */
+        explicit FrameRecordReader(std::string const& path);
+        ~FrameRecordReader();
+
+        FrameRecordReader(FrameRecordReader const&) = delete;
+        FrameRecordReader& operator =(FrameRecordReader const&) = delete;
+
+        size_t getCapacity() const;
+
+        /** Number of frames recorded, including the ones overwritten */
+        uint64_t getRecordCount() const;
+
+        /** Number of frames available in the file */
+        size_t size() const;
+
+        /** Get a record, from the oldest (0) to the newest (size() - 1)
+         *
+         * @throw std::out_of_range if index >= size()
+         * @throw std::runtime_error if the record is corrupted, or has been
+         *   overwritten by a recorder still writing the file
+         */
+        FrameRecord get(size_t index) const;
+
+    private:
+        size_t capacity;
+        size_t mappingSize;
+        void* mapping;
+        frame_recorder::Header const* header;
+        FrameRecord const* records;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include <canopen_master/FrameRing.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+FrameRing::FrameRing(size_t capacity)
+    : head(0)
+    , tail(0)
+    , overflows(0)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("the ring capacity must be strictly positive");
+
+    buffer.resize(roundUpToPowerOfTwo(capacity));
+    mask = buffer.size() - 1;
+}
+
+size_t FrameRing::getCapacity() const
+{
+    return buffer.size();
+}
+
+bool FrameRing::push(canbus::Message const& msg)
+{
+    uint64_t currentTail = tail.load(memory_order_relaxed);
+    if (currentTail - cachedHead == buffer.size()) {
+        cachedHead = head.load(memory_order_acquire);
+        if (currentTail - cachedHead == buffer.size()) {
+            overflows.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    buffer[currentTail & mask] = msg;
+    tail.store(currentTail + 1, memory_order_release);
+    return true;
+}
+
+bool FrameRing::pop(canbus::Message& msg)
+{
+    return pop(&msg, 1) == 1;
+}
+
+size_t FrameRing::pop(canbus::Message* messages, size_t maxCount)
+{
+    uint64_t currentHead = head.load(memory_order_relaxed);
+    if (cachedTail - currentHead < maxCount)
+        cachedTail = tail.load(memory_order_acquire);
+
+    size_t count = min<uint64_t>(cachedTail - currentHead, maxCount);
+    for (size_t i = 0; i < count; ++i)
+        messages[i] = buffer[(currentHead + i) & mask];
+    head.store(currentHead + count, memory_order_release);
+    return count;
+}
+
+size_t FrameRing::size() const
+{
+    uint64_t currentHead = head.load(memory_order_acquire);
+    return tail.load(memory_order_acquire) - currentHead;
+}
+
+bool FrameRing::empty() const
+{
+    return size() == 0;
+}
+
+uint64_t FrameRing::getPushCount() const
+{
+    return tail.load(memory_order_relaxed);
+}
+
+uint64_t FrameRing::getOverflowCount() const
+{
+    return overflows.load(memory_order_relaxed);
+}
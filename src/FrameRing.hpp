@@ -0,0 +1,121 @@
+#ifndef CANOPEN_MASTER_FRAME_RING_HPP
+#define CANOPEN_MASTER_FRAME_RING_HPP
+
+#include <canmessage.hh>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Bounded lock-free queue of frames between a single producer thread
+     * and a single consumer thread
+     *
+     * It is meant to decouple the thread reading the CAN device from the
+     * thread processing the frames (see FrameReaderThread), so that a slow
+     * consumer does not delay reception. When the ring is full, new frames
+     * are dropped and counted in getOverflowCount().
+     *
+     * push is called only by the producer, pop only by the consumer. All
+     * other methods can be called from any thread.
+     */
+    class FrameRing
+    {
+    public:
+        /** @arg capacity the ring capacity, rounded up to a power of two */
+        explicit FrameRing(size_t capacity = 1024);
+
+        FrameRing(FrameRing const&) = delete;
+        FrameRing& operator =(FrameRing const&) = delete;
+
+        size_t getCapacity() const;
+
+        /** Queue a frame
+         *
+         * @return false if the ring is full, in which case the frame is
+         *   dropped
+         */
+        bool push(canbus::Message const& msg);
+
+        /** Dequeue the oldest frame
+         *
+         * @return false if the ring is empty
+         */
+        bool pop(canbus::Message& msg);
+
+        /** Dequeue up to maxCount frames, oldest first
+         *
+         * @return the number of frames written in messages
+         */
+        size_t pop(canbus::Message* messages, size_t maxCount);
+
+        /** Number of frames currently in the ring */
+        size_t size() const;
+
+        bool empty() const;
+
+        /** Number of frames queued since construction */
+        uint64_t getPushCount() const;
+
+        /** Number of frames dropped because the ring was full */
+        uint64_t getOverflowCount() const;
+
+    private:
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        std::vector<canbus::Message> buffer;
+        size_t mask;
+
+        /** Written by the consumer only */
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+        /** Written by the producer only */
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> overflows;
+        /** Producer-side copy of head, refreshed only when the ring looks
+         * full, to avoid reading the consumer's cache line on every push */
+        uint64_t cachedHead = 0;
+        /** Consumer-side copy of tail */
+        alignas(CACHE_LINE_SIZE) uint64_t cachedTail = 0;
+    };
+
+    /** Deleter of the objects created with makeAligned */
+    struct AlignedDelete
+    {
+        template<typename T>
+        void operator ()(T* object) const
+        {
+            object->~T();
+            std::free(object);
+        }
+    };
+
+    template<typename T>
+    using AlignedPtr = std::unique_ptr<T, AlignedDelete>;
+
+    /** Create an object on the heap with the alignment of its type
+     *
+     * new does not honor alignas in C++11. Use this for objects that embed
+     * a FrameRing, whose indices must be on their own cache lines
+     */
+    template<typename T, typename... Args>
+    AlignedPtr<T> makeAligned(Args&&... args)
+    {
+        void* memory;
+        if (posix_memalign(&memory, alignof(T), sizeof(T)))
+            throw std::bad_alloc();
+        try {
+            return AlignedPtr<T>(new(memory) T(std::forward<Args>(args)...));
+        }
+        catch(...) {
+            std::free(memory);
+            throw;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,203 @@
+#include <canopen_master/LSS.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <algorithm>
+
+using namespace std;
+using namespace canopen_master;
+
+static canbus::Message makeLSSMessage(uint8_t command)
+{
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = LSS_MASTER_TO_SLAVE;
+    msg.size = 8;
+    msg.data[0] = command;
+    return msg;
+}
+
+bool LSSAddress::operator ==(LSSAddress const& other) const
+{
+    return equal(id, id + 4, other.id);
+}
+
+canbus::Message canopen_master::makeLSSSwitchStateGlobal(LSS_MODE mode)
+{
+    auto msg = makeLSSMessage(LSS_SWITCH_STATE_GLOBAL);
+    msg.data[1] = mode;
+    return msg;
+}
+
+vector<canbus::Message> canopen_master::makeLSSSwitchStateSelective(
+    LSSAddress const& address)
+{
+    vector<canbus::Message> messages;
+    for (int i = 0; i < 4; ++i) {
+        auto msg = makeLSSMessage(LSS_SWITCH_STATE_SELECTIVE_VENDOR + i);
+        toLittleEndian<uint32_t>(msg.data + 1, address.id[i]);
+        messages.push_back(msg);
+    }
+    return messages;
+}
+
+canbus::Message canopen_master::makeLSSConfigureNodeID(uint8_t nodeId)
+{
+    if ((nodeId == 0 || nodeId > 127) && nodeId != LSS_UNCONFIGURED_NODE_ID)
+        throw std::invalid_argument("invalid node ID");
+    auto msg = makeLSSMessage(LSS_CONFIGURE_NODE_ID);
+    msg.data[1] = nodeId;
+    return msg;
+}
+
+canbus::Message canopen_master::makeLSSStoreConfiguration()
+{
+    return makeLSSMessage(LSS_STORE_CONFIGURATION);
+}
+
+canbus::Message canopen_master::makeLSSInquire(LSS_COMMANDS command)
+{
+    if (command < LSS_INQUIRE_VENDOR || command > LSS_INQUIRE_NODE_ID)
+        throw std::invalid_argument("not a LSS inquire command");
+    return makeLSSMessage(command);
+}
+
+canbus::Message canopen_master::makeLSSFastscan(uint32_t idNumber, uint8_t bitChecked,
+                                                uint8_t lssSub, uint8_t lssNext)
+{
+    auto msg = makeLSSMessage(LSS_FASTSCAN);
+    toLittleEndian<uint32_t>(msg.data + 1, idNumber);
+    msg.data[5] = bitChecked;
+    msg.data[6] = lssSub;
+    msg.data[7] = lssNext;
+    return msg;
+}
+
+bool canopen_master::isLSSReply(canbus::Message const& msg, LSS_COMMANDS command)
+{
+    return msg.can_id == LSS_SLAVE_TO_MASTER && msg.size >= 1 &&
+        msg.data[0] == command;
+}
+
+void canopen_master::parseLSSConfigurationReply(canbus::Message const& msg)
+{
+    if (msg.can_id != LSS_SLAVE_TO_MASTER)
+        throw std::invalid_argument("expected a LSS reply");
+    if (msg.data[1] != 0)
+        throw LSSError(msg.data[0], msg.data[1], msg.data[2]);
+}
+
+uint32_t canopen_master::parseLSSInquireReply(canbus::Message const& msg)
+{
+    if (msg.can_id != LSS_SLAVE_TO_MASTER ||
+        msg.data[0] < LSS_INQUIRE_VENDOR || msg.data[0] > LSS_INQUIRE_NODE_ID)
+        throw std::invalid_argument("expected a LSS inquire reply");
+    if (msg.data[0] == LSS_INQUIRE_NODE_ID)
+        return msg.data[1];
+    return fromLittleEndian<uint32_t>(msg.data + 1);
+}
+
+LSSFastscan::LSSFastscan()
+{
+    reset();
+}
+
+void LSSFastscan::reset()
+{
+    state = CHECK_UNCONFIGURED;
+    fill(address.id, address.id + 4, 0);
+    lssSub = 0;
+    bitChecked = 31;
+    queryCount = 0;
+}
+
+canbus::Message LSSFastscan::getQuery() const
+{
+    switch (state) {
+        case CHECK_UNCONFIGURED:
+            return makeLSSFastscan(0, 0x80, 0, 0);
+        case SCAN_BIT:
+            return makeLSSFastscan(address.id[lssSub], bitChecked, lssSub, lssSub);
+        case VERIFY:
+            return makeLSSFastscan(address.id[lssSub], 0, lssSub, (lssSub + 1) % 4);
+        default:
+            throw std::logic_error("fastscan is finished");
+    }
+}
+
+void LSSFastscan::nextBit()
+{
+    if (bitChecked == 0)
+        state = VERIFY;
+    else
+        --bitChecked;
+}
+
+void LSSFastscan::processReply()
+{
+    ++queryCount;
+    switch (state) {
+        case CHECK_UNCONFIGURED:
+            state = SCAN_BIT;
+            break;
+        case SCAN_BIT:
+            // A slave matched with the bit at zero
+            nextBit();
+            break;
+        case VERIFY:
+            if (lssSub == 3) {
+                state = FOUND;
+            }
+            else {
+                ++lssSub;
+                bitChecked = 31;
+                state = SCAN_BIT;
+            }
+            break;
+        default:
+            throw std::logic_error("fastscan is finished");
+    }
+}
+
+void LSSFastscan::processTimeout()
+{
+    ++queryCount;
+    switch (state) {
+        case CHECK_UNCONFIGURED:
+            state = NOT_FOUND;
+            break;
+        case SCAN_BIT:
+            // No slave matched with the bit at zero, so it's a one
+            address.id[lssSub] |= (1u << bitChecked);
+            nextBit();
+            break;
+        case VERIFY:
+            // The slave that was being scanned disappeared
+            state = NOT_FOUND;
+            break;
+        default:
+            throw std::logic_error("fastscan is finished");
+    }
+}
+
+bool LSSFastscan::isFinished() const
+{
+    return state == FOUND || state == NOT_FOUND;
+}
+
+bool LSSFastscan::hasFoundSlave() const
+{
+    return state == FOUND;
+}
+
+LSSAddress LSSFastscan::getAddress() const
+{
+    return address;
+}
+
+size_t LSSFastscan::getQueryCount() const
+{
+    return queryCount;
+}
+
+bool LSSFastscan::isReply(canbus::Message const& msg)
+{
+    return isLSSReply(msg, LSS_IDENTIFY_SLAVE);
+}
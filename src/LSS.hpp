@@ -0,0 +1,166 @@
+#ifndef CANOPEN_MASTER_LSS_HPP
+#define CANOPEN_MASTER_LSS_HPP
+
+#include <canopen_master/Frame.hpp>
+#include <vector>
+
+namespace canopen_master
+{
+    /** COB-IDs used by the CiA 305 Layer Setting Services */
+    enum LSS_COB_IDS
+    {
+        LSS_MASTER_TO_SLAVE = 0x7E5,
+        LSS_SLAVE_TO_MASTER = 0x7E4
+    };
+
+    /** LSS command specifiers */
+    enum LSS_COMMANDS
+    {
+        LSS_SWITCH_STATE_GLOBAL = 0x04,
+        LSS_CONFIGURE_NODE_ID = 0x11,
+        LSS_CONFIGURE_BIT_TIMING = 0x13,
+        LSS_ACTIVATE_BIT_TIMING = 0x15,
+        LSS_STORE_CONFIGURATION = 0x17,
+        LSS_SWITCH_STATE_SELECTIVE_VENDOR = 0x40,
+        LSS_SWITCH_STATE_SELECTIVE_PRODUCT = 0x41,
+        LSS_SWITCH_STATE_SELECTIVE_REVISION = 0x42,
+        LSS_SWITCH_STATE_SELECTIVE_SERIAL = 0x43,
+        LSS_SWITCH_STATE_SELECTIVE_REPLY = 0x44,
+        LSS_IDENTIFY_NON_CONFIGURED_SLAVE = 0x4C,
+        LSS_IDENTIFY_SLAVE = 0x4F,
+        LSS_IDENTIFY_NON_CONFIGURED_SLAVE_REPLY = 0x50,
+        LSS_FASTSCAN = 0x51,
+        LSS_INQUIRE_VENDOR = 0x5A,
+        LSS_INQUIRE_PRODUCT = 0x5B,
+        LSS_INQUIRE_REVISION = 0x5C,
+        LSS_INQUIRE_SERIAL = 0x5D,
+        LSS_INQUIRE_NODE_ID = 0x5E
+    };
+
+    enum LSS_MODE
+    {
+        LSS_WAITING = 0,
+        LSS_CONFIGURATION = 1
+    };
+
+    /** Node ID of a LSS slave whose node ID has not been configured */
+    static const uint8_t LSS_UNCONFIGURED_NODE_ID = 0xFF;
+
+    /** The LSS address of a device, i.e. its identity object (0x1018) */
+    struct LSSAddress
+    {
+        /** Vendor ID, product code, revision number and serial number */
+        uint32_t id[4];
+
+        uint32_t getVendorID() const { return id[0]; }
+        uint32_t getProductCode() const { return id[1]; }
+        uint32_t getRevisionNumber() const { return id[2]; }
+        uint32_t getSerialNumber() const { return id[3]; }
+
+        bool operator ==(LSSAddress const& other) const;
+    };
+
+    canbus::Message makeLSSSwitchStateGlobal(LSS_MODE mode);
+    /** The four messages that switch the matching slave into configuration
+     * mode. The last one is acked with LSS_SWITCH_STATE_SELECTIVE_REPLY */
+    std::vector<canbus::Message> makeLSSSwitchStateSelective(LSSAddress const& address);
+    canbus::Message makeLSSConfigureNodeID(uint8_t nodeId);
+    canbus::Message makeLSSStoreConfiguration();
+    canbus::Message makeLSSInquire(LSS_COMMANDS command);
+    canbus::Message makeLSSFastscan(uint32_t idNumber, uint8_t bitChecked,
+                                    uint8_t lssSub, uint8_t lssNext);
+
+    /** Whether the message is a LSS reply with the given command specifier */
+    bool isLSSReply(canbus::Message const& msg, LSS_COMMANDS command);
+
+    /** Validate the reply to a configuration command (configure node ID,
+     * bit timing or store configuration)
+     *
+     * @throw LSSError if the slave reported an error
+     */
+    void parseLSSConfigurationReply(canbus::Message const& msg);
+
+    /** Return the value of a reply to makeLSSInquire */
+    uint32_t parseLSSInquireReply(canbus::Message const& msg);
+
+    /** Implementation of the CiA 305 Fastscan protocol
+     *
+     * Fastscan finds the LSS address of one unconfigured slave by
+     * determining it one bit at a time, in about 130 queries. At the end
+     * of a successful scan, the slave is in configuration mode, ready to
+     * receive e.g. makeLSSConfigureNodeID.
+     *
+     * The general process is:
+     *
+     * ~~~ cpp
+     * LSSFastscan scan;
+     * while (!scan.isFinished()) {
+     *     driver.write(scan.getQuery());
+     *     if (waitForReply(LSSFastscan::isReply, timeout))
+     *         scan.processReply();
+     *     else
+     *         scan.processTimeout();
+     * }
+     * if (scan.hasFoundSlave())
+     *     ...
+     * ~~~
+     *
+     * Since Fastscan relies on timeouts to detect that no slave answered,
+     * the timeout must be higher than the slaves' response time. It is
+     * usually in the 10ms range.
+     */
+    class LSSFastscan
+    {
+    public:
+        LSSFastscan();
+
+        /** Restart the scan */
+        void reset();
+
+        /** The query that should be sent next */
+        canbus::Message getQuery() const;
+
+        /** Declare that a reply to the last query (as detected by isReply)
+         * has been received */
+        void processReply();
+
+        /** Declare that no reply to the last query has been received */
+        void processTimeout();
+
+        /** Whether the scan is finished */
+        bool isFinished() const;
+
+        /** Whether a slave has been found and switched to configuration
+         * mode */
+        bool hasFoundSlave() const;
+
+        /** The LSS address of the slave that has been found */
+        LSSAddress getAddress() const;
+
+        /** How many queries have been answered so far */
+        size_t getQueryCount() const;
+
+        /** Whether the message is a reply to a fastscan query */
+        static bool isReply(canbus::Message const& msg);
+
+    private:
+        enum STATE
+        {
+            CHECK_UNCONFIGURED,
+            SCAN_BIT,
+            VERIFY,
+            FOUND,
+            NOT_FOUND
+        };
+
+        STATE state;
+        LSSAddress address;
+        uint8_t lssSub;
+        uint8_t bitChecked;
+        size_t queryCount;
+
+        void nextBit();
+    };
+}
+
+#endif
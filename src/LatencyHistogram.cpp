@@ -0,0 +1,135 @@
+#include <canopen_master/LatencyHistogram.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace canopen_master;
+
+const int LatencyHistogram::SUB_BUCKET_BITS;
+const int LatencyHistogram::SUB_BUCKET_COUNT;
+const int LatencyHistogram::MAX_BITS;
+const int LatencyHistogram::BUCKET_COUNT;
+
+static const uint64_t MAX_DURATION = (static_cast<uint64_t>(1) << LatencyHistogram::MAX_BITS) - 1;
+
+LatencyHistogram::LatencyHistogram()
+    : count(0)
+    , sum(0)
+    , min(numeric_limits<uint64_t>::max())
+    , max(0)
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, memory_order_relaxed);
+}
+
+LatencyHistogram::LatencyHistogram(LatencyHistogram const& other)
+{
+    *this = other;
+}
+
+LatencyHistogram& LatencyHistogram::operator =(LatencyHistogram const& other)
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+        buckets[i].store(other.buckets[i].load(memory_order_relaxed), memory_order_relaxed);
+    count.store(other.count.load(memory_order_relaxed), memory_order_relaxed);
+    sum.store(other.sum.load(memory_order_relaxed), memory_order_relaxed);
+    min.store(other.min.load(memory_order_relaxed), memory_order_relaxed);
+    max.store(other.max.load(memory_order_relaxed), memory_order_relaxed);
+    return *this;
+}
+
+int LatencyHistogram::getBucketIndex(uint64_t microseconds)
+{
+    uint64_t value = std::min(microseconds, MAX_DURATION);
+    if (value < SUB_BUCKET_COUNT)
+        return value;
+
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + (value >> shift) - SUB_BUCKET_COUNT;
+}
+
+uint64_t LatencyHistogram::getBucketLowerBound(int bucket)
+{
+    if (bucket < SUB_BUCKET_COUNT)
+        return bucket;
+
+    int shift = bucket / SUB_BUCKET_COUNT - 1;
+    uint64_t subBucket = bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return subBucket << shift;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(int bucket)
+{
+    if (bucket < SUB_BUCKET_COUNT)
+        return bucket;
+
+    int shift = bucket / SUB_BUCKET_COUNT - 1;
+    return getBucketLowerBound(bucket) + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(base::Time const& duration)
+{
+    int64_t microseconds = duration.toMicroseconds();
+    uint64_t value = std::min<uint64_t>(std::max<int64_t>(microseconds, 0), MAX_DURATION);
+
+    // Single writer, plain loads and stores are enough
+    std::atomic<uint32_t>& bucket = buckets[getBucketIndex(value)];
+    bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    count.store(count.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    sum.store(sum.load(memory_order_relaxed) + value, memory_order_relaxed);
+    if (value < min.load(memory_order_relaxed))
+        min.store(value, memory_order_relaxed);
+    if (value > max.load(memory_order_relaxed))
+        max.store(value, memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return count.load(memory_order_relaxed);
+}
+
+base::Time LatencyHistogram::getMin() const
+{
+    if (getCount() == 0)
+        return base::Time();
+    return base::Time::fromMicroseconds(min.load(memory_order_relaxed));
+}
+
+base::Time LatencyHistogram::getMax() const
+{
+    return base::Time::fromMicroseconds(max.load(memory_order_relaxed));
+}
+
+base::Time LatencyHistogram::getMean() const
+{
+    uint64_t samples = getCount();
+    if (samples == 0)
+        return base::Time();
+    return base::Time::fromMicroseconds(sum.load(memory_order_relaxed) / samples);
+}
+
+base::Time LatencyHistogram::getPercentile(double fraction) const
+{
+    uint64_t samples = getCount();
+    if (samples == 0)
+        return base::Time();
+
+    uint64_t rank = std::max<uint64_t>(1, ceil(std::min(fraction, 1.0) * samples));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t bound = std::min(getBucketUpperBound(i),
+                                      max.load(memory_order_relaxed));
+            return base::Time::fromMicroseconds(bound);
+        }
+    }
+    return getMax();
+}
+
+uint32_t LatencyHistogram::getBucketValue(int bucket) const
+{
+    return buckets[bucket].load(memory_order_relaxed);
+}
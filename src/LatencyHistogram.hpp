@@ -0,0 +1,80 @@
+#ifndef CANOPEN_MASTER_LATENCY_HISTOGRAM_HPP
+#define CANOPEN_MASTER_LATENCY_HISTOGRAM_HPP
+
+#include <base/Time.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace canopen_master
+{
+    /** Histogram of durations with a bounded relative error
+     *
+     * Buckets are linear up to 2^SUB_BUCKET_BITS microseconds, and then
+     * each power of two is divided in 2^SUB_BUCKET_BITS buckets, so that
+     * the width of a bucket is at most 1/32 of its values (HdrHistogram's
+     * layout). Durations are clamped to [0, 2^32[ microseconds.
+     *
+     * Recording is a constant-time update of a fixed array, and never
+     * allocates. Counters are atomics written by a single thread: the
+     * histogram can be read from another thread, e.g. by a monitoring
+     * scraper, although the counters of a concurrent read may be off by
+     * the samples recorded meanwhile.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static const int SUB_BUCKET_BITS = 5;
+        static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+        static const int MAX_BITS = 32;
+        static const int BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+        LatencyHistogram();
+        LatencyHistogram(LatencyHistogram const& other);
+        LatencyHistogram& operator =(LatencyHistogram const& other);
+
+        /** Add a sample */
+        void record(base::Time const& duration);
+
+        /** Number of samples */
+        uint64_t getCount() const;
+
+        /** Smallest sample, null if there are none */
+        base::Time getMin() const;
+
+        /** Largest sample, null if there are none */
+        base::Time getMax() const;
+
+        /** Mean of the samples, null if there are none */
+        base::Time getMean() const;
+
+        /** The duration below which the given fraction of the samples are
+         *
+         * This is the upper bound of the bucket of the sample at this
+         * rank, i.e. at most 1/32 above the actual sample
+         *
+         * @arg fraction between 0 and 1, e.g. 0.99 for the 99th percentile
+         */
+        base::Time getPercentile(double fraction) const;
+
+        /** Number of samples in a bucket */
+        uint32_t getBucketValue(int bucket) const;
+
+        /** Smallest duration counted by a bucket, in microseconds */
+        static uint64_t getBucketLowerBound(int bucket);
+
+        /** Largest duration counted by a bucket, in microseconds */
+        static uint64_t getBucketUpperBound(int bucket);
+
+        /** Index of the bucket that counts a duration in microseconds */
+        static int getBucketIndex(uint64_t microseconds);
+
+    private:
+        std::atomic<uint32_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+    };
+}
+
+#endif
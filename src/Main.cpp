@@ -3,8 +3,15 @@
 #include <memory>
 #include <iodrivers_base/Driver.hpp>
 #include <canopen_master/StateMachine.hpp>
+#include <canopen_master/TimeStamp.hpp>
+#include <canopen_master/LSS.hpp>
+#include <canopen_master/NMT.hpp>
+#include <canopen_master/Reactor.hpp>
+#include <canopen_master/Replay.hpp>
 #include <string>
 #include <iomanip>
+#include <chrono>
+#include <vector>
 #include <stdexcept>
 
 using namespace std;
@@ -23,7 +30,20 @@ int usage()
     cout << "  sdo-get ID SUB_ID # get a SDO object\n";
     cout << "  sdo-set ID SUB_ID B0 B1 B2 B3 # set a SDO object,\n";
     cout << "        bytes are in hex as e.g. FF\n";
+    cout << "  sync # send a SYNC message\n";
+    cout << "  monitor SYNC_PERIOD_MS # send SYNCs periodically and display the node\n";
+    cout << "        state at each heartbeat, until interrupted\n";
+    cout << "  time [PERIOD_MS] # broadcast the host time in a TIME message, once\n";
+    cout << "        or periodically until interrupted\n";
     cout << "  read # read one CAN message and display it\n";
+    cout << "  lss-assign # assign node IDs to all unconfigured LSS slaves,\n";
+    cout << "        starting at CAN_ID\n";
+    cout << "\n";
+    cout << "canopen_ctl replay LOG [--speed FACTOR] [--at SECONDS] [ID SUB_ID]...\n";
+    cout << "  replay a FrameRecorder recording or candump log, and display the state\n";
+    cout << "  of each node and the given objects SECONDS after the start of the log.\n";
+    cout << "  The log is replayed as fast as possible unless a speed relative to\n";
+    cout << "  the recorded rate is given\n";
     cout << endl;
     return 1;
 }
@@ -89,8 +109,108 @@ struct DisplayStats
     }
 };
 
+/** Wait for a LSS reply with the given command specifier
+ *
+ * @return false if none arrived within the device read timeout
+ */
+bool waitLSSReply(canbus::Driver& device, LSS_COMMANDS command, canbus::Message& reply)
+{
+    while (true) {
+        try { reply = device.read(); }
+        catch(std::runtime_error const&) { return false; }
+        if (isLSSReply(reply, command))
+            return true;
+    }
+}
+
+/** Process the frames of the device until done returns true
+ *
+ * @throw std::runtime_error if it does not within the timeout
+ */
+template<typename F>
+void processUntil(Reactor& reactor, canbus::Driver& device, Dispatcher& dispatcher,
+                  base::Time const& timeout, F done)
+{
+    bool finished = false;
+    int timer = reactor.addTimer(timeout, base::Time(), [&]() { reactor.stop(); });
+    reactor.watch(device, dispatcher, [&](canbus::Message const&,
+                                          StateMachine::Update const& update) {
+        if (!finished && done(update)) {
+            finished = true;
+            reactor.stop();
+        }
+    });
+    reactor.run();
+    reactor.unwatch(device.getFileDescriptor());
+    reactor.removeTimer(timer);
+    if (!finished)
+        throw std::runtime_error("timed out waiting for the node's reply");
+}
+
+int replay(int argc, char** argv)
+{
+    auto log = ReplayLog::open(argv[2]);
+    Replay replay(*log);
+
+    double speed = 0;
+    base::Time until = base::Time::max();
+    vector<pair<uint16_t, uint8_t>> objects;
+    for (int i = 3; i < argc; i += 2) {
+        if (i + 1 == argc)
+            return usage();
+
+        string arg(argv[i]);
+        if (arg == "--speed")
+            speed = stod(argv[i + 1]);
+        else if (arg == "--at") {
+            until = replay.getStartTime() +
+                base::Time::fromMicroseconds(stod(argv[i + 1]) * 1e6);
+        }
+        else {
+            objects.push_back(make_pair(std::stol(argv[i], nullptr, 16),
+                                        stoi(argv[i + 1])));
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    uint64_t count = replay.run(speed, until);
+    chrono::duration<double> duration = chrono::steady_clock::now() - start;
+    std::cerr << "replayed " << count << " frames in " << duration.count() << "s, "
+              << replay.getErrorCount() << " errors" << std::endl;
+
+    for (int nodeId = 1; nodeId < 128; ++nodeId) {
+        StateMachine* node = replay.getNode(nodeId);
+        if (!node)
+            continue;
+
+        std::cout << dec << "node " << nodeId << ": ";
+        if (node->hasState())
+            std::cout << toText(TEXT_TO_STATE_MAPPING, node->getState()) << std::endl;
+        else
+            std::cout << "unknown state" << std::endl;
+        for (auto const& object : objects) {
+            std::cout << "  " << hex << object.first << " " << dec << (int)object.second << ":";
+            uint8_t buffer[256];
+            try {
+                int size = node->get(object.first, object.second, buffer, 256);
+                for (int i = 0; i < size; ++i)
+                    std::cout << " " << hex << (int)buffer[i];
+            }
+            catch(std::exception const&) {
+                std::cout << " not received";
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
+    // Offline commands, that do not use a CAN device
+    if (argc >= 3 && string(argv[1]) == "replay")
+        return replay(argc, argv);
+
     if (argc < 5) {
         return usage();
     }
@@ -104,6 +224,10 @@ int main(int argc, char** argv)
     DisplayStats stats(dynamic_cast<iodrivers_base::Driver*>(device.get()));
     device->setReadTimeout(2000);
     StateMachine canopen(node_id);
+    Dispatcher dispatcher;
+    dispatcher.add(canopen);
+    Reactor reactor;
+    base::Time const reply_timeout = base::Time::fromSeconds(2);
 
     if (cmd == "state-get") {
         if (argc != 5 && argc != 6)
@@ -123,14 +247,11 @@ int main(int argc, char** argv)
             device->write(download);
         }
 
-        while(true) {
-            canbus::Message msg = device->read();
-            auto update = canopen.process(msg);
-            if (update.mode == StateMachine::PROCESSED_HEARTBEAT) {
-                std::cout << toText(TEXT_TO_STATE_MAPPING, canopen.getState()) << std::endl;
-                break;
-            }
-        }
+        processUntil(reactor, *device, dispatcher, reply_timeout,
+            [](StateMachine::Update const& update) {
+                return update.mode == StateMachine::PROCESSED_HEARTBEAT;
+            });
+        std::cout << toText(TEXT_TO_STATE_MAPPING, canopen.getState()) << std::endl;
 
         if (!use_state_query) {
             uint8_t data[8] = { 0, 0, 0 };
@@ -154,19 +275,16 @@ int main(int argc, char** argv)
 
         canbus::Message upload = canopen.upload(objectId, subId);
         device->write(upload);
-        while(true) {
-            canbus::Message msg = device->read();
-            auto update = canopen.process(msg);
-            if (update.hasUpdatedObject(objectId, subId)) {
-                uint8_t buffer[256];
-                int size = canopen.get(objectId, subId, buffer, 256);
-                for (int i = 0; i < size; ++i) {
-                    std::cout << " " << hex << (int)buffer[i];
-                }
-                std::cout << std::endl;
-                break;
-            }
+        processUntil(reactor, *device, dispatcher, reply_timeout,
+            [&](StateMachine::Update const& update) {
+                return update.hasUpdatedObject(objectId, subId);
+            });
+        uint8_t buffer[256];
+        int size = canopen.get(objectId, subId, buffer, 256);
+        for (int i = 0; i < size; ++i) {
+            std::cout << " " << hex << (int)buffer[i];
         }
+        std::cout << std::endl;
     }
     else if (cmd == "sdo-set") {
         if (argc < 7)
@@ -181,20 +299,101 @@ int main(int argc, char** argv)
 
         canbus::Message download = canopen.download(objectId, subId, data, size);
         device->write(download);
-        while(true)
-        {
-            canbus::Message msg = device->read();
-            auto update = canopen.process(msg);
-            if (update.mode == canopen_master::StateMachine::PROCESSED_SDO_INITIATE_DOWNLOAD)
-                break;
-            else
-                std::cout << "unexpected message with mode " << update.mode << std::endl;
-        }
+        processUntil(reactor, *device, dispatcher, reply_timeout,
+            [](StateMachine::Update const& update) {
+                if (update.mode == StateMachine::PROCESSED_SDO_INITIATE_DOWNLOAD)
+                    return true;
+                else if (update.mode != StateMachine::PROCESSED_NOT_FOR_ME)
+                    std::cout << "unexpected message with mode " << update.mode << std::endl;
+                return false;
+            });
     }
     else if (cmd == "sync") {
         canbus::Message msg = canopen.sync();
         device->write(msg);
     }
+    else if (cmd == "monitor") {
+        if (argc != 6)
+            return usage();
+
+        base::Time period = base::Time::fromMilliseconds(stoi(argv[5]));
+        // Reported once per missed heartbeat window, then re-armed at each
+        // heartbeat
+        base::Time heartbeat_timeout = base::Time::fromSeconds(2);
+        int heartbeat_timer = reactor.addTimer(heartbeat_timeout, heartbeat_timeout, []() {
+            std::cout << "no heartbeat" << std::endl;
+        });
+        reactor.addTimer(period, period, [&]() {
+            device->write(canopen.sync());
+        });
+        reactor.watch(*device, dispatcher, [&](canbus::Message const& msg,
+                                               StateMachine::Update const& update) {
+            if (update.mode == StateMachine::PROCESSED_HEARTBEAT) {
+                reactor.setTimer(heartbeat_timer, heartbeat_timeout, heartbeat_timeout);
+                std::cout << msg.time << " "
+                    << toText(TEXT_TO_STATE_MAPPING, canopen.getState()) << std::endl;
+            }
+        });
+        reactor.run();
+    }
+    else if (cmd == "time") {
+        if (argc != 5 && argc != 6)
+            return usage();
+
+        device->write(makeTimeStampMessage(base::Time::now()));
+        if (argc == 6) {
+            base::Time period = base::Time::fromMilliseconds(stoi(argv[5]));
+            if (period.isNull())
+                return usage();
+            reactor.addTimer(period, period, [&]() {
+                device->write(makeTimeStampMessage(base::Time::now()));
+            });
+            reactor.run();
+        }
+    }
+    else if (cmd == "lss-assign") {
+        // Fastscan relies on timeouts to detect bits that no slave matches
+        device->setReadTimeout(20);
+        device->write(makeLSSSwitchStateGlobal(LSS_WAITING));
+
+        int nextNodeId = node_id;
+        while (true) {
+            LSSFastscan scan;
+            canbus::Message reply;
+            while (!scan.isFinished()) {
+                device->write(scan.getQuery());
+                if (waitLSSReply(*device, LSS_IDENTIFY_SLAVE, reply))
+                    scan.processReply();
+                else
+                    scan.processTimeout();
+            }
+            if (!scan.hasFoundSlave())
+                break;
+            if (nextNodeId > 127)
+                throw std::runtime_error("no node IDs left to assign");
+
+            LSSAddress address = scan.getAddress();
+            device->write(makeLSSConfigureNodeID(nextNodeId));
+            if (!waitLSSReply(*device, LSS_CONFIGURE_NODE_ID, reply))
+                throw std::runtime_error("LSS slave did not acknowledge its node ID");
+            parseLSSConfigurationReply(reply);
+            device->write(makeLSSStoreConfiguration());
+            if (!waitLSSReply(*device, LSS_STORE_CONFIGURATION, reply))
+                throw std::runtime_error("LSS slave did not acknowledge storing its configuration");
+            parseLSSConfigurationReply(reply);
+            device->write(makeLSSSwitchStateGlobal(LSS_WAITING));
+
+            std::cout << hex
+                << "vendor=0x" << address.getVendorID()
+                << " product=0x" << address.getProductCode()
+                << " revision=0x" << address.getRevisionNumber()
+                << " serial=0x" << address.getSerialNumber()
+                << dec << " node=" << nextNodeId << std::endl;
+            ++nextNodeId;
+        }
+        // The new node IDs are applied on reset communication
+        device->write(makeModuleControlCommand(NODE_RESET_COMMUNICATION, 0));
+    }
     else if (cmd == "read") {
         device->setReadTimeout(2000);
         canbus::Message msg = device->read();
@@ -0,0 +1,231 @@
+#include <canopen_master/MultiBus.hpp>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+/** Maximum time the worker sleeps when idle, which bounds the latency of
+ * frame processing */
+static const int64_t MAX_IDLE_SLEEP_US = 100;
+
+MultiBus::Bus::Bus(uint8_t index, FrameReaderThread::ReadFunction read,
+                   WriteFunction write, int cpu, size_t ringCapacity)
+    : index(index)
+    , cpu(cpu)
+    , writeFunction(write)
+    , ring(ringCapacity)
+    , reader(read, ring)
+    , processed(0)
+    , errors(0)
+{
+}
+
+uint8_t MultiBus::Bus::getIndex() const
+{
+    return index;
+}
+
+void MultiBus::Bus::write(canbus::Message const& msg)
+{
+    writeFunction(msg);
+}
+
+Dispatcher& MultiBus::Bus::getDispatcher()
+{
+    return dispatcher;
+}
+
+FrameRing const& MultiBus::Bus::getRing() const
+{
+    return ring;
+}
+
+uint64_t MultiBus::Bus::getProcessedCount() const
+{
+    return processed.load(memory_order_relaxed);
+}
+
+uint64_t MultiBus::Bus::getErrorCount() const
+{
+    return errors.load(memory_order_relaxed);
+}
+
+MultiBus::MultiBus(Clock const& clock)
+    : clock(clock)
+    , quit(false)
+{
+}
+
+MultiBus::~MultiBus()
+{
+    stop();
+}
+
+uint8_t MultiBus::addBus(canbus::Driver& driver, int cpu, size_t ringCapacity)
+{
+    return addBus([&driver]() { return driver.read(); },
+                  [&driver](canbus::Message const& msg) { driver.write(msg); },
+                  cpu, ringCapacity);
+}
+
+uint8_t MultiBus::addBus(FrameReaderThread::ReadFunction read, WriteFunction write,
+                         int cpu, size_t ringCapacity)
+{
+    checkNotRunning();
+    if (buses.size() > 255)
+        throw std::invalid_argument("too many buses");
+
+    uint8_t index = buses.size();
+    buses.push_back(makeAligned<Bus>(index, read, write, cpu, ringCapacity));
+    return index;
+}
+
+size_t MultiBus::getBusCount() const
+{
+    return buses.size();
+}
+
+MultiBus::Bus& MultiBus::getBus(uint8_t bus)
+{
+    if (bus >= buses.size())
+        throw std::invalid_argument("no bus with this index");
+    return *buses[bus];
+}
+
+NodeAddress MultiBus::add(uint8_t bus, StateMachine& machine)
+{
+    checkNotRunning();
+    getBus(bus).dispatcher.add(machine);
+    return NodeAddress(bus, machine.getNodeID());
+}
+
+StateMachine* MultiBus::get(NodeAddress const& address) const
+{
+    if (address.bus >= buses.size())
+        return nullptr;
+    return buses[address.bus]->dispatcher.get(address.nodeId);
+}
+
+void MultiBus::setHandler(Handler handler)
+{
+    checkNotRunning();
+    this->handler = handler;
+}
+
+void MultiBus::schedule(uint8_t bus, base::Time const& period, Task task)
+{
+    checkNotRunning();
+    if (period <= base::Time())
+        throw std::invalid_argument("the task period must be strictly positive");
+
+    Bus::ScheduledTask scheduled;
+    scheduled.period = period;
+    scheduled.task = task;
+    getBus(bus).tasks.push_back(scheduled);
+}
+
+void MultiBus::start()
+{
+    checkNotRunning();
+    quit = false;
+    running = true;
+
+    base::Time now = clock.now();
+    try {
+        for (auto& bus : buses) {
+            for (auto& task : bus->tasks)
+                task.deadline = now + task.period;
+
+            Bus& b = *bus;
+            bus->worker = std::thread([this, &b]() { run(b); });
+            if (bus->cpu >= 0)
+                setThreadAffinity(bus->worker, bus->cpu);
+            bus->reader.start(bus->cpu);
+        }
+    }
+    catch(...) {
+        stop();
+        throw;
+    }
+}
+
+void MultiBus::stop()
+{
+    quit = true;
+    for (auto& bus : buses) {
+        bus->reader.stop();
+        if (bus->worker.joinable())
+            bus->worker.join();
+    }
+    running = false;
+}
+
+bool MultiBus::isRunning() const
+{
+    return running;
+}
+
+void MultiBus::checkNotRunning() const
+{
+    if (running)
+        throw std::logic_error("cannot modify a running MultiBus");
+}
+
+void MultiBus::run(Bus& bus)
+{
+    size_t count = 0;
+    auto process = [this, &bus, &count](canbus::Message const& msg,
+                                        StateMachine::Update const& update) {
+        ++count;
+        if (handler)
+            handler(NodeAddress(bus.index, getNodeID(msg)), msg, update);
+    };
+
+    while (!quit.load(memory_order_relaxed)) {
+        count = 0;
+        bool failed = false;
+        try {
+            bus.dispatcher.process(bus.ring, process);
+        }
+        catch(std::exception const&) {
+            bus.errors.fetch_add(1, memory_order_relaxed);
+            failed = true;
+        }
+        bus.processed.fetch_add(count, memory_order_relaxed);
+
+        base::Time next = runTasks(bus);
+        if (count == 0 && !failed) {
+            int64_t sleep = min((next - clock.now()).toMicroseconds(),
+                                MAX_IDLE_SLEEP_US);
+            if (sleep > 0)
+                this_thread::sleep_for(chrono::microseconds(sleep));
+        }
+    }
+}
+
+base::Time MultiBus::runTasks(Bus& bus)
+{
+    base::Time next = base::Time::max();
+    if (bus.tasks.empty())
+        return next;
+
+    base::Time now = clock.now();
+    for (auto& task : bus.tasks) {
+        if (task.deadline <= now) {
+            // Skip the deadlines that have been missed instead of
+            // running the task in a burst
+            while (task.deadline <= now)
+                task.deadline = task.deadline + task.period;
+
+            try {
+                task.task(bus, now);
+            }
+            catch(std::exception const&) {
+                bus.errors.fetch_add(1, memory_order_relaxed);
+            }
+        }
+        next = min(next, task.deadline);
+    }
+    return next;
+}
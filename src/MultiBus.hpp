@@ -0,0 +1,192 @@
+#ifndef CANOPEN_MASTER_MULTI_BUS_HPP
+#define CANOPEN_MASTER_MULTI_BUS_HPP
+
+#include <canopen_master/Clock.hpp>
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/FrameReaderThread.hpp>
+#include <canopen_master/FrameRing.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Address of a node in a MultiBus */
+    struct NodeAddress
+    {
+        uint8_t bus = 0;
+        uint8_t nodeId = 0;
+
+        NodeAddress() {}
+        NodeAddress(uint8_t bus, uint8_t nodeId)
+            : bus(bus), nodeId(nodeId) {}
+
+        bool operator ==(NodeAddress const& other) const {
+            return bus == other.bus && nodeId == other.nodeId;
+        }
+        bool operator !=(NodeAddress const& other) const {
+            return !(*this == other);
+        }
+        bool operator <(NodeAddress const& other) const {
+            return bus < other.bus ||
+                (bus == other.bus && nodeId < other.nodeId);
+        }
+    };
+
+    /** Runtime for a master handling several CAN buses
+     *
+     * Each bus gets a reader thread feeding a FrameRing and a worker
+     * thread, both optionally pinned on a given CPU. The worker processes
+     * the received frames with the bus' Dispatcher and runs the periodic
+     * tasks scheduled on the bus. Buses share no state at runtime, so
+     * throughput scales with the number of buses as long as each has its
+     * own core.
+     *
+     * The state machines of a bus, the frame handler and the tasks of a
+     * bus are only called from the bus' worker thread. Since the worker
+     * keeps running when processing throws, state machines should be set
+     * to report device errors as updates (see
+     * StateMachine::setThrowOnDeviceErrors).
+     *
+     * Buses, nodes, tasks and the handler must be set up before start()
+     */
+    class MultiBus
+    {
+    public:
+        typedef std::function<void(canbus::Message const&)> WriteFunction;
+
+        /** Called on the worker thread of a bus for each received frame */
+        typedef std::function<void(NodeAddress const&,
+                                   canbus::Message const&,
+                                   StateMachine::Update const&)> Handler;
+
+        class Bus;
+
+        /** Task run periodically on the worker thread of a bus */
+        typedef std::function<void(Bus& bus, base::Time const& time)> Task;
+
+        /** A bus of a MultiBus */
+        class Bus
+        {
+        public:
+            Bus(uint8_t index, FrameReaderThread::ReadFunction read,
+                WriteFunction write, int cpu, size_t ringCapacity);
+
+            uint8_t getIndex() const;
+
+            /** Send a frame on the bus. Only call it from the bus' worker
+             * thread, i.e. from the handler or a task */
+            void write(canbus::Message const& msg);
+
+            Dispatcher& getDispatcher();
+            FrameRing const& getRing() const;
+
+            /** Number of frames passed to the handler */
+            uint64_t getProcessedCount() const;
+
+            /** Number of exceptions thrown while processing frames or
+             * running tasks */
+            uint64_t getErrorCount() const;
+
+        private:
+            friend class MultiBus;
+
+            struct ScheduledTask
+            {
+                base::Time period;
+                base::Time deadline;
+                Task task;
+            };
+
+            uint8_t index;
+            int cpu;
+            WriteFunction writeFunction;
+            FrameRing ring;
+            FrameReaderThread reader;
+            Dispatcher dispatcher;
+            std::vector<ScheduledTask> tasks;
+            std::thread worker;
+            std::atomic<uint64_t> processed;
+            std::atomic<uint64_t> errors;
+        };
+
+        /**
+         * @arg clock the clock used to schedule the tasks. It must be
+         *   thread-safe
+         */
+        explicit MultiBus(Clock const& clock = SystemClock::instance());
+
+        /** Stops the threads */
+        ~MultiBus();
+
+        MultiBus(MultiBus const&) = delete;
+        MultiBus& operator =(MultiBus const&) = delete;
+
+        /** Add a bus handled by a canbus driver
+         *
+         * @arg cpu the CPU on which the bus threads are pinned, or -1
+         * @return the bus index
+         */
+        uint8_t addBus(canbus::Driver& driver, int cpu = -1,
+                       size_t ringCapacity = 4096);
+
+        /** Add a bus using arbitrary read and write functions
+         *
+         * The read function is expected to throw on timeout
+         */
+        uint8_t addBus(FrameReaderThread::ReadFunction read, WriteFunction write,
+                       int cpu = -1, size_t ringCapacity = 4096);
+
+        size_t getBusCount() const;
+
+        /** @throw std::invalid_argument if there is no such bus */
+        Bus& getBus(uint8_t bus);
+
+        /** Register a state machine on a bus
+         *
+         * @return the node's address
+         */
+        NodeAddress add(uint8_t bus, StateMachine& machine);
+
+        /** The state machine at the given address, or nullptr */
+        StateMachine* get(NodeAddress const& address) const;
+
+        /** Set the function called for each received frame */
+        void setHandler(Handler handler);
+
+        /** Run a task periodically on the worker thread of a bus, starting
+         * one period after start() */
+        void schedule(uint8_t bus, base::Time const& period, Task task);
+
+        /** Start the reader and worker threads of all buses
+         *
+         * @throw std::runtime_error if the affinity of a thread could not
+         *   be set
+         */
+        void start();
+
+        /** Stop all threads and wait for them to finish */
+        void stop();
+
+        bool isRunning() const;
+
+    private:
+        Clock const& clock;
+        std::vector<AlignedPtr<Bus>> buses;
+        Handler handler;
+        std::atomic<bool> quit;
+        bool running = false;
+
+        void checkNotRunning() const;
+        void run(Bus& bus);
+        /** Run the due tasks of a bus
+         *
+         * @return the deadline of the next task
+         */
+        base::Time runTasks(Bus& bus);
+    };
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include <canopen_master/ObjectHistory.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+ObjectHistory::ObjectHistory(size_t capacity)
+    : capacity(capacity)
+    , entries(new Entry[capacity])
+    , started(0)
+    , count(0)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("the history capacity must not be zero");
+}
+
+ObjectHistory::ObjectHistory(ObjectHistory const& other)
+    : capacity(other.capacity)
+    , entries(new Entry[other.capacity])
+{
+    copy(other);
+}
+
+ObjectHistory& ObjectHistory::operator =(ObjectHistory const& other)
+{
+    if (this == &other)
+        return *this;
+    if (capacity != other.capacity) {
+        entries.reset(new Entry[other.capacity]);
+        capacity = other.capacity;
+    }
+    copy(other);
+    return *this;
+}
+
+void ObjectHistory::copy(ObjectHistory const& other)
+{
+    for (size_t i = 0; i < capacity; ++i) {
+        entries[i].timestamp.store(
+            other.entries[i].timestamp.load(memory_order_relaxed), memory_order_relaxed);
+        entries[i].value.store(
+            other.entries[i].value.load(memory_order_relaxed), memory_order_relaxed);
+    }
+    uint64_t otherCount = other.count.load(memory_order_relaxed);
+    started.store(otherCount, memory_order_relaxed);
+    count.store(otherCount, memory_order_release);
+}
+
+size_t ObjectHistory::getCapacity() const
+{
+    return capacity;
+}
+
+uint64_t ObjectHistory::getCount() const
+{
+    return count.load(memory_order_acquire);
+}
+
+void ObjectHistory::push(Timestamp timestamp, uint8_t const* data, uint8_t size)
+{
+    uint32_t raw = 0;
+    memcpy(&raw, data, min<size_t>(size, 4));
+
+    // Readers that see any of the entry's new contents also see that its
+    // write started, and drop the sample it held
+    uint64_t index = count.load(memory_order_relaxed);
+    started.store(index + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    Entry& entry = entries[index % capacity];
+    entry.timestamp.store(timestamp, memory_order_relaxed);
+    entry.value.store(static_cast<uint64_t>(size) << 32 | raw, memory_order_relaxed);
+    count.store(index + 1, memory_order_release);
+}
+
+size_t ObjectHistory::read(ObjectSample* samples, size_t max) const
+{
+    uint64_t end = count.load(memory_order_acquire);
+    size_t size = min<uint64_t>(min<uint64_t>(end, capacity), max);
+    uint64_t begin = end - size;
+    for (uint64_t i = begin; i < end; ++i) {
+        Entry const& entry = entries[i % capacity];
+        ObjectSample& sample = samples[i - begin];
+        sample.timestamp = entry.timestamp.load(memory_order_relaxed);
+        uint64_t value = entry.value.load(memory_order_relaxed);
+        uint32_t raw = value;
+        memcpy(sample.data, &raw, 4);
+        sample.size = value >> 32;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    // Writing sample N overwrites sample N - capacity
+    uint64_t overwritten = started.load(memory_order_relaxed);
+    uint64_t valid = overwritten > capacity ? overwritten - capacity : 0;
+    if (valid <= begin)
+        return size;
+    if (valid >= end)
+        return 0;
+    size_t dropped = valid - begin;
+    std::copy(samples + dropped, samples + size, samples);
+    return size - dropped;
+}
@@ -0,0 +1,79 @@
+#ifndef CANOPEN_MASTER_OBJECT_HISTORY_HPP
+#define CANOPEN_MASTER_OBJECT_HISTORY_HPP
+
+#include <canopen_master/Clock.hpp>
+#include <canopen_master/Frame.hpp>
+#include <atomic>
+#include <memory>
+
+namespace canopen_master
+{
+    /** A value of an object, as stored in its ObjectHistory */
+    struct ObjectSample
+    {
+        Timestamp timestamp = 0;
+        uint8_t data[4] = { 0, 0, 0, 0 };
+        uint8_t size = 0;
+
+        /** See decodeObjectValue */
+        template <typename T> T as() const
+        {
+            return decodeObjectValue<T>(data, size);
+        }
+    };
+
+    /** The last values of a dictionary object
+     *
+     * Samples are stored in a ring allocated once, when the history is
+     * created. The history is written by the thread that processes the
+     * object's state machine, and can be read concurrently from other
+     * threads without locking: reads that overlap a write drop the samples
+     * that it may have overwritten.
+     */
+    class ObjectHistory
+    {
+    public:
+        explicit ObjectHistory(size_t capacity);
+
+        /** Copies the samples. Neither history may be written meanwhile */
+        ObjectHistory(ObjectHistory const& other);
+        ObjectHistory& operator =(ObjectHistory const& other);
+
+        size_t getCapacity() const;
+
+        /** Number of samples written since the history was created,
+         * including the ones that have been overwritten */
+        uint64_t getCount() const;
+
+        /** Append a sample, overwriting the oldest if the history is full */
+        void push(Timestamp timestamp, uint8_t const* data, uint8_t size);
+
+        /** Copy the most recent samples, oldest first
+         *
+         * @arg max the maximum number of samples to copy
+         * @return the number of samples copied. It is lower than max if
+         *   the history has less samples, or if the oldest ones have been
+         *   overwritten while they were copied.
+         */
+        size_t read(ObjectSample* samples, size_t max) const;
+
+    private:
+        struct Entry
+        {
+            std::atomic<int64_t> timestamp;
+            /** The value's bytes, and its size in the upper 32 bits */
+            std::atomic<uint64_t> value;
+        };
+
+        size_t capacity;
+        std::unique_ptr<Entry[]> entries;
+        /** Number of samples whose write has started */
+        std::atomic<uint64_t> started;
+        /** Number of samples whose write has finished */
+        std::atomic<uint64_t> count;
+
+        void copy(ObjectHistory const& other);
+    };
+}
+
+#endif
@@ -31,14 +31,15 @@ canbus::Message canopen_master::disablePDOMessage(
     return message;
 }
 
-vector<canbus::Message> canopen_master::makePDOConfigurationMessages(
+size_t canopen_master::makePDOConfigurationMessagesInto(
         bool transmit, uint16_t nodeId, int pdoIndex,
         PDOCommunicationParameters const& parameters,
         PDOMapping const& mappings,
+        canbus::Message* messages,
         bool cobid_message_reserved_bit_quirk)
 {
-    auto messages = makePDOCommunicationParametersMessages(
-        transmit, nodeId, pdoIndex, parameters);
+    size_t count = makePDOCommunicationParametersMessagesInto(
+        transmit, nodeId, pdoIndex, parameters, messages);
     if (cobid_message_reserved_bit_quirk) {
         messages[0].data[7] |= 0x40;
     }
@@ -47,21 +48,31 @@ vector<canbus::Message> canopen_master::makePDOConfigurationMessages(
     // later.
     messages[0].data[7] |= 0x80;
 
-    auto mappingMessages = makePDOMappingMessages(
-        transmit, nodeId, pdoIndex, mappings);
-    messages.insert(
-        messages.end(),
-        mappingMessages.begin(), mappingMessages.end()
-    );
+    count += makePDOMappingMessagesInto(
+        transmit, nodeId, pdoIndex, mappings, messages + count);
 
     // Now re-enable the message
-    messages.push_back(pdoCOB_IDSetting);
-    return messages;
+    messages[count++] = pdoCOB_IDSetting;
+    return count;
 }
 
-vector<canbus::Message> canopen_master::makePDOCommunicationParametersMessages(
+vector<canbus::Message> canopen_master::makePDOConfigurationMessages(
+        bool transmit, uint16_t nodeId, int pdoIndex,
+        PDOCommunicationParameters const& parameters,
+        PDOMapping const& mappings,
+        bool cobid_message_reserved_bit_quirk)
+{
+    canbus::Message messages[MAX_PDO_CONFIGURATION_MESSAGES];
+    size_t count = makePDOConfigurationMessagesInto(
+        transmit, nodeId, pdoIndex, parameters, mappings, messages,
+        cobid_message_reserved_bit_quirk);
+    return vector<canbus::Message>(messages, messages + count);
+}
+
+size_t canopen_master::makePDOCommunicationParametersMessagesInto(
     bool transmit, uint16_t nodeId, int pdoIndex,
-    PDOCommunicationParameters const& parameters)
+    PDOCommunicationParameters const& parameters,
+    canbus::Message* messages)
 {
     uint32_t sdoObjId = getPDOParametersObjectId(transmit, pdoIndex);
     uint32_t cob_id = parameters.cob_id;
@@ -69,14 +80,12 @@ vector<canbus::Message> canopen_master::makePDOCommunicationParametersMessages(
         cob_id = getPDODefaultCOBID(transmit, pdoIndex, nodeId);
     }
 
-    vector<canbus::Message> messages;
+    size_t count = 0;
 
     // Set up COB-ID
     uint8_t data[4];
     toLittleEndian(data, cob_id);
-    messages.push_back(
-        makeSDOInitiateDomainDownload(nodeId, sdoObjId, 1, data, 4)
-    );
+    messages[count++] = makeSDOInitiateDomainDownload(nodeId, sdoObjId, 1, data, 4);
 
     // Set up mode
     data[0] = 0;
@@ -101,7 +110,7 @@ vector<canbus::Message> canopen_master::makePDOCommunicationParametersMessages(
             data[0] = 254;
             break;
     }
-    messages.push_back(makeSDOInitiateDomainDownload(nodeId, sdoObjId, 2, data, 1));
+    messages[count++] = makeSDOInitiateDomainDownload(nodeId, sdoObjId, 2, data, 1);
 
     if (transmit && parameters.transmission_mode >= PDO_ASYNCHRONOUS_RTR_ONLY)
     {
@@ -110,19 +119,27 @@ vector<canbus::Message> canopen_master::makePDOCommunicationParametersMessages(
             throw std::invalid_argument("inhibit time too big (must be lower than 6.5s)");
         }
         toLittleEndian(data, static_cast<uint16_t>(inhibit_time_us / 100));
-        messages.push_back(
-            makeSDOInitiateDomainDownload(nodeId, sdoObjId, 3, data, 2));
+        messages[count++] = makeSDOInitiateDomainDownload(nodeId, sdoObjId, 3, data, 2);
 
         uint64_t timer_period_ms = parameters.timer_period.toMilliseconds();
         if (timer_period_ms > 65535) {
             throw std::invalid_argument("timer period too big (must be lower than 65s)");
         }
         toLittleEndian(data, static_cast<uint16_t>(timer_period_ms));
-        messages.push_back(
-            makeSDOInitiateDomainDownload(nodeId, sdoObjId, 5, data, 2));
+        messages[count++] = makeSDOInitiateDomainDownload(nodeId, sdoObjId, 5, data, 2);
     }
 
-    return messages;
+    return count;
+}
+
+vector<canbus::Message> canopen_master::makePDOCommunicationParametersMessages(
+    bool transmit, uint16_t nodeId, int pdoIndex,
+    PDOCommunicationParameters const& parameters)
+{
+    canbus::Message messages[MAX_PDO_COMMUNICATION_PARAMETERS_MESSAGES];
+    size_t count = makePDOCommunicationParametersMessagesInto(
+        transmit, nodeId, pdoIndex, parameters, messages);
+    return vector<canbus::Message>(messages, messages + count);
 }
 
 bool canopen_master::isPDO(uint16_t functionCode)
@@ -160,15 +177,18 @@ uint16_t canopen_master::getPDOMappingObjectId(bool transmit, uint8_t pdoIndex)
     return (transmit ? 0x1A00 : 0x1600) + pdoIndex;
 }
 
-std::vector<canbus::Message> canopen_master::makePDOMappingMessages(
-    bool transmit, uint8_t nodeId, uint8_t pdoIndex, PDOMapping const& mapping
+size_t canopen_master::makePDOMappingMessagesInto(
+    bool transmit, uint8_t nodeId, uint8_t pdoIndex, PDOMapping const& mapping,
+    canbus::Message* messages
 ) {
-    std::vector<canbus::Message> result;
     uint16_t pdoObjectId = getPDOMappingObjectId(transmit, pdoIndex);
+    if (mapping.mappings.size() > MAX_PDO_MAPPED_OBJECTS)
+        throw PDOMappingTooBig();
     uint8_t mappingSize = mapping.mappings.size();
 
+    size_t count = 0;
     uint8_t buffer[4] = { 0, 0, 0, 0 };
-    result.push_back(makeSDOInitiateDomainDownload(nodeId, pdoObjectId, 0, buffer, 4));
+    messages[count++] = makeSDOInitiateDomainDownload(nodeId, pdoObjectId, 0, buffer, 4);
     for (int i = 0; i < mappingSize; ++i)
     {
         PDOMapping::MappedObject m = mapping.mappings[i];
@@ -177,12 +197,20 @@ std::vector<canbus::Message> canopen_master::makePDOMappingMessages(
         buffer[0] = m.size * 8;
         buffer[1] = m.subId;
         toLittleEndian(buffer + 2, m.objectId);
-        result.push_back(makeSDOInitiateDomainDownload(
+        messages[count++] = makeSDOInitiateDomainDownload(
             nodeId, pdoObjectId, i + 1, buffer, 4
-        ));
+        );
     }
 
     toLittleEndian(buffer, static_cast<int32_t>(mappingSize));
-    result.push_back(makeSDOInitiateDomainDownload(nodeId, pdoObjectId, 0, buffer, 4));
-    return result;
+    messages[count++] = makeSDOInitiateDomainDownload(nodeId, pdoObjectId, 0, buffer, 4);
+    return count;
+}
+
+std::vector<canbus::Message> canopen_master::makePDOMappingMessages(
+    bool transmit, uint8_t nodeId, uint8_t pdoIndex, PDOMapping const& mapping
+) {
+    canbus::Message messages[MAX_PDO_MAPPING_MESSAGES];
+    size_t count = makePDOMappingMessagesInto(transmit, nodeId, pdoIndex, mapping, messages);
+    return std::vector<canbus::Message>(messages, messages + count);
 }
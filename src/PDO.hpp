@@ -1,6 +1,7 @@
 #ifndef CANOPEN_MASTER_PDO_HPP
 #define CANOPEN_MASTER_PDO_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <canmessage.hh>
 #include <canopen_master/PDOMapping.hpp>
@@ -8,6 +9,18 @@
 
 namespace canopen_master
 {
+    /** Maximum number of objects in a PDO mapping, as objects are at least
+     * one byte long */
+    constexpr size_t MAX_PDO_MAPPED_OBJECTS = 8;
+    /** Maximum number of messages generated by
+     * makePDOCommunicationParametersMessages */
+    constexpr size_t MAX_PDO_COMMUNICATION_PARAMETERS_MESSAGES = 4;
+    /** Maximum number of messages generated by makePDOMappingMessages */
+    constexpr size_t MAX_PDO_MAPPING_MESSAGES = MAX_PDO_MAPPED_OBJECTS + 2;
+    /** Maximum number of messages generated by makePDOConfigurationMessages */
+    constexpr size_t MAX_PDO_CONFIGURATION_MESSAGES =
+        MAX_PDO_COMMUNICATION_PARAMETERS_MESSAGES + MAX_PDO_MAPPING_MESSAGES + 1;
+
     int getPDOIndex(uint16_t functionCode);
     bool isPDO(uint16_t functionCode);
     bool isPDOTransmit(uint16_t functionCode);
@@ -29,6 +42,38 @@ namespace canopen_master
         PDOCommunicationParameters const& parameters,
         PDOMapping const& mappings,
         bool cobid_message_reserved_bit_quirk = false);
+
+    /** Allocation-free version of makePDOCommunicationParametersMessages
+     *
+     * @arg messages output buffer, with room for at least
+     *   MAX_PDO_COMMUNICATION_PARAMETERS_MESSAGES messages
+     * @return the number of messages written in the buffer
+     */
+    size_t makePDOCommunicationParametersMessagesInto(
+        bool transmit, uint16_t nodeId, int pdoIndex,
+        PDOCommunicationParameters const& parameters,
+        canbus::Message* messages);
+    /** Allocation-free version of makePDOMappingMessages
+     *
+     * @arg messages output buffer, with room for at least
+     *   MAX_PDO_MAPPING_MESSAGES messages
+     * @return the number of messages written in the buffer
+     */
+    size_t makePDOMappingMessagesInto(
+        bool transmit, uint8_t nodeId, uint8_t pdoIndex,
+        PDOMapping const& mapping, canbus::Message* messages);
+    /** Allocation-free version of makePDOConfigurationMessages
+     *
+     * @arg messages output buffer, with room for at least
+     *   MAX_PDO_CONFIGURATION_MESSAGES messages
+     * @return the number of messages written in the buffer
+     */
+    size_t makePDOConfigurationMessagesInto(
+        bool transmit, uint16_t nodeId, int pdoIndex,
+        PDOCommunicationParameters const& parameters,
+        PDOMapping const& mappings,
+        canbus::Message* messages,
+        bool cobid_message_reserved_bit_quirk = false);
 }
 
 #endif
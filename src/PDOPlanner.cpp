@@ -0,0 +1,172 @@
+#include <canopen_master/PDOPlanner.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/StateMachine.hpp>
+#include <algorithm>
+
+using namespace std;
+using namespace canopen_master;
+
+/** Biggest sync_period usable in PDO_SYNCHRONOUS mode. 241-251 are
+ * reserved by CiA 301 */
+static const int64_t MAX_SYNC_PERIOD = 240;
+
+PDOPlanner::PDOPlanner(PDOLimits const& limits)
+    : limits(limits)
+{
+}
+
+void PDOPlanner::setSyncPeriod(base::Time const& period)
+{
+    syncPeriod = period;
+}
+
+void PDOPlanner::add(bool transmit, uint16_t objectId, uint8_t subId, uint8_t size,
+                     base::Time const& period)
+{
+    if (size == 0 || size > limits.maxPayload)
+        throw std::invalid_argument("object size does not fit in a PDO");
+    if (period.isNull())
+        throw std::invalid_argument("object period must be non-zero");
+
+    Request request;
+    request.transmit = transmit;
+    request.object = PDOMapping::MappedObject { objectId, subId, size };
+    request.period = period;
+    requests.push_back(request);
+}
+
+base::Time PDOPlanner::getEffectivePeriod(base::Time const& period) const
+{
+    if (syncPeriod.isNull()) {
+        // The event timer has a millisecond resolution
+        int64_t ms = period.toMilliseconds();
+        if (ms == 0)
+            throw PDOPlanningFailed("requested period lower than 1ms");
+        return base::Time::fromMilliseconds(min<int64_t>(ms, 65535));
+    }
+
+    int64_t cycles = period.toMicroseconds() / syncPeriod.toMicroseconds();
+    if (cycles == 0)
+        throw PDOPlanningFailed("requested period lower than the SYNC period");
+    cycles = min(cycles, MAX_SYNC_PERIOD);
+    return base::Time::fromMicroseconds(cycles * syncPeriod.toMicroseconds());
+}
+
+PDOCommunicationParameters PDOPlanner::makeParameters(
+    bool transmit, base::Time const& period) const
+{
+    if (syncPeriod.isNull()) {
+        if (transmit)
+            return PDOCommunicationParameters::Periodic(period);
+        else
+            return PDOCommunicationParameters::Async();
+    }
+
+    // For RPDOs, any value between 0 and 240 means "apply at the next SYNC"
+    if (!transmit)
+        return PDOCommunicationParameters::Sync(1);
+    return PDOCommunicationParameters::Sync(
+        period.toMicroseconds() / syncPeriod.toMicroseconds());
+}
+
+void PDOPlanner::planDirection(bool transmit, Plan& plan) const
+{
+    vector<Request> sorted;
+    for (auto const& r : requests) {
+        if (r.transmit == transmit) {
+            sorted.push_back(r);
+            sorted.back().period = getEffectivePeriod(r.period);
+        }
+    }
+    // Fastest first. Within the same period, biggest first so that smaller
+    // objects can fill the gaps
+    stable_sort(sorted.begin(), sorted.end(),
+        [](Request const& a, Request const& b) {
+            if (a.period != b.period)
+                return a.period < b.period;
+            return a.object.size > b.object.size;
+        });
+
+    size_t first = plan.pdos.size();
+    uint8_t maxPDO = transmit ? limits.maxTPDO : limits.maxRPDO;
+    for (auto const& r : sorted) {
+        // Since objects are sorted by period, all already allocated PDOs
+        // are fast enough. Use the one with the least room left
+        PlannedPDO* best = nullptr;
+        for (size_t i = first; i < plan.pdos.size(); ++i) {
+            PlannedPDO& pdo = plan.pdos[i];
+            if (pdo.mapping.mappings.size() >= limits.maxMappedObjects)
+                continue;
+            if (pdo.mapping.currentSize + r.object.size > limits.maxPayload)
+                continue;
+            if (!best || pdo.mapping.currentSize > best->mapping.currentSize)
+                best = &pdo;
+        }
+
+        if (!best) {
+            if (plan.pdos.size() - first >= maxPDO) {
+                throw PDOPlanningFailed(
+                    "cannot fit the requested objects in the device's PDOs");
+            }
+
+            PlannedPDO pdo;
+            pdo.transmit = transmit;
+            pdo.pdoIndex = plan.pdos.size() - first;
+            pdo.period = r.period;
+            pdo.parameters = makeParameters(transmit, r.period);
+            plan.pdos.push_back(pdo);
+            best = &plan.pdos.back();
+        }
+        best->mapping.add(r.object.objectId, r.object.subId, r.object.size);
+    }
+}
+
+PDOPlanner::Plan PDOPlanner::plan() const
+{
+    Plan result;
+    result.limits = limits;
+    planDirection(true, result);
+    planDirection(false, result);
+    return result;
+}
+
+double PDOPlanner::Plan::getFramesPerSecond() const
+{
+    double result = 0;
+    for (auto const& pdo : pdos)
+        result += 1.0 / pdo.period.toSeconds();
+    return result;
+}
+
+vector<canbus::Message> PDOPlanner::Plan::configure(StateMachine const& machine) const
+{
+    vector<canbus::Message> messages;
+    bool usedTPDO[256] = { false, };
+    bool usedRPDO[256] = { false, };
+    for (auto const& pdo : pdos) {
+        auto pdoMessages = machine.configurePDO(
+            pdo.transmit, pdo.pdoIndex, pdo.parameters, pdo.mapping);
+        messages.insert(messages.end(), pdoMessages.begin(), pdoMessages.end());
+        (pdo.transmit ? usedTPDO : usedRPDO)[pdo.pdoIndex] = true;
+    }
+
+    for (int i = 0; i < limits.maxTPDO; ++i) {
+        if (!usedTPDO[i])
+            messages.push_back(machine.disablePDO(true, i));
+    }
+    for (int i = 0; i < limits.maxRPDO; ++i) {
+        if (!usedRPDO[i])
+            messages.push_back(machine.disablePDO(false, i));
+    }
+    return messages;
+}
+
+void PDOPlanner::Plan::declare(StateMachine& machine) const
+{
+    for (auto const& pdo : pdos) {
+        if (pdo.transmit)
+            machine.declareTPDOMapping(pdo.pdoIndex, pdo.mapping, pdo.parameters);
+        else
+            machine.declareRPDOMapping(pdo.pdoIndex, pdo.mapping);
+    }
+}
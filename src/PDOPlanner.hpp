@@ -0,0 +1,145 @@
+#ifndef CANOPEN_MASTER_PDO_PLANNER_HPP
+#define CANOPEN_MASTER_PDO_PLANNER_HPP
+
+#include <base/Time.hpp>
+#include <canmessage.hh>
+#include <canopen_master/PDOCommunicationParameters.hpp>
+#include <canopen_master/PDOMapping.hpp>
+#include <vector>
+
+namespace canopen_master
+{
+    class StateMachine;
+
+    /** Limits of a device's PDO implementation, as used by PDOPlanner */
+    struct PDOLimits
+    {
+        /** How many TPDOs the device supports (4 in the predefined set) */
+        uint8_t maxTPDO = 4;
+        /** How many RPDOs the device supports (4 in the predefined set) */
+        uint8_t maxRPDO = 4;
+        /** Maximum number of objects mapped in a single PDO */
+        uint8_t maxMappedObjects = 8;
+        /** Maximum payload of a single PDO, in bytes */
+        uint8_t maxPayload = 8;
+    };
+
+    /** Automatic allocation of dictionary objects into PDOs
+     *
+     * Register the objects that should be exchanged through PDOs along with
+     * the period at which they must at least be refreshed, and call plan()
+     * to get a set of PDOs that minimizes the number of frames per second
+     * on the bus.
+     *
+     * Objects are handled from the fastest to the slowest. Each object is
+     * put in the fullest already-allocated PDO it fits in - since these PDOs
+     * are at least as fast as required, this is "free" bandwidth - and a new
+     * PDO is opened only if none has room left.
+     *
+     * By default, TPDOs are configured as timer-driven asynchronous PDOs.
+     * Call setSyncPeriod to plan synchronous PDOs instead.
+     */
+    class PDOPlanner
+    {
+    public:
+        struct PlannedPDO
+        {
+            bool transmit;
+            uint8_t pdoIndex;
+            /** The period at which this PDO is going to be exchanged
+             *
+             * For RPDOs, this is the period at which the application is
+             * expected to send the PDO
+             */
+            base::Time period;
+            PDOCommunicationParameters parameters;
+            PDOMapping mapping;
+        };
+
+        struct Plan
+        {
+            std::vector<PlannedPDO> pdos;
+            /** The limits the plan has been computed for */
+            PDOLimits limits;
+
+            /** Expected number of frames per second generated by the plan */
+            double getFramesPerSecond() const;
+
+            /** Return the SDO messages that configure the planned PDOs on
+             * the device
+             *
+             * PDOs that are supported by the device but are not used by the
+             * plan are disabled
+             */
+            std::vector<canbus::Message> configure(StateMachine const& machine) const;
+
+            /** Declare the planned mappings and TPDO communication parameters
+             * on the state machine, using declareTPDOMapping and
+             * declareRPDOMapping
+             */
+            void declare(StateMachine& machine) const;
+        };
+
+        explicit PDOPlanner(PDOLimits const& limits = PDOLimits());
+
+        /** Plan synchronous PDOs, assuming that the SYNC is produced at the
+         * given period
+         *
+         * Set to a null time to go back to asynchronous, timer-driven PDOs
+         */
+        void setSyncPeriod(base::Time const& period);
+
+        /** Register an object that should be exchanged through PDOs
+         *
+         * @arg transmit true for objects sent by the device (TPDOs), false
+         *   for objects sent by the master (RPDOs)
+         * @arg period the maximum time between two updates of the object
+         */
+        void add(bool transmit, uint16_t objectId, uint8_t subId, uint8_t size,
+                 base::Time const& period);
+
+        /** Register an object sent by the device, using a type defined with
+         * CANOPEN_DEFINE_OBJECT
+         */
+        template<typename T>
+        void addTPDO(base::Time const& period, int offsetID = 0, int offsetSubID = 0) {
+            add(true, T::OBJECT_ID + offsetID, T::OBJECT_SUB_ID + offsetSubID,
+                sizeof(typename T::OBJECT_TYPE), period);
+        }
+
+        /** Register an object sent to the device, using a type defined with
+         * CANOPEN_DEFINE_OBJECT
+         */
+        template<typename T>
+        void addRPDO(base::Time const& period, int offsetID = 0, int offsetSubID = 0) {
+            add(false, T::OBJECT_ID + offsetID, T::OBJECT_SUB_ID + offsetSubID,
+                sizeof(typename T::OBJECT_TYPE), period);
+        }
+
+        /** Compute the PDO allocation
+         *
+         * @throw PDOPlanningFailed if the objects do not fit in the PDOs
+         *   available on the device
+         */
+        Plan plan() const;
+
+    private:
+        struct Request
+        {
+            bool transmit;
+            PDOMapping::MappedObject object;
+            base::Time period;
+        };
+
+        PDOLimits limits;
+        base::Time syncPeriod;
+        std::vector<Request> requests;
+
+        void planDirection(bool transmit, Plan& plan) const;
+        base::Time getEffectivePeriod(base::Time const& period) const;
+        PDOCommunicationParameters makeParameters(bool transmit,
+                                                  base::Time const& period) const;
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <canopen_master/ProtocolCounters.hpp>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+const size_t ProtocolCounters::CACHE_LINE_SIZE;
+
+uint64_t ProtocolCountersSnapshot::getTotal(PROTOCOL_COUNTER counter) const
+{
+    uint64_t total = 0;
+    for (auto const& node : nodes)
+        total += node[counter];
+    return total;
+}
+
+ProtocolCounters::ProtocolCounters()
+{
+    void* memory;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, sizeof(Node) * 128))
+        throw std::bad_alloc();
+
+    nodes = static_cast<Node*>(memory);
+    for (int i = 0; i < 128; ++i) {
+        new(nodes + i) Node;
+        for (auto& counter : nodes[i].counters)
+            counter.store(0, memory_order_relaxed);
+    }
+}
+
+ProtocolCounters::~ProtocolCounters()
+{
+    for (int i = 0; i < 128; ++i)
+        nodes[i].~Node();
+    free(nodes);
+}
+
+void ProtocolCounters::add(uint8_t nodeId, PROTOCOL_COUNTER counter, uint64_t value)
+{
+    // Single writer, plain loads and stores are enough
+    std::atomic<uint64_t>& c = nodes[nodeId & 0x7F].counters[counter];
+    c.store(c.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+uint64_t ProtocolCounters::get(uint8_t nodeId, PROTOCOL_COUNTER counter) const
+{
+    if (nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+    return nodes[nodeId].counters[counter].load(memory_order_relaxed);
+}
+
+NodeProtocolCounters ProtocolCounters::get(uint8_t nodeId) const
+{
+    if (nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+
+    NodeProtocolCounters result;
+    for (int i = 0; i < PROTOCOL_COUNTER_COUNT; ++i)
+        result.values[i] = nodes[nodeId].counters[i].load(memory_order_relaxed);
+    return result;
+}
+
+ProtocolCountersSnapshot ProtocolCounters::snapshot() const
+{
+    ProtocolCountersSnapshot result;
+    for (int i = 0; i < 128; ++i)
+        result.nodes[i] = get(i);
+    return result;
+}
@@ -0,0 +1,111 @@
+#ifndef CANOPEN_MASTER_PROTOCOL_COUNTERS_HPP
+#define CANOPEN_MASTER_PROTOCOL_COUNTERS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace canopen_master
+{
+    /** The events counted by ProtocolCounters */
+    enum PROTOCOL_COUNTER {
+        /** Frames received from the node */
+        COUNTER_FRAMES,
+        /** Payload bytes received from the node */
+        COUNTER_BYTES,
+        /** TPDOs that have no declared mapping, see
+         * StateMachine::PROCESSED_PDO_UNEXPECTED */
+        COUNTER_UNEXPECTED_PDOS,
+        /** SDO replies the state machine does not handle, e.g.
+         * non-expedited transfers */
+        COUNTER_IGNORED_SDOS,
+        /** SDO aborts, whether they are thrown or reported */
+        COUNTER_SDO_ABORTS,
+        /** Emergency messages, including the ones reporting no error */
+        COUNTER_EMERGENCIES,
+        COUNTER_HEARTBEATS,
+        /** Frames from a node that has no registered state machine, counted
+         * by the dispatchers (see Dispatcher::setProtocolCounters). This is
+         * the only counter of nodes that are not expected on the bus */
+        COUNTER_UNREGISTERED_FRAMES,
+        PROTOCOL_COUNTER_COUNT
+    };
+
+    /** A copy of the counters of a node, see ProtocolCounters::get */
+    struct NodeProtocolCounters
+    {
+        uint64_t values[PROTOCOL_COUNTER_COUNT];
+
+        uint64_t operator [](PROTOCOL_COUNTER counter) const
+        {
+            return values[counter];
+        }
+    };
+
+    /** A copy of the counters of all nodes, see ProtocolCounters::snapshot */
+    struct ProtocolCountersSnapshot
+    {
+        NodeProtocolCounters nodes[128];
+
+        /** Sum of a counter over all nodes */
+        uint64_t getTotal(PROTOCOL_COUNTER counter) const;
+    };
+
+    /** Counters of protocol events, per node
+     *
+     * The counters of a bus are meant to be shared by the state machines of
+     * its nodes and by its dispatcher, see StateMachine::setProtocolCounters
+     * and Dispatcher::setProtocolCounters. Each node has its
+     * own cache line, so that state machines processed by different
+     * threads (see ShardedDispatcher) do not contend on it.
+     *
+     * A counter must be written by a single thread, i.e. the one that
+     * processes the state machine of its node, or the one that dispatches
+     * the frames for COUNTER_UNREGISTERED_FRAMES. They can be read from any
+     * thread, e.g. by a monitoring loop.
+     */
+    class ProtocolCounters
+    {
+    public:
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        ProtocolCounters();
+        ~ProtocolCounters();
+
+        ProtocolCounters(ProtocolCounters const&) = delete;
+        ProtocolCounters& operator =(ProtocolCounters const&) = delete;
+
+        /** Increment a counter of a node */
+        void add(uint8_t nodeId, PROTOCOL_COUNTER counter, uint64_t value = 1);
+
+        /** The value of a counter of a node */
+        uint64_t get(uint8_t nodeId, PROTOCOL_COUNTER counter) const;
+
+        /** Copy the counters of a node
+         *
+         * @throw std::invalid_argument if the node ID is above 127
+         */
+        NodeProtocolCounters get(uint8_t nodeId) const;
+
+        /** Copy the counters of all nodes
+         *
+         * Each counter is read atomically, but the copy is not a snapshot
+         * of a single instant: events counted while it is taken may be
+         * reflected in some counters and not in others
+         */
+        ProtocolCountersSnapshot snapshot() const;
+
+    private:
+        struct alignas(CACHE_LINE_SIZE) Node
+        {
+            std::atomic<uint64_t> counters[PROTOCOL_COUNTER_COUNT];
+        };
+        static_assert(sizeof(Node) == CACHE_LINE_SIZE,
+                      "the counters of a node must fit in a cache line");
+
+        /** Allocated aligned, as new does not honor alignas in C++11 */
+        Node* nodes;
+    };
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include <canopen_master/Reactor.hpp>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+static std::runtime_error systemError(string const& message)
+{
+    return std::runtime_error(message + ": " + strerror(errno));
+}
+
+static timespec toTimespec(base::Time const& time)
+{
+    int64_t us = time.toMicroseconds();
+    timespec ts;
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    return ts;
+}
+
+Reactor::Reactor()
+    : stopped(false)
+{
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFD == -1)
+        throw systemError("failed to create the epoll instance");
+
+    wakeupFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeupFD == -1) {
+        close(epollFD);
+        throw systemError("failed to create the wakeup eventfd");
+    }
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = wakeupFD;
+    epoll_ctl(epollFD, EPOLL_CTL_ADD, wakeupFD, &event);
+}
+
+Reactor::~Reactor()
+{
+    for (auto const& watch : watches) {
+        if (watch.second->timer)
+            close(watch.first);
+    }
+    close(wakeupFD);
+    close(epollFD);
+}
+
+void Reactor::add(int fd, bool timer, Callback callback)
+{
+    if (watches.find(fd) != watches.end())
+        throw std::invalid_argument("this file descriptor is already watched");
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &event) == -1)
+        throw systemError("failed to watch file descriptor");
+
+    unique_ptr<Watch> watch(new Watch);
+    watch->fd = fd;
+    watch->timer = timer;
+    watch->callback = callback;
+    watches[fd] = move(watch);
+}
+
+void Reactor::remove(int fd)
+{
+    auto it = watches.find(fd);
+    if (it == watches.end())
+        return;
+
+    epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, nullptr);
+    // The watch's callback may be the one being called
+    removed.push_back(move(it->second));
+    watches.erase(it);
+}
+
+void Reactor::watch(int fd, Callback callback)
+{
+    add(fd, false, callback);
+}
+
+void Reactor::watch(canbus::Driver& driver, Dispatcher& dispatcher, Handler handler)
+{
+    Dispatcher* d = &dispatcher;
+    canbus::Driver* drv = &driver;
+    watch(driver.getFileDescriptor(), [drv, d, handler]() {
+        do {
+            canbus::Message msg = drv->read();
+            handler(msg, d->process(msg));
+        }
+        while (drv->getPendingMessagesCount() > 0);
+    });
+}
+
+void Reactor::watch(int fd, ReadFunction read, Dispatcher& dispatcher, Handler handler)
+{
+    Dispatcher* d = &dispatcher;
+    watch(fd, [read, d, handler]() {
+        canbus::Message msg = read();
+        handler(msg, d->process(msg));
+    });
+}
+
+void Reactor::unwatch(int fd)
+{
+    auto it = watches.find(fd);
+    if (it != watches.end() && !it->second->timer)
+        remove(fd);
+}
+
+int Reactor::addTimer(base::Time const& delay, base::Time const& period,
+                      Callback callback)
+{
+    if (delay.isNull())
+        throw std::invalid_argument("the timer delay must not be null");
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd == -1)
+        throw systemError("failed to create timer");
+
+    try {
+        add(fd, true, callback);
+        setTimer(fd, delay, period);
+    }
+    catch(...) {
+        remove(fd);
+        close(fd);
+        throw;
+    }
+    return fd;
+}
+
+Reactor::Watch& Reactor::getTimer(int timer)
+{
+    auto it = watches.find(timer);
+    if (it == watches.end() || !it->second->timer)
+        throw std::invalid_argument("no such timer");
+    return *it->second;
+}
+
+void Reactor::setTimer(int timer, base::Time const& delay, base::Time const& period)
+{
+    getTimer(timer);
+
+    itimerspec spec;
+    spec.it_value = toTimespec(delay);
+    spec.it_interval = toTimespec(period);
+    if (timerfd_settime(timer, 0, &spec, nullptr) == -1)
+        throw systemError("failed to set timer");
+}
+
+void Reactor::cancelTimer(int timer)
+{
+    setTimer(timer, base::Time());
+}
+
+void Reactor::removeTimer(int timer)
+{
+    auto it = watches.find(timer);
+    if (it == watches.end() || !it->second->timer)
+        return;
+
+    remove(timer);
+    close(timer);
+}
+
+size_t Reactor::runOnce(base::Time const& timeout)
+{
+    int timeoutMs = -1;
+    if (timeout != base::Time::max())
+        timeoutMs = (timeout.toMicroseconds() + 999) / 1000;
+
+    epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epollFD, events, MAX_EVENTS, timeoutMs);
+    if (count == -1) {
+        if (errno == EINTR)
+            return 0;
+        throw systemError("epoll_wait failed");
+    }
+
+    size_t called = 0;
+    for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == wakeupFD) {
+            uint64_t value;
+            while (read(wakeupFD, &value, sizeof(value)) > 0);
+            continue;
+        }
+
+        // The watch may have been removed by a previous callback
+        auto it = watches.find(fd);
+        if (it == watches.end())
+            continue;
+
+        Watch& watch = *it->second;
+        if (watch.timer) {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) == -1)
+                continue; // disarmed or re-armed since the event
+        }
+        watch.callback();
+        ++called;
+    }
+    removed.clear();
+    return called;
+}
+
+void Reactor::run()
+{
+    do {
+        runOnce();
+    }
+    while (!stopped);
+    stopped = false;
+}
+
+void Reactor::stop()
+{
+    stopped = true;
+    uint64_t value = 1;
+    if (write(wakeupFD, &value, sizeof(value)) == -1) {
+        // The counter can only overflow after 2^64 - 1 calls
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef CANOPEN_MASTER_REACTOR_HPP
+#define CANOPEN_MASTER_REACTOR_HPP
+
+#include <base/Time.hpp>
+#include <canbus.hh>
+#include <canopen_master/Dispatcher.hpp>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Single-threaded event loop based on epoll
+     *
+     * It waits at the same time on file descriptors, such as the CAN
+     * driver's, and on timers based on timerfd, e.g. to produce SYNCs or
+     * detect missing heartbeats and SDO replies. The thread sleeps until
+     * an event happens, and timers have the resolution of the kernel's
+     * high-resolution timers.
+     *
+     * ~~~ cpp
+     * Reactor reactor;
+     * reactor.watch(*device, dispatcher, [&](canbus::Message const& msg,
+     *                                        StateMachine::Update const& update) {
+     *     ...
+     * });
+     * reactor.addTimer(base::Time::fromMilliseconds(10), base::Time::fromMilliseconds(10),
+     *                  [&]() { device->write(makeSyncMessage(0, base::Time::now())); });
+     * reactor.run();
+     * ~~~
+     *
+     * All callbacks are called from the thread calling run() or runOnce().
+     * Callbacks may add or remove watches and timers, including their
+     * own. Only stop() may be called from another thread.
+     */
+    class Reactor
+    {
+    public:
+        typedef std::function<void()> Callback;
+
+        /** Called for each frame processed by a dispatcher watch */
+        typedef std::function<void(canbus::Message const&,
+                                   StateMachine::Update const&)> Handler;
+
+        /** Function reading one frame */
+        typedef std::function<canbus::Message()> ReadFunction;
+
+        /** @throw std::runtime_error if the epoll instance cannot be created */
+        Reactor();
+        ~Reactor();
+
+        Reactor(Reactor const&) = delete;
+        Reactor& operator =(Reactor const&) = delete;
+
+        /** Call the callback whenever the file descriptor is readable
+         *
+         * @throw std::invalid_argument if the descriptor is already watched
+         * @throw std::runtime_error if epoll refuses it
+         */
+        void watch(int fd, Callback callback);
+
+        /** Read the frames of a CAN driver as they arrive, process them
+         * with the dispatcher and pass the result to the handler
+         *
+         * Frames buffered by the driver (see
+         * canbus::Driver::getPendingMessagesCount) are processed as well
+         */
+        void watch(canbus::Driver& driver, Dispatcher& dispatcher, Handler handler);
+
+        /** Same as watch(driver, ...) for a source that is not a
+         * canbus::Driver. read is called once each time fd is readable */
+        void watch(int fd, ReadFunction read, Dispatcher& dispatcher, Handler handler);
+
+        /** Stop watching a file descriptor. Does nothing if it is not
+         * watched */
+        void unwatch(int fd);
+
+        /** Create a timer
+         *
+         * @arg delay time until the first expiration. Must not be null
+         * @arg period the period after the first expiration, or a null
+         *   time for a one-shot timer
+         * @return the timer ID
+         */
+        int addTimer(base::Time const& delay, base::Time const& period,
+                     Callback callback);
+
+        /** Re-arm a timer. A null delay disarms it
+         *
+         * This is meant for timeouts, which are re-armed at each
+         * activity, such as SDO reply or heartbeat timeouts
+         */
+        void setTimer(int timer, base::Time const& delay,
+                      base::Time const& period = base::Time());
+
+        /** Disarm a timer without removing it */
+        void cancelTimer(int timer);
+
+        /** Remove a timer. Does nothing if it does not exist */
+        void removeTimer(int timer);
+
+        /** Wait for events and call their callbacks
+         *
+         * @arg timeout how long to wait for events. A null time does not
+         *   wait, base::Time::max() waits indefinitely
+         * @return the number of callbacks called
+         */
+        size_t runOnce(base::Time const& timeout = base::Time::max());
+
+        /** Process events until stop() is called
+         *
+         * If stop() has been called since the last run(), it returns
+         * after the first iteration
+         */
+        void run();
+
+        /** Make run() return. It can be called from any thread */
+        void stop();
+
+    private:
+        struct Watch
+        {
+            int fd;
+            bool timer;
+            Callback callback;
+        };
+
+        static const int MAX_EVENTS = 64;
+
+        int epollFD;
+        int wakeupFD;
+        std::atomic<bool> stopped;
+        std::map<int, std::unique_ptr<Watch>> watches;
+        /** Watches removed while processing events, deleted once the
+         * processing is done */
+        std::vector<std::unique_ptr<Watch>> removed;
+
+        void add(int fd, bool timer, Callback callback);
+        void remove(int fd);
+        Watch& getTimer(int timer);
+    };
+}
+
+#endif
@@ -0,0 +1,397 @@
+#include <canopen_master/Replay.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace canopen_master;
+
+unique_ptr<ReplayLog> ReplayLog::open(string const& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        throw std::runtime_error("failed to open " + path);
+
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if (file && magic == frame_recorder::MAGIC)
+        return unique_ptr<ReplayLog>(new RecordingReplayLog(path));
+    return unique_ptr<ReplayLog>(new CandumpReplayLog(path));
+}
+
+RecordingReplayLog::RecordingReplayLog(string const& path)
+    : reader(path)
+{
+}
+
+bool RecordingReplayLog::next(canbus::Message& msg)
+{
+    if (position == reader.size())
+        return false;
+    msg = reader.get(position++).toMessage();
+    return true;
+}
+
+uint64_t RecordingReplayLog::tell() const
+{
+    return position;
+}
+
+void RecordingReplayLog::seek(uint64_t position)
+{
+    this->position = position;
+}
+
+CandumpReplayLog::CandumpReplayLog(string const& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw std::runtime_error("failed to open " + path + ": " + strerror(errno));
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::runtime_error("failed to stat " + path + ": " + strerror(errno));
+    }
+    size = info.st_size;
+    if (size == 0) {
+        close(fd);
+        return;
+    }
+
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("failed to map " + path + ": " + strerror(errno));
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    begin = static_cast<char const*>(mapping);
+}
+
+CandumpReplayLog::~CandumpReplayLog()
+{
+    if (mapping)
+        munmap(mapping, size);
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    else if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/** Parse a line of a candump log, without its end-of-line */
+static bool parseCandumpLine(char const* it, char const* end, canbus::Message& msg)
+{
+    if (it == end || *it++ != '(')
+        return false;
+    uint64_t seconds = 0;
+    char const* digits = it;
+    for (; it != end && *it >= '0' && *it <= '9'; ++it)
+        seconds = seconds * 10 + (*it - '0');
+    if (it == digits || it == end || *it++ != '.')
+        return false;
+    uint64_t microseconds = 0;
+    int fractionDigits = 0;
+    for (; it != end && *it >= '0' && *it <= '9'; ++it, ++fractionDigits) {
+        if (fractionDigits < 6)
+            microseconds = microseconds * 10 + (*it - '0');
+    }
+    if (fractionDigits == 0 || it == end || *it++ != ')')
+        return false;
+    for (; fractionDigits < 6; ++fractionDigits)
+        microseconds *= 10;
+
+    // Interface name
+    while (it != end && *it == ' ')
+        ++it;
+    while (it != end && *it != ' ')
+        ++it;
+    while (it != end && *it == ' ')
+        ++it;
+
+    uint32_t canId = 0;
+    int idDigits = 0;
+    for (; it != end && hexDigit(*it) >= 0; ++it, ++idDigits)
+        canId = canId << 4 | hexDigit(*it);
+    if ((idDigits != 3 && idDigits != 8) || it == end || *it++ != '#')
+        return false;
+
+    msg = canbus::Message::Zeroed();
+    msg.time = base::Time::fromMicroseconds(seconds * 1000000 + microseconds);
+    msg.can_id = canId;
+    if (it != end && *it == 'R')
+        return true;
+
+    while (it != end && *it != ' ' && *it != '\r') {
+        if (end - it < 2 || msg.size == 8)
+            return false;
+        int high = hexDigit(it[0]), low = hexDigit(it[1]);
+        if (high < 0 || low < 0)
+            return false;
+        msg.data[msg.size++] = high << 4 | low;
+        it += 2;
+    }
+    return true;
+}
+
+bool CandumpReplayLog::next(canbus::Message& msg)
+{
+    while (position < size) {
+        char const* line = begin + position;
+        char const* end = static_cast<char const*>(
+            memchr(line, '\n', size - position));
+        bool complete = (end != nullptr);
+        if (!complete)
+            end = begin + size;
+        position = end - begin + complete;
+
+        if (end == line || (end - line == 1 && *line == '\r'))
+            continue;
+        if (parseCandumpLine(line, end, msg))
+            return true;
+        // A crash can leave a partially written last line
+        if (!complete)
+            return false;
+        throw std::runtime_error("invalid candump line at offset " +
+                                 to_string(line - begin) + ": " + string(line, end));
+    }
+    return false;
+}
+
+uint64_t CandumpReplayLog::tell() const
+{
+    return position;
+}
+
+void CandumpReplayLog::seek(uint64_t position)
+{
+    this->position = position;
+}
+
+Replay::Replay(ReplayLog& log, base::Time checkpointPeriod)
+    : log(log)
+    , checkpointPeriod(checkpointPeriod)
+{
+    uint64_t position = log.tell();
+    canbus::Message msg;
+    if (log.next(msg))
+        startTime = msg.time;
+    log.seek(position);
+}
+
+StateMachine& Replay::addNode(uint8_t nodeId)
+{
+    if (nodeId == 0 || nodeId > 127)
+        throw std::invalid_argument("invalid node ID " + to_string(nodeId));
+    if (!nodes[nodeId]) {
+        nodes[nodeId].reset(new StateMachine(nodeId));
+        nodes[nodeId]->setThrowOnDeviceErrors(false);
+        dispatcher.add(*nodes[nodeId]);
+    }
+    return *nodes[nodeId];
+}
+
+StateMachine* Replay::getNode(uint8_t nodeId) const
+{
+    if (nodeId > 127)
+        return nullptr;
+    return nodes[nodeId].get();
+}
+
+void Replay::setAutoAddNodes(bool enable)
+{
+    autoAddNodes = enable;
+}
+
+void Replay::setHandler(Handler handler)
+{
+    this->handler = handler;
+}
+
+base::Time Replay::getStartTime() const
+{
+    return startTime;
+}
+
+base::Time Replay::getTime() const
+{
+    return time;
+}
+
+uint64_t Replay::getFrameCount() const
+{
+    return frameCount;
+}
+
+uint64_t Replay::getErrorCount() const
+{
+    return errorCount;
+}
+
+size_t Replay::getCheckpointCount() const
+{
+    return checkpoints.size();
+}
+
+void Replay::start()
+{
+    // The first checkpoint is the configured nodes, before any frame
+    if (checkpoints.empty())
+        checkpoint();
+}
+
+void Replay::checkpoint()
+{
+    Checkpoint checkpoint;
+    checkpoint.time = time;
+    checkpoint.position = log.tell();
+    checkpoint.frameCount = frameCount;
+    for (auto const& node : nodes) {
+        if (node)
+            checkpoint.nodes.push_back(*node);
+    }
+    checkpoints.push_back(move(checkpoint));
+}
+
+void Replay::restore(Checkpoint const& checkpoint)
+{
+    for (uint8_t id = 1; id < 128; ++id) {
+        auto it = find_if(checkpoint.nodes.begin(), checkpoint.nodes.end(),
+            [id](StateMachine const& node) { return node.getNodeID() == id; });
+        if (it != checkpoint.nodes.end())
+            addNode(id) = *it;
+        else if (nodes[id]) {
+            dispatcher.remove(id);
+            nodes[id].reset();
+        }
+    }
+    log.seek(checkpoint.position);
+    time = checkpoint.time;
+    frameCount = checkpoint.frameCount;
+}
+
+/** Whether the frame is one a node sends with its own node ID in the COB-ID,
+ * i.e. one that can be used to discover the node
+ */
+static bool isNodeTransmission(canbus::Message const& msg)
+{
+    if (msg.can_id > 0x7FF || getNodeID(msg) == 0)
+        return false;
+
+    switch (getFunctionCode(msg)) {
+        case FUNCTION_EMERGENCY:
+        case FUNCTION_PDO0_TRANSMIT:
+        case FUNCTION_PDO1_TRANSMIT:
+        case FUNCTION_PDO2_TRANSMIT:
+        case FUNCTION_PDO3_TRANSMIT:
+        case FUNCTION_SDO_TRANSMIT:
+        case FUNCTION_NMT_HEARTBEAT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Replay::process(canbus::Message const& msg)
+{
+    StateMachine::Update update;
+    bool processed = false;
+    try {
+        update = dispatcher.process(msg);
+        if (update.mode == StateMachine::PROCESSED_NOT_FOR_ME &&
+            autoAddNodes && isNodeTransmission(msg)) {
+            update = addNode(getNodeID(msg)).process(msg);
+        }
+        processed = true;
+    }
+    catch(std::exception const&) {
+        ++errorCount;
+    }
+
+    ++frameCount;
+    time = msg.time;
+    Checkpoint const& last = checkpoints.back();
+    if (log.tell() > last.position) {
+        base::Time reference = last.frameCount == 0 ? startTime : last.time;
+        if (time - reference >= checkpointPeriod)
+            checkpoint();
+    }
+
+    if (processed && handler)
+        handler(msg, update);
+}
+
+bool Replay::nextUntil(base::Time const& until, canbus::Message& msg)
+{
+    uint64_t position = log.tell();
+    if (!log.next(msg))
+        return false;
+    if (msg.time > until) {
+        log.seek(position);
+        return false;
+    }
+    return true;
+}
+
+bool Replay::step()
+{
+    start();
+    canbus::Message msg;
+    if (!log.next(msg))
+        return false;
+    process(msg);
+    return true;
+}
+
+uint64_t Replay::run(double speed, base::Time const& until)
+{
+    start();
+    auto wallStart = chrono::steady_clock::now();
+    base::Time logStart;
+
+    uint64_t count = 0;
+    canbus::Message msg;
+    while (nextUntil(until, msg)) {
+        if (speed > 0) {
+            if (logStart.isNull())
+                logStart = msg.time;
+            chrono::microseconds elapsed(
+                static_cast<int64_t>((msg.time - logStart).toMicroseconds() / speed));
+            this_thread::sleep_until(wallStart + elapsed);
+        }
+        process(msg);
+        ++count;
+    }
+    return count;
+}
+
+void Replay::seek(base::Time const& time)
+{
+    start();
+    // Last checkpoint before the requested time. The first one is before
+    // any frame
+    auto it = upper_bound(checkpoints.begin() + 1, checkpoints.end(), time,
+        [](base::Time const& time, Checkpoint const& checkpoint) {
+            return time < checkpoint.time;
+        });
+    Checkpoint const& checkpoint = *(it - 1);
+    if (this->time > time || checkpoint.frameCount > frameCount)
+        restore(checkpoint);
+
+    canbus::Message msg;
+    while (nextUntil(time, msg))
+        process(msg);
+}
@@ -0,0 +1,202 @@
+#ifndef CANOPEN_MASTER_REPLAY_HPP
+#define CANOPEN_MASTER_REPLAY_HPP
+
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/FrameRecorder.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace canopen_master
+{
+    /** A recorded bus log, read frame by frame */
+    class ReplayLog
+    {
+    public:
+        virtual ~ReplayLog() {}
+
+        /** Read the next frame
+         *
+         * @return false at the end of the log
+         */
+        virtual bool next(canbus::Message& msg) = 0;
+
+        /** Position of the next frame, to be passed to seek. Positions
+         * increase along the log */
+        virtual uint64_t tell() const = 0;
+
+        /** Go back to a position returned by tell */
+        virtual void seek(uint64_t position) = 0;
+
+        /** Open a FrameRecorder recording or a candump log, depending on
+         * the contents of the file
+         *
+         * @throw std::runtime_error if the file cannot be opened
+         */
+        static std::unique_ptr<ReplayLog> open(std::string const& path);
+    };
+
+    /** A recording made by FrameRecorder, from its oldest frame */
+    class RecordingReplayLog : public ReplayLog
+    {
+    public:
+        explicit RecordingReplayLog(std::string const& path);
+
+        bool next(canbus::Message& msg) override;
+        uint64_t tell() const override;
+        void seek(uint64_t position) override;
+
+    private:
+        FrameRecordReader reader;
+        uint64_t position = 0;
+    };
+
+    /** A log in the format of `candump -l`
+     *
+     * Each line is a frame, as `(1436509052.249713) can0 181#0102030405`.
+     * Remote frames (`181#R`) are read as frames without data, and a
+     * truncated last line is ignored. The file is memory-mapped and parsed
+     * as it is read, so opening even a large log is immediate.
+     */
+    class CandumpReplayLog : public ReplayLog
+    {
+    public:
+        explicit CandumpReplayLog(std::string const& path);
+        ~CandumpReplayLog();
+
+        CandumpReplayLog(CandumpReplayLog const&) = delete;
+        CandumpReplayLog& operator =(CandumpReplayLog const&) = delete;
+
+        /** @throw std::runtime_error on a line that is not a CAN frame */
+        bool next(canbus::Message& msg) override;
+        uint64_t tell() const override;
+        void seek(uint64_t position) override;
+
+    private:
+        void* mapping = nullptr;
+        char const* begin = nullptr;
+        size_t size = 0;
+        size_t position = 0;
+    };
+
+    /** Rebuilds the state of the nodes of a bus from a recorded log
+     *
+     * The frames of the log are processed by one StateMachine per node,
+     * owned by the replay, as fast as possible or at a multiple of the
+     * recorded rate. Nodes are created the first time they send a frame,
+     * or explicitly with addNode, which allows to configure them (e.g.
+     * declare their PDO mappings) before the replay starts. Device errors
+     * are reported as updates, and frames that fail to process are counted
+     * by getErrorCount.
+     *
+     * While the log is replayed for the first time, the replay copies the
+     * state machines at regular intervals of log time. seek() restarts
+     * from the closest of these checkpoints instead of from the start of
+     * the log:
+     *
+     * ~~~ cpp
+     * auto log = ReplayLog::open("can0.log");
+     * Replay replay(*log);
+     * replay.addNode(2).declareTPDOMapping(0, mapping);
+     * replay.run();
+     * replay.seek(replay.getStartTime() + base::Time::fromSeconds(3600));
+     * replay.getNode(2)->get<uint16_t>(0x6041, 0);
+     * ~~~
+     *
+     * Nodes must be added and configured before the first frame is
+     * replayed, as seek restores them as they were in the checkpoint.
+     */
+    class Replay
+    {
+    public:
+        typedef std::function<void(canbus::Message const&,
+                                   StateMachine::Update const&)> Handler;
+
+        /** @arg checkpointPeriod log time between two checkpoints */
+        explicit Replay(ReplayLog& log,
+                        base::Time checkpointPeriod = base::Time::fromSeconds(10));
+
+        Replay(Replay const&) = delete;
+        Replay& operator =(Replay const&) = delete;
+
+        /** The state machine of the given node, created if needed */
+        StateMachine& addNode(uint8_t nodeId);
+
+        /** The state machine of the given node, or nullptr */
+        StateMachine* getNode(uint8_t nodeId) const;
+
+        /** Whether nodes are created the first time they send a frame.
+         * Enabled by default
+         *
+         * Only EMCY, TPDO, SDO replies and heartbeats create nodes. Frames
+         * whose COB-ID is not node-addressed, e.g. LSS, do not */
+        void setAutoAddNodes(bool enable);
+
+        /** Called with each processed frame and its update */
+        void setHandler(Handler handler);
+
+        /** Time of the first frame of the log, null if the log is empty */
+        base::Time getStartTime() const;
+
+        /** Time of the last processed frame, null if none has been */
+        base::Time getTime() const;
+
+        /** Number of frames processed to reach the current state */
+        uint64_t getFrameCount() const;
+
+        /** Number of frames whose processing threw */
+        uint64_t getErrorCount() const;
+
+        size_t getCheckpointCount() const;
+
+        /** Process the next frame
+         *
+         * @return false at the end of the log
+         */
+        bool step();
+
+        /** Process frames up to the given time, or the end of the log
+         *
+         * @arg speed the replay rate relative to the recorded rate, or zero
+         *   to process the frames as fast as possible
+         * @return the number of frames processed
+         */
+        uint64_t run(double speed = 0, base::Time const& until = base::Time::max());
+
+        /** Rebuild the state of the nodes at the given time, i.e. after
+         * processing all the frames received until then */
+        void seek(base::Time const& time);
+
+    private:
+        struct Checkpoint
+        {
+            base::Time time;
+            uint64_t position;
+            uint64_t frameCount;
+            std::vector<StateMachine> nodes;
+        };
+
+        ReplayLog& log;
+        base::Time checkpointPeriod;
+        Dispatcher dispatcher;
+        std::unique_ptr<StateMachine> nodes[128];
+        bool autoAddNodes = true;
+        Handler handler;
+
+        base::Time startTime;
+        base::Time time;
+        uint64_t frameCount = 0;
+        uint64_t errorCount = 0;
+        std::vector<Checkpoint> checkpoints;
+
+        void start();
+        void process(canbus::Message const& msg);
+        void checkpoint();
+        void restore(Checkpoint const& checkpoint);
+        /** Read the next frame if it was received until the given time */
+        bool nextUntil(base::Time const& until, canbus::Message& msg);
+    };
+}
+
+#endif
@@ -0,0 +1,156 @@
+#include <canopen_master/SDOClient.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/SDO.hpp>
+#include <sstream>
+
+using namespace std;
+using namespace canopen_master;
+
+SDOClient::SDOClient(StateMachine& machine, WriteFunction write)
+    : mMachine(machine)
+    , mWrite(write)
+{
+}
+
+StateMachine& SDOClient::getStateMachine() const
+{
+    return mMachine;
+}
+
+void SDOClient::setTimeout(base::Time const& timeout)
+{
+    mTimeout = timeout;
+}
+
+base::Time SDOClient::getTimeout() const
+{
+    return mTimeout;
+}
+
+void SDOClient::upload(uint16_t objectId, uint8_t subId, Completion completion)
+{
+    queue(mMachine.upload(objectId, subId), true, completion);
+}
+
+void SDOClient::download(uint16_t objectId, uint8_t subId,
+                         uint8_t const* data, uint32_t size,
+                         Completion completion)
+{
+    download(mMachine.download(objectId, subId, data, size), completion);
+}
+
+void SDOClient::download(canbus::Message const& request, Completion completion)
+{
+    queue(request, false, completion);
+}
+
+void SDOClient::queue(canbus::Message const& request, bool upload,
+                      Completion completion)
+{
+    Transaction transaction = { request, upload, completion };
+    mTransactions.push_back(transaction);
+    if (mTransactions.size() == 1 && !mCompleting)
+        send();
+}
+
+void SDOClient::send()
+{
+    mSentTime = mMachine.now();
+    try {
+        mWrite(mTransactions.front().request);
+        mMachine.notifySent(mTransactions.front().request, mSentTime);
+    }
+    catch(...) {
+        complete(current_exception());
+    }
+}
+
+bool SDOClient::matches(uint16_t objectId, uint8_t subId) const
+{
+    if (mTransactions.empty())
+        return false;
+
+    canbus::Message const& request = mTransactions.front().request;
+    return getSDOObjectID(request) == objectId &&
+        getSDOObjectSubID(request) == subId;
+}
+
+StateMachine::Update SDOClient::process(canbus::Message const& msg)
+{
+    StateMachine::Update update;
+    try {
+        update = mMachine.process(msg);
+    }
+    catch(SDODomainTransferAborted const& e) {
+        if (!matches(e.objectId, e.subId))
+            throw;
+        complete(current_exception());
+        return StateMachine::Update(StateMachine::PROCESSED_SDO_ABORT,
+                                    e.objectId, e.subId);
+    }
+    process(update);
+    return update;
+}
+
+void SDOClient::process(StateMachine::Update const& update)
+{
+    if (update.update_count == 0 || mTransactions.empty())
+        return;
+
+    uint16_t objectId = update.updated[0].first;
+    uint8_t subId = update.updated[0].second;
+    if (!matches(objectId, subId))
+        return;
+
+    bool upload = mTransactions.front().upload;
+    if (update.mode == StateMachine::PROCESSED_SDO && upload)
+        complete(exception_ptr());
+    else if (update.mode == StateMachine::PROCESSED_SDO_INITIATE_DOWNLOAD && !upload)
+        complete(exception_ptr());
+    else if (update.mode == StateMachine::PROCESSED_SDO_ABORT) {
+        complete(make_exception_ptr(SDODomainTransferAborted(
+            objectId, subId, mMachine.getLastSDOAbortCode())));
+    }
+}
+
+void SDOClient::checkTimeouts(base::Time const& now)
+{
+    if (mTransactions.empty() || now - mSentTime < mTimeout)
+        return;
+
+    canbus::Message const& request = mTransactions.front().request;
+    std::ostringstream message;
+    message << std::hex << "no reply from node " << static_cast<int>(mMachine.getNodeID())
+        << " for object 0x" << getSDOObjectID(request)
+        << "/" << static_cast<int>(getSDOObjectSubID(request));
+    complete(make_exception_ptr(SDOTimeout(message.str())));
+}
+
+size_t SDOClient::getPendingCount() const
+{
+    return mTransactions.size();
+}
+
+void SDOClient::complete(exception_ptr error)
+{
+    Completion completion = mTransactions.front().completion;
+    mTransactions.pop_front();
+
+    // Transactions queued by the completion are sent after the ones that
+    // were already queued. If sending the next request fails, its own
+    // completion must only run after this one
+    mCompleting = true;
+    try {
+        if (completion)
+            completion(error);
+    }
+    catch(...) {
+        mCompleting = false;
+        if (!mTransactions.empty())
+            send();
+        throw;
+    }
+    mCompleting = false;
+    if (!mTransactions.empty())
+        send();
+}
@@ -0,0 +1,132 @@
+#ifndef CANOPEN_MASTER_SDO_CLIENT_HPP
+#define CANOPEN_MASTER_SDO_CLIENT_HPP
+
+#include <canopen_master/StateMachine.hpp>
+#include <deque>
+#include <exception>
+#include <functional>
+
+namespace canopen_master
+{
+    /** Queue of the SDO transactions of a single node
+     *
+     * Transactions are sent one at a time, as a SDO server handles only one
+     * request at a time. The completion callback of a transaction is
+     * called when the matching reply is processed, with a null exception
+     * on success, or with SDODomainTransferAborted or SDOTimeout. Uploaded
+     * values are available in the state machine's dictionary by then.
+     *
+     * Completion callbacks are called from process() and checkTimeouts(),
+     * before the next queued request is sent. They may queue new
+     * transactions, which allows to write sequential device configuration
+     * without threads, and to interleave the configuration of many nodes
+     * on a single thread. See also SDOCoroutine.hpp.
+     *
+     * If writing a request throws, its transaction completes with the
+     * exception, possibly from within upload() or download().
+     *
+     * ~~~ cpp
+     * SDOClient sdo(machine, [&](canbus::Message const& msg) { device->write(msg); });
+     * sdo.upload<DeviceType>([&](std::exception_ptr error) {
+     *     if (!error)
+     *         sdo.download<ProducerHeartbeatTime>(100, ...);
+     * });
+     * ...
+     * sdo.process(device->read());
+     * ~~~
+     */
+    class SDOClient
+    {
+    public:
+        typedef std::function<void(canbus::Message const&)> WriteFunction;
+
+        /** Called when a transaction ends. The exception is null on success */
+        typedef std::function<void(std::exception_ptr)> Completion;
+
+        SDOClient(StateMachine& machine, WriteFunction write);
+
+        StateMachine& getStateMachine() const;
+
+        /** Time after which a request without reply fails with SDOTimeout
+         *
+         * Defaults to 100ms
+         */
+        void setTimeout(base::Time const& timeout);
+        base::Time getTimeout() const;
+
+        /** Queue the upload (= read from slave) of an object */
+        void upload(uint16_t objectId, uint8_t subId, Completion completion);
+
+        template<typename T>
+        void upload(Completion completion, int offsetId = 0, int offsetSubId = 0) {
+            upload(T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId,
+                   completion);
+        }
+
+        /** Queue the download (= write to slave) of an object */
+        void download(uint16_t objectId, uint8_t subId,
+                      uint8_t const* data, uint32_t size,
+                      Completion completion);
+
+        template<typename T>
+        void download(typename T::OBJECT_TYPE value, Completion completion,
+                      int offsetId = 0, int offsetSubId = 0) {
+            download(mMachine.download(T::OBJECT_ID + offsetId,
+                                       T::OBJECT_SUB_ID + offsetSubId, value),
+                     completion);
+        }
+
+        /** Queue a download request built with StateMachine::download */
+        void download(canbus::Message const& request, Completion completion);
+
+        /** Process a frame with the state machine, and complete the
+         * current transaction if it is its reply
+         *
+         * SDODomainTransferAborted thrown by the state machine for the
+         * current transaction is passed to its completion instead, and
+         * reported as PROCESSED_SDO_ABORT
+         */
+        StateMachine::Update process(canbus::Message const& msg);
+
+        /** Complete the current transaction if the update, returned by
+         * StateMachine::process, is its reply
+         *
+         * Use this instead of process(msg) when the frames are processed
+         * elsewhere, e.g. by a Dispatcher. Aborts are only reported this
+         * way if the state machine does not throw on device errors (see
+         * StateMachine::setThrowOnDeviceErrors)
+         */
+        void process(StateMachine::Update const& update);
+
+        /** Fail the current transaction with SDOTimeout if it has been
+         * sent for longer than the timeout */
+        void checkTimeouts(base::Time const& now);
+
+        /** Number of queued transactions, including the current one */
+        size_t getPendingCount() const;
+
+    private:
+        struct Transaction
+        {
+            canbus::Message request;
+            bool upload;
+            Completion completion;
+        };
+
+        StateMachine& mMachine;
+        WriteFunction mWrite;
+        base::Time mTimeout = base::Time::fromMilliseconds(100);
+        std::deque<Transaction> mTransactions;
+        base::Time mSentTime;
+        /** Set while a completion runs, to defer sending */
+        bool mCompleting = false;
+
+        void queue(canbus::Message const& request, bool upload,
+                   Completion completion);
+        void send();
+        bool matches(uint16_t objectId, uint8_t subId) const;
+        void complete(std::exception_ptr error);
+    };
+}
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef CANOPEN_MASTER_SDO_COROUTINE_HPP
+#define CANOPEN_MASTER_SDO_COROUTINE_HPP
+
+#if !defined(__cpp_impl_coroutine)
+#error "canopen_master/SDOCoroutine.hpp requires a compiler in C++20 mode"
+#endif
+
+#include <canopen_master/SDOClient.hpp>
+#include <coroutine>
+#include <stdexcept>
+#include <utility>
+
+namespace canopen_master
+{
+    /** Coroutine performing SDO transactions through SDOClient
+     *
+     * The library itself is C++11, this header is only usable from code
+     * compiled as C++20. A SDOTask starts immediately and runs until its
+     * first co_await. It is then resumed from SDOClient::process when the
+     * reply arrives, so the tasks of many nodes interleave on the thread
+     * that processes the frames:
+     *
+     * ~~~ cpp
+     * SDOTask bringUp(SDOClient& sdo) {
+     *     uint32_t deviceType = co_await upload<DeviceType>(sdo);
+     *     if (deviceType != 0x20192)
+     *         throw std::runtime_error("unexpected device");
+     *     co_await download<ProducerHeartbeatTime>(sdo, 100);
+     * }
+     *
+     * SDOTask task = bringUp(sdo);
+     * while (!task.isDone())
+     *     sdo.process(device->read());
+     * task.get(); // rethrows errors, e.g. SDODomainTransferAborted
+     * ~~~
+     *
+     * Tasks can co_await other tasks. A task must not be destroyed while it
+     * waits for a SDO reply.
+     */
+    class SDOTask
+    {
+    public:
+        struct promise_type;
+        typedef std::coroutine_handle<promise_type> Handle;
+
+        /** Resumes the task awaiting this one, if any */
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                if (continuation)
+                    return continuation;
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        struct promise_type
+        {
+            std::exception_ptr error;
+            std::coroutine_handle<> continuation;
+
+            SDOTask get_return_object() {
+                return SDOTask(Handle::from_promise(*this));
+            }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void return_void() const {}
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        SDOTask(SDOTask&& other) noexcept
+            : handle(other.handle) {
+            other.handle = Handle();
+        }
+        SDOTask& operator =(SDOTask&& other) noexcept {
+            std::swap(handle, other.handle);
+            return *this;
+        }
+        SDOTask(SDOTask const&) = delete;
+        SDOTask& operator =(SDOTask const&) = delete;
+
+        ~SDOTask() {
+            if (handle)
+                handle.destroy();
+        }
+
+        /** Whether the coroutine has finished, successfully or not */
+        bool isDone() const { return handle.done(); }
+
+        /** Rethrow the exception that ended the coroutine, if any
+         *
+         * @throw std::logic_error if it has not finished yet
+         */
+        void get() const {
+            if (!isDone())
+                throw std::logic_error("SDOTask::get called on a running task");
+            if (handle.promise().error)
+                std::rethrow_exception(handle.promise().error);
+        }
+
+        bool await_ready() const noexcept { return isDone(); }
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+        }
+        void await_resume() const { get(); }
+
+    private:
+        explicit SDOTask(Handle handle)
+            : handle(handle) {}
+
+        Handle handle;
+    };
+
+    /** Awaitable of a single SDO transaction */
+    class SDOAwaiter
+    {
+    public:
+        /** Queue an upload */
+        SDOAwaiter(SDOClient& client, uint16_t objectId, uint8_t subId)
+            : client(client)
+            , objectId(objectId)
+            , subId(subId) {}
+
+        /** Queue a download request built with StateMachine::download */
+        SDOAwaiter(SDOClient& client, canbus::Message const& download)
+            : client(client)
+            , isDownload(true)
+            , request(download) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            auto completion = [this, awaiting](std::exception_ptr error) {
+                this->error = error;
+                completed = true;
+                if (suspended)
+                    awaiting.resume();
+            };
+            if (isDownload)
+                client.download(request, completion);
+            else
+                client.upload(objectId, subId, completion);
+
+            // The transaction completes synchronously e.g. if writing the
+            // request failed. Do not suspend in this case
+            suspended = !completed;
+            return suspended;
+        }
+        void await_resume() const {
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+    protected:
+        SDOClient& client;
+        bool isDownload = false;
+        uint16_t objectId = 0;
+        uint8_t subId = 0;
+        canbus::Message request;
+        std::exception_ptr error;
+        bool completed = false;
+        bool suspended = false;
+    };
+
+    /** Awaitable of an upload that returns the uploaded value */
+    template<typename T>
+    class SDOUploadAwaiter : public SDOAwaiter
+    {
+    public:
+        SDOUploadAwaiter(SDOClient& client, uint16_t objectId, uint8_t subId)
+            : SDOAwaiter(client, objectId, subId) {}
+
+        typename T::OBJECT_TYPE await_resume() const {
+            SDOAwaiter::await_resume();
+            return client.getStateMachine().template get<typename T::OBJECT_TYPE>(
+                objectId, subId);
+        }
+    };
+
+    /** Upload an object, and return its value */
+    template<typename T>
+    SDOUploadAwaiter<T> upload(SDOClient& client, int offsetId = 0, int offsetSubId = 0) {
+        return SDOUploadAwaiter<T>(client, T::OBJECT_ID + offsetId,
+                                   T::OBJECT_SUB_ID + offsetSubId);
+    }
+
+    /** Upload an object. Its value is then available in the dictionary */
+    inline SDOAwaiter upload(SDOClient& client, uint16_t objectId, uint8_t subId) {
+        return SDOAwaiter(client, objectId, subId);
+    }
+
+    /** Download an object */
+    template<typename T>
+    SDOAwaiter download(SDOClient& client, typename T::OBJECT_TYPE value,
+                        int offsetId = 0, int offsetSubId = 0) {
+        return SDOAwaiter(client, client.getStateMachine().download(
+            T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId, value));
+    }
+}
+
+#endif
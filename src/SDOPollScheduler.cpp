@@ -0,0 +1,206 @@
+#include <canopen_master/SDOPollScheduler.hpp>
+#include <algorithm>
+
+using namespace std;
+using namespace canopen_master;
+
+/** A SDO transaction is the request and its reply */
+static const double SDO_TRANSACTION_BITS = 2 * SDOPollScheduler::SDO_FRAME_BITS;
+/** Assumed size of the reserved frames, see setReservedFramesPerSecond */
+static const double RESERVED_FRAME_BITS = SDOPollScheduler::SDO_FRAME_BITS;
+/** Maximum burst, as a duration worth of polling budget */
+static const double MAX_BURST_SECONDS = 0.01;
+
+const int SDOPollScheduler::NO_PENDING;
+
+SDOPollScheduler::SDOPollScheduler(uint32_t bitrate, double maxBusLoad)
+    : bitrate(bitrate)
+    , maxBusLoad(maxBusLoad)
+{
+    if (maxBusLoad <= 0 || maxBusLoad > 1)
+        throw std::invalid_argument("maxBusLoad must be in ]0, 1]");
+    fill(pending, pending + 128, NO_PENDING);
+}
+
+void SDOPollScheduler::setReservedFramesPerSecond(double fps)
+{
+    reservedFPS = fps;
+}
+
+void SDOPollScheduler::setSDOTimeout(base::Time const& timeout)
+{
+    sdoTimeout = timeout;
+}
+
+double SDOPollScheduler::getTransactionsPerSecond() const
+{
+    double bits = bitrate * maxBusLoad - reservedFPS * RESERVED_FRAME_BITS;
+    return max(0.0, bits / SDO_TRANSACTION_BITS);
+}
+
+void SDOPollScheduler::add(StateMachine const& node, uint16_t objectId, uint8_t subId,
+                           base::Time const& period, int priority)
+{
+    if (period.isNull())
+        throw std::invalid_argument("polling period must be non-zero");
+    if (node.getNodeID() > 127)
+        throw std::invalid_argument("invalid node ID");
+
+    ObjectStatus status;
+    status.nodeId = node.getNodeID();
+    status.objectId = objectId;
+    status.subId = subId;
+    status.period = period;
+    status.priority = priority;
+    objects.push_back(status);
+    nodes.push_back(&node);
+}
+
+void SDOPollScheduler::refill(base::Time const& now)
+{
+    double rate = getTransactionsPerSecond() * SDO_TRANSACTION_BITS;
+    double burst = max(SDO_TRANSACTION_BITS, rate * MAX_BURST_SECONDS);
+    if (lastRefill.isNull())
+        tokens = burst;
+    else if (now > lastRefill)
+        tokens = min(burst, tokens + (now - lastRefill).toSeconds() * rate);
+    lastRefill = now;
+}
+
+void SDOPollScheduler::checkTimeouts(base::Time const& now)
+{
+    for (int nodeId = 0; nodeId < 128; ++nodeId) {
+        int index = pending[nodeId];
+        if (index == NO_PENDING)
+            continue;
+
+        ObjectStatus& status = objects[index];
+        if (now - status.lastRequest > sdoTimeout) {
+            status.timeouts++;
+            pending[nodeId] = NO_PENDING;
+        }
+    }
+}
+
+bool SDOPollScheduler::poll(base::Time const& now, canbus::Message& msg)
+{
+    checkTimeouts(now);
+    refill(now);
+    if (tokens < SDO_TRANSACTION_BITS)
+        return false;
+
+    int best = NO_PENDING;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        ObjectStatus const& status = objects[i];
+        if (pending[status.nodeId] != NO_PENDING)
+            continue;
+        if (!status.lastRequest.isNull() && now < status.lastRequest + status.period)
+            continue;
+
+        if (best == NO_PENDING) {
+            best = i;
+            continue;
+        }
+
+        ObjectStatus const& current = objects[best];
+        if (status.priority != current.priority) {
+            if (status.priority > current.priority)
+                best = i;
+        }
+        else if (status.period < current.period)
+            best = i;
+    }
+
+    if (best == NO_PENDING)
+        return false;
+
+    ObjectStatus& status = objects[best];
+    status.lastRequest = now;
+    status.requests++;
+    pending[status.nodeId] = best;
+    tokens -= SDO_TRANSACTION_BITS;
+    msg = nodes[best]->upload(status.objectId, status.subId);
+    msg.time = now;
+    return true;
+}
+
+void SDOPollScheduler::process(uint8_t nodeId, StateMachine::Update const& update,
+                               base::Time const& time)
+{
+    if (update.mode != StateMachine::PROCESSED_SDO)
+        return;
+
+    int index = pending[nodeId & 0x7F];
+    if (index == NO_PENDING)
+        return;
+
+    ObjectStatus& status = objects[index];
+    if (update.hasUpdatedObject(status.objectId, status.subId)) {
+        status.lastReply = time;
+        status.replies++;
+        pending[nodeId & 0x7F] = NO_PENDING;
+    }
+}
+
+void SDOPollScheduler::abort(uint8_t nodeId)
+{
+    int index = pending[nodeId & 0x7F];
+    if (index == NO_PENDING)
+        return;
+
+    objects[index].aborts++;
+    pending[nodeId & 0x7F] = NO_PENDING;
+}
+
+bool SDOPollScheduler::isPending(uint8_t nodeId) const
+{
+    return pending[nodeId & 0x7F] != NO_PENDING;
+}
+
+SDOPollScheduler::ObjectStatus const* SDOPollScheduler::find(
+    uint8_t nodeId, uint16_t objectId, uint8_t subId) const
+{
+    for (auto const& status : objects) {
+        if (status.nodeId == nodeId && status.objectId == objectId &&
+            status.subId == subId)
+            return &status;
+    }
+    throw std::invalid_argument("object not registered in the poll scheduler");
+}
+
+base::Time SDOPollScheduler::getAge(uint8_t nodeId, uint16_t objectId, uint8_t subId,
+                                    base::Time const& now) const
+{
+    ObjectStatus const* status = find(nodeId, objectId, subId);
+    if (status->lastReply.isNull())
+        return base::Time();
+    return now - status->lastReply;
+}
+
+bool SDOPollScheduler::isStale(ObjectStatus const& status, base::Time const& now) const
+{
+    if (status.lastReply.isNull())
+        return true;
+    return now - status.lastReply > status.period + sdoTimeout;
+}
+
+bool SDOPollScheduler::isStale(uint8_t nodeId, uint16_t objectId, uint8_t subId,
+                               base::Time const& now) const
+{
+    return isStale(*find(nodeId, objectId, subId), now);
+}
+
+size_t SDOPollScheduler::getStaleCount(base::Time const& now) const
+{
+    size_t count = 0;
+    for (auto const& status : objects) {
+        if (isStale(status, now))
+            ++count;
+    }
+    return count;
+}
+
+vector<SDOPollScheduler::ObjectStatus> const& SDOPollScheduler::getStatus() const
+{
+    return objects;
+}
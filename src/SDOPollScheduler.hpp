@@ -0,0 +1,160 @@
+#ifndef CANOPEN_MASTER_SDO_POLL_SCHEDULER_HPP
+#define CANOPEN_MASTER_SDO_POLL_SCHEDULER_HPP
+
+#include <base/Time.hpp>
+#include <canmessage.hh>
+#include <canopen_master/StateMachine.hpp>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Periodic polling of dictionary objects through SDO uploads
+     *
+     * Register the objects that need to be polled with add(), and call
+     * poll() regularly to get the upload requests that should be sent. Feed
+     * the updates returned by StateMachine::process to process() so that the
+     * scheduler knows when a request has been answered.
+     *
+     * Objects are served by decreasing priority, and rate-monotonically
+     * (shortest period first) within the same priority. The scheduler keeps
+     * at most one SDO request pending per node, and limits its own traffic
+     * to a fraction of the bus bandwidth. The bandwidth used by the cyclic
+     * PDOs can be reserved with setReservedFramesPerSecond so that the
+     * polling never eats into it - CAN arbitration already favors the PDOs,
+     * since their COB-IDs are lower than the SDO ones.
+     */
+    class SDOPollScheduler
+    {
+    public:
+        /** Worst-case size in bits of a SDO frame (8 data bytes, standard
+         * ID, including bit stuffing) */
+        static const uint32_t SDO_FRAME_BITS = 135;
+
+        struct ObjectStatus
+        {
+            uint8_t nodeId;
+            uint16_t objectId;
+            uint8_t subId;
+            base::Time period;
+            int priority;
+
+            /** Time of the last upload request */
+            base::Time lastRequest;
+            /** Time of the last reply */
+            base::Time lastReply;
+
+            uint32_t requests = 0;
+            uint32_t replies = 0;
+            uint32_t timeouts = 0;
+            uint32_t aborts = 0;
+        };
+
+        /**
+         * @arg bitrate the bus bitrate in bit/s
+         * @arg maxBusLoad the maximum bus load (between 0 and 1) that the
+         *   polling, together with the reserved traffic, may generate
+         */
+        SDOPollScheduler(uint32_t bitrate, double maxBusLoad = 0.5);
+
+        /** Declare the number of frames per second that are generated by
+         * other, cyclic traffic (e.g. PDOPlanner::Plan::getFramesPerSecond)
+         *
+         * This bandwidth is removed from the polling budget
+         */
+        void setReservedFramesPerSecond(double fps);
+
+        /** Time after which a pending request is considered lost */
+        void setSDOTimeout(base::Time const& timeout);
+
+        /** The number of SDO transactions per second the polling may use */
+        double getTransactionsPerSecond() const;
+
+        /** Register an object that should be polled
+         *
+         * @arg node the state machine of the node the object belongs to. It
+         *   is used to build the upload requests, and must remain valid for
+         *   the lifetime of the scheduler
+         * @arg period the desired period between two reads of the object
+         * @arg priority objects of higher priorities are served first
+         * @throw std::invalid_argument if the period is null or the node
+         *   ID is above 127
+         */
+        void add(StateMachine const& node, uint16_t objectId, uint8_t subId,
+                 base::Time const& period, int priority = 0);
+
+        /** Register an object, using a type defined with CANOPEN_DEFINE_OBJECT
+         */
+        template<typename T>
+        void add(StateMachine const& node, base::Time const& period,
+                 int priority = 0, int offsetID = 0, int offsetSubID = 0) {
+            add(node, T::OBJECT_ID + offsetID, T::OBJECT_SUB_ID + offsetSubID,
+                period, priority);
+        }
+
+        /** Get the next upload request that should be sent
+         *
+         * Call repeatedly until it returns false to get all requests that are
+         * due at this time
+         *
+         * @return true if msg has been filled with a request to send
+         */
+        bool poll(base::Time const& now, canbus::Message& msg);
+
+        /** Inform the scheduler of an update returned by StateMachine::process
+         */
+        void process(uint8_t nodeId, StateMachine::Update const& update,
+                     base::Time const& time);
+
+        /** Inform the scheduler that the pending request for the given node
+         * has been aborted (i.e. StateMachine::process threw
+         * SDODomainTransferAborted)
+         */
+        void abort(uint8_t nodeId);
+
+        /** Whether a request is currently pending on the given node */
+        bool isPending(uint8_t nodeId) const;
+
+        /** Time since the last reply for the given object
+         *
+         * Returns a null time if the object has never been received
+         */
+        base::Time getAge(uint8_t nodeId, uint16_t objectId, uint8_t subId,
+                          base::Time const& now) const;
+
+        /** Whether the object has not been refreshed within its period (plus
+         * the SDO timeout)
+         */
+        bool isStale(uint8_t nodeId, uint16_t objectId, uint8_t subId,
+                     base::Time const& now) const;
+
+        /** Number of registered objects that are stale */
+        size_t getStaleCount(base::Time const& now) const;
+
+        /** Status of all the registered objects */
+        std::vector<ObjectStatus> const& getStatus() const;
+
+    private:
+        static const int NO_PENDING = -1;
+
+        uint32_t bitrate;
+        double maxBusLoad;
+        double reservedFPS = 0;
+        base::Time sdoTimeout = base::Time::fromMilliseconds(100);
+
+        /** Budget available for SDO transactions, in bits */
+        double tokens = 0;
+        base::Time lastRefill;
+
+        std::vector<ObjectStatus> objects;
+        std::vector<StateMachine const*> nodes;
+        int pending[128];
+
+        void refill(base::Time const& now);
+        void checkTimeouts(base::Time const& now);
+        bool isStale(ObjectStatus const& status, base::Time const& now) const;
+        ObjectStatus const* find(uint8_t nodeId, uint16_t objectId,
+                                 uint8_t subId) const;
+    };
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include <canopen_master/ShardedDispatcher.hpp>
+#include <canopen_master/FrameReaderThread.hpp>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+using namespace canopen_master;
+
+/** Maximum time a worker sleeps when its ring is empty */
+static const int MAX_IDLE_SLEEP_US = 50;
+
+ShardedDispatcher::Shard::Shard(size_t index, size_t ringCapacity)
+    : index(index)
+    , ring(ringCapacity)
+    , processed(0)
+    , errors(0)
+{
+}
+
+ShardedDispatcher::ShardedDispatcher(size_t shardCount, size_t ringCapacity)
+    : quit(false)
+    , dropped(0)
+    , completedCycle(0)
+{
+    if (shardCount == 0 || shardCount > 127)
+        throw std::invalid_argument("the shard count must be between 1 and 127");
+
+    for (size_t i = 0; i < shardCount; ++i)
+        shards.push_back(makeAligned<Shard>(i, ringCapacity));
+    fill(nodeShards, nodeShards + 128, -1);
+}
+
+ShardedDispatcher::~ShardedDispatcher()
+{
+    stop();
+}
+
+size_t ShardedDispatcher::getShardCount() const
+{
+    return shards.size();
+}
+
+size_t ShardedDispatcher::add(StateMachine& machine)
+{
+    size_t shard = machine.getNodeID() % shards.size();
+    add(machine, shard);
+    return shard;
+}
+
+void ShardedDispatcher::add(StateMachine& machine, size_t shard)
+{
+    checkNotRunning();
+    if (shard >= shards.size())
+        throw std::invalid_argument("no shard with this index");
+
+    uint8_t nodeId = machine.getNodeID();
+    if (nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+    else if (nodeShards[nodeId] != -1)
+        throw std::invalid_argument("a state machine is already registered for this node");
+
+    shards[shard]->dispatcher.add(machine);
+    shards[shard]->machines.push_back(&machine);
+    nodeShards[nodeId] = shard;
+}
+
+StateMachine* ShardedDispatcher::get(uint8_t nodeId) const
+{
+    int shard = getShard(nodeId);
+    if (shard < 0)
+        return nullptr;
+    return shards[shard]->dispatcher.get(nodeId);
+}
+
+int ShardedDispatcher::getShard(uint8_t nodeId) const
+{
+    if (nodeId > 127)
+        return -1;
+    return nodeShards[nodeId];
+}
+
+void ShardedDispatcher::setHandler(Handler handler)
+{
+    checkNotRunning();
+    this->handler = handler;
+}
+
+void ShardedDispatcher::setSyncHandler(SyncHandler handler)
+{
+    checkNotRunning();
+    this->syncHandler = handler;
+}
+
+void ShardedDispatcher::setProtocolCounters(ProtocolCounters* counters)
+{
+    checkNotRunning();
+    protocolCounters = counters;
+}
+
+void ShardedDispatcher::start(vector<int> const& cpus)
+{
+    checkNotRunning();
+    if (!cpus.empty() && cpus.size() != shards.size())
+        throw std::invalid_argument("expected one CPU per shard");
+
+    quit = false;
+    running = true;
+    // A previous stop() may have interrupted a barrier
+    arrived = 0;
+    for (auto& shard : shards)
+        shard->cycle = completedCycle;
+
+    try {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            Shard& shard = *shards[i];
+            shard.worker = std::thread([this, &shard]() { run(shard); });
+            if (!cpus.empty() && cpus[i] >= 0)
+                setThreadAffinity(shard.worker, cpus[i]);
+        }
+    }
+    catch(...) {
+        stop();
+        throw;
+    }
+}
+
+void ShardedDispatcher::stop()
+{
+    {
+        lock_guard<mutex> lock(barrierLock);
+        quit = true;
+    }
+    barrierSignal.notify_all();
+
+    for (auto& shard : shards) {
+        if (shard->worker.joinable())
+            shard->worker.join();
+    }
+    running = false;
+}
+
+bool ShardedDispatcher::route(canbus::Message const& msg)
+{
+    if (testBroadcastMessage(msg, BROADCAST_SYNC)) {
+        for (auto& shard : shards) {
+            while (!shard->ring.push(msg))
+                this_thread::yield();
+        }
+        return true;
+    }
+    else if (isBroadcast(msg)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    int shard = nodeShards[getNodeID(msg)];
+    if (shard < 0 && protocolCounters)
+        protocolCounters->add(getNodeID(msg), COUNTER_UNREGISTERED_FRAMES);
+    if (shard < 0 || !shards[shard]->ring.push(msg)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t ShardedDispatcher::route(FrameRing& ring, size_t maxCount)
+{
+    size_t const batchSize = Dispatcher::BATCH_SIZE;
+    canbus::Message batch[batchSize];
+    size_t total = 0;
+    while (total < maxCount) {
+        size_t count = ring.pop(batch, min(maxCount - total, batchSize));
+        for (size_t i = 0; i < count; ++i)
+            route(batch[i]);
+        total += count;
+        if (count < batchSize)
+            break;
+    }
+    return total;
+}
+
+uint64_t ShardedDispatcher::getSyncCycle() const
+{
+    return completedCycle.load(memory_order_acquire);
+}
+
+uint64_t ShardedDispatcher::getDroppedCount() const
+{
+    return dropped.load(memory_order_relaxed);
+}
+
+uint64_t ShardedDispatcher::getProcessedCount(size_t shard) const
+{
+    return shards.at(shard)->processed.load(memory_order_relaxed);
+}
+
+uint64_t ShardedDispatcher::getErrorCount(size_t shard) const
+{
+    return shards.at(shard)->errors.load(memory_order_relaxed);
+}
+
+void ShardedDispatcher::checkNotRunning() const
+{
+    if (running)
+        throw std::logic_error("cannot modify a running ShardedDispatcher");
+}
+
+void ShardedDispatcher::run(Shard& shard)
+{
+    while (!quit.load(memory_order_relaxed)) {
+        size_t count = shard.ring.pop(shard.batch, Dispatcher::BATCH_SIZE);
+        if (count == 0) {
+            this_thread::sleep_for(chrono::microseconds(MAX_IDLE_SLEEP_US));
+            continue;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            canbus::Message const& msg = shard.batch[i];
+            if (testBroadcastMessage(msg, BROADCAST_SYNC))
+                arrive(shard, msg);
+            else
+                process(shard, msg);
+        }
+    }
+}
+
+void ShardedDispatcher::process(Shard& shard, canbus::Message const& msg)
+{
+    try {
+        StateMachine::Update update = shard.dispatcher.process(msg);
+        shard.processed.fetch_add(1, memory_order_relaxed);
+        if (handler)
+            handler(shard.index, msg, update);
+    }
+    catch(std::exception const&) {
+        shard.errors.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void ShardedDispatcher::arrive(Shard& shard, canbus::Message const& sync)
+{
+    uint64_t cycle = ++shard.cycle;
+    for (StateMachine* machine : shard.machines)
+        machine->setSyncCycle(cycle, sync.time);
+
+    unique_lock<mutex> lock(barrierLock);
+    if (++arrived == shards.size()) {
+        arrived = 0;
+        if (syncHandler)
+            syncHandler(cycle, sync.time);
+        completedCycle.store(cycle, memory_order_release);
+        lock.unlock();
+        barrierSignal.notify_all();
+    }
+    else {
+        barrierSignal.wait(lock, [this, cycle]() {
+            return quit || completedCycle.load(memory_order_acquire) >= cycle;
+        });
+    }
+}
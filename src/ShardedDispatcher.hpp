@@ -0,0 +1,164 @@
+#ifndef CANOPEN_MASTER_SHARDED_DISPATCHER_HPP
+#define CANOPEN_MASTER_SHARDED_DISPATCHER_HPP
+
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/FrameRing.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Processing of the frames of a single bus by several worker threads
+     *
+     * It is an alternative to Dispatcher for buses too busy for a single
+     * thread. Each state machine belongs to one shard, and each shard has
+     * its own ring and worker thread. route() is the demultiplexing stage:
+     * it queues each frame in the ring of the shard that owns its node, so
+     * the frames of a given node are processed in order. Frames from nodes
+     * that are not registered, and broadcasts other than SYNC, are
+     * dropped.
+     *
+     * SYNC frames are queued in all rings and act as a barrier: each
+     * worker declares the new cycle to its state machines (see
+     * StateMachine::setSyncCycle) and waits for the others. Once all
+     * workers have processed all the frames received before the SYNC, the
+     * sync handler is called, while the workers are stopped. It therefore
+     * gets a coherent view of all the state machines.
+     *
+     * route() must be called from a single thread. Nodes and handlers must
+     * be set up before start()
+     */
+    class ShardedDispatcher
+    {
+    public:
+        /** Called on the shard's worker thread for each processed frame */
+        typedef std::function<void(size_t shard,
+                                   canbus::Message const&,
+                                   StateMachine::Update const&)> Handler;
+
+        /** Called once all workers have reached a SYNC */
+        typedef std::function<void(uint64_t cycle, base::Time const& time)> SyncHandler;
+
+        ShardedDispatcher(size_t shardCount, size_t ringCapacity = 1024);
+
+        /** Stops the workers */
+        ~ShardedDispatcher();
+
+        ShardedDispatcher(ShardedDispatcher const&) = delete;
+        ShardedDispatcher& operator =(ShardedDispatcher const&) = delete;
+
+        size_t getShardCount() const;
+
+        /** Register a state machine in the shard nodeId % getShardCount()
+         *
+         * @return the shard
+         */
+        size_t add(StateMachine& machine);
+
+        /** Register a state machine in the given shard
+         *
+         * @throw std::invalid_argument if the shard does not exist or if a
+         *   state machine with the same node ID is already registered
+         */
+        void add(StateMachine& machine, size_t shard);
+
+        /** The state machine of the given node, or nullptr */
+        StateMachine* get(uint8_t nodeId) const;
+
+        /** The shard of the given node, or -1 if it is not registered */
+        int getShard(uint8_t nodeId) const;
+
+        void setHandler(Handler handler);
+        void setSyncHandler(SyncHandler handler);
+
+        /** Count the frames of unregistered nodes in the given counters
+         *
+         * They are counted by route(), see COUNTER_UNREGISTERED_FRAMES. The
+         * counters are not owned
+         */
+        void setProtocolCounters(ProtocolCounters* counters);
+
+        /** Start the worker threads
+         *
+         * @arg cpus the CPU on which each worker is pinned. It is either
+         *   empty or has one entry per shard, -1 meaning no pinning
+         */
+        void start(std::vector<int> const& cpus = std::vector<int>());
+
+        /** Stop the worker threads and wait for them to finish */
+        void stop();
+
+        /** Queue a frame for the shard that handles it
+         *
+         * SYNC frames are never dropped: if a ring is full, the call waits
+         * for its worker to make room
+         *
+         * @return false if the frame was dropped
+         */
+        bool route(canbus::Message const& msg);
+
+        /** Route the frames available in a ring, e.g. the one fed by a
+         * FrameReaderThread
+         *
+         * @return the number of frames popped from the ring
+         */
+        size_t route(FrameRing& ring, size_t maxCount = Dispatcher::BATCH_SIZE);
+
+        /** The last SYNC cycle for which the sync handler has been called */
+        uint64_t getSyncCycle() const;
+
+        /** Frames dropped by route, either because their node is not
+         * registered or because the shard's ring was full */
+        uint64_t getDroppedCount() const;
+
+        /** Frames processed by the worker of a shard */
+        uint64_t getProcessedCount(size_t shard) const;
+
+        /** Exceptions thrown while processing frames in a shard */
+        uint64_t getErrorCount(size_t shard) const;
+
+    private:
+        struct Shard
+        {
+            Shard(size_t index, size_t ringCapacity);
+
+            size_t index;
+            FrameRing ring;
+            Dispatcher dispatcher;
+            std::vector<StateMachine*> machines;
+            std::thread worker;
+            /** Number of SYNCs seen by this worker */
+            uint64_t cycle = 0;
+            std::atomic<uint64_t> processed;
+            std::atomic<uint64_t> errors;
+            canbus::Message batch[Dispatcher::BATCH_SIZE];
+        };
+
+        std::vector<AlignedPtr<Shard>> shards;
+        int8_t nodeShards[128];
+        Handler handler;
+        SyncHandler syncHandler;
+        ProtocolCounters* protocolCounters = nullptr;
+        bool running = false;
+        std::atomic<bool> quit;
+        std::atomic<uint64_t> dropped;
+
+        std::mutex barrierLock;
+        std::condition_variable barrierSignal;
+        size_t arrived = 0;
+        std::atomic<uint64_t> completedCycle;
+
+        void checkNotRunning() const;
+        void run(Shard& shard);
+        void process(Shard& shard, canbus::Message const& msg);
+        /** Synchronize the worker with the others at a SYNC */
+        void arrive(Shard& shard, canbus::Message const& sync);
+    };
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include <canopen_master/SharedDictionary.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace canopen_master;
+using namespace canopen_master::shared_dictionary;
+
+static std::runtime_error systemError(string const& message, string const& name)
+{
+    return std::runtime_error(message + " " + name + ": " + strerror(errno));
+}
+
+static Entry* getEntries(void* mapping)
+{
+    return reinterpret_cast<Entry*>(static_cast<uint8_t*>(mapping) + ENTRIES_OFFSET);
+}
+
+SharedDictionary::SharedDictionary(string const& name, size_t capacity)
+    : name(name)
+    , capacity(capacity)
+    , mappingSize(ENTRIES_OFFSET + capacity * sizeof(Entry))
+{
+    if (capacity == 0 || capacity > 0xFFFFFFFF)
+        throw std::invalid_argument("invalid shared dictionary capacity");
+
+    // Readers of a previous segment keep it, and will not see this one
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1)
+        throw systemError("failed to create shared memory segment", name);
+    if (ftruncate(fd, mappingSize) == -1) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw systemError("failed to resize shared memory segment", name);
+    }
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw systemError("failed to map shared memory segment", name);
+    }
+
+    header = new(mapping) Header;
+    entries = getEntries(mapping);
+    for (size_t i = 0; i < capacity; ++i) {
+        Entry* entry = new(entries + i) Entry;
+        entry->sequence.store(0, memory_order_relaxed);
+        entry->size.store(0, memory_order_relaxed);
+        entry->data.store(0, memory_order_relaxed);
+        entry->timestamp.store(0, memory_order_relaxed);
+    }
+    header->capacity = capacity;
+    header->entrySize = sizeof(Entry);
+    header->version = VERSION;
+    header->entryCount.store(0, memory_order_relaxed);
+    // Readers check the magic last
+    atomic_thread_fence(memory_order_release);
+    header->magic = MAGIC;
+}
+
+SharedDictionary::~SharedDictionary()
+{
+    for (auto const& subscription : subscriptions)
+        subscription.first->unsubscribe(subscription.second);
+    munmap(mapping, mappingSize);
+    shm_unlink(name.c_str());
+}
+
+string const& SharedDictionary::getName() const
+{
+    return name;
+}
+
+size_t SharedDictionary::getCapacity() const
+{
+    return capacity;
+}
+
+size_t SharedDictionary::getEntryCount() const
+{
+    return header->entryCount.load(memory_order_relaxed);
+}
+
+size_t SharedDictionary::add(StateMachine& machine, uint16_t objectId, uint8_t subId)
+{
+    size_t index = getEntryCount();
+    if (index == capacity)
+        throw std::length_error("shared dictionary is full");
+
+    Entry& entry = entries[index];
+    entry.nodeId = machine.getNodeID();
+    entry.objectId = objectId;
+    entry.subId = subId;
+
+    uint8_t data[4] = { 0, 0, 0, 0 };
+    uint32_t size = machine.get(objectId, subId, data, 4);
+    if (size != 0)
+        write(index, data, size, machine.getTimestamp(objectId, subId));
+    header->entryCount.store(index + 1, memory_order_release);
+
+    auto id = machine.subscribe(objectId, subId,
+        [this, index](StateMachine::ObjectUpdate const& update) {
+            write(index, update.data, update.size, update.timestamp);
+        });
+    subscriptions.push_back(make_pair(&machine, id));
+    return index;
+}
+
+void SharedDictionary::write(size_t index, uint8_t const* data, uint8_t size,
+                             Timestamp timestamp)
+{
+    uint8_t buffer[4] = { 0, 0, 0, 0 };
+    memcpy(buffer, data, min<size_t>(size, 4));
+    uint32_t raw;
+    memcpy(&raw, buffer, 4);
+
+    Entry& entry = entries[index];
+    uint32_t sequence = entry.sequence.load(memory_order_relaxed);
+    entry.sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    entry.size.store(size, memory_order_relaxed);
+    entry.data.store(raw, memory_order_relaxed);
+    entry.timestamp.store(timestamp, memory_order_relaxed);
+    entry.sequence.store(sequence + 2, memory_order_release);
+}
+
+SharedDictionaryReader::SharedDictionaryReader(string const& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        throw systemError("failed to open shared memory segment", name);
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw systemError("failed to stat shared memory segment", name);
+    }
+    mappingSize = info.st_size;
+    if (mappingSize < ENTRIES_OFFSET) {
+        close(fd);
+        throw std::runtime_error(name + " is not a shared dictionary");
+    }
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw systemError("failed to map shared memory segment", name);
+
+    header = static_cast<Header const*>(mapping);
+    entries = getEntries(mapping);
+    uint32_t magic = header->magic;
+    atomic_thread_fence(memory_order_acquire);
+    if (magic != MAGIC || header->version != VERSION ||
+        header->entrySize != sizeof(Entry) ||
+        mappingSize < ENTRIES_OFFSET + header->capacity * sizeof(Entry)) {
+        munmap(mapping, mappingSize);
+        throw std::runtime_error(name + " is not a shared dictionary with the "
+                                 "layout of this library version");
+    }
+}
+
+SharedDictionaryReader::~SharedDictionaryReader()
+{
+    munmap(mapping, mappingSize);
+}
+
+size_t SharedDictionaryReader::getEntryCount() const
+{
+    return header->entryCount.load(memory_order_acquire);
+}
+
+int SharedDictionaryReader::find(uint8_t nodeId, uint16_t objectId, uint8_t subId) const
+{
+    size_t count = getEntryCount();
+    for (size_t i = 0; i < count; ++i) {
+        Entry const& entry = entries[i];
+        if (entry.nodeId == nodeId && entry.objectId == objectId && entry.subId == subId)
+            return i;
+    }
+    return -1;
+}
+
+bool SharedDictionaryReader::read(size_t index, SharedObjectValue& value) const
+{
+    if (index >= getEntryCount())
+        throw std::out_of_range("no such shared dictionary entry");
+
+    Entry const& entry = entries[index];
+    uint32_t raw;
+    while (true) {
+        uint32_t before = entry.sequence.load(memory_order_acquire);
+        if (before & 1) {
+            this_thread::yield();
+            continue;
+        }
+
+        value.size = entry.size.load(memory_order_relaxed);
+        raw = entry.data.load(memory_order_relaxed);
+        value.timestamp = entry.timestamp.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (entry.sequence.load(memory_order_relaxed) == before)
+            break;
+    }
+    memcpy(value.data, &raw, 4);
+    return value.timestamp != 0;
+}
@@ -0,0 +1,204 @@
+#ifndef CANOPEN_MASTER_SHARED_DICTIONARY_HPP
+#define CANOPEN_MASTER_SHARED_DICTIONARY_HPP
+
+#include <canopen_master/StateMachine.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace canopen_master
+{
+    /** Layout of the shared memory segment of SharedDictionary
+     *
+     * The segment is a header followed by a fixed number of entries, one
+     * per exported object, each on its own cache line. Entries are
+     * seqlocks: the writer makes the sequence odd while it updates the
+     * entry, and readers retry until they read the same even sequence
+     * before and after reading the entry.
+     *
+     * All fields shared between processes are lock-free atomics, and
+     * therefore address-free.
+     */
+    namespace shared_dictionary
+    {
+        static const uint32_t MAGIC = 0x434f4431; // "COD1"
+        /** Incremented on each incompatible layout change */
+        static const uint32_t VERSION = 1;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t capacity;
+            uint32_t entrySize;
+            /** Number of entries in use. Entries are appended, never
+             * removed */
+            std::atomic<uint32_t> entryCount;
+        };
+
+        struct alignas(64) Entry
+        {
+            /** Odd while the entry is being written */
+            std::atomic<uint32_t> sequence;
+            /** Identity of the object, set before the entry is published
+             * through Header::entryCount */
+            uint8_t nodeId;
+            uint8_t subId;
+            uint16_t objectId;
+            std::atomic<uint32_t> size;
+            std::atomic<uint32_t> data;
+            /** Timestamp of the value, zero if it has never been written */
+            std::atomic<int64_t> timestamp;
+        };
+
+        /** Offset of the first entry in the segment */
+        static const size_t ENTRIES_OFFSET = 64;
+
+        static_assert(sizeof(Header) <= ENTRIES_OFFSET,
+                      "the header must fit before the first entry");
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                      "the entries require lock-free atomics");
+    }
+
+    /** Value of an entry, as read by SharedDictionaryReader */
+    struct SharedObjectValue
+    {
+        Timestamp timestamp = 0;
+        uint8_t data[4] = { 0, 0, 0, 0 };
+        uint8_t size = 0;
+
+        /** See decodeObjectValue */
+        template <typename T> T as() const
+        {
+            return decodeObjectValue<T>(data, size);
+        }
+    };
+
+    /** Mirror of chosen dictionary objects in a POSIX shared memory segment
+     *
+     * Other processes (loggers, visualization, monitors) read the values
+     * with SharedDictionaryReader, directly from the shared mapping,
+     * without any system call or copy through the driver.
+     *
+     * Entries are updated through StateMachine::subscribe, i.e. each time
+     * StateMachine::process writes them. Each entry must be written by a
+     * single thread, which is the case if each state machine is processed
+     * by a single thread. Objects must be added before the state machines
+     * are processed by another thread.
+     *
+     * The state machines must outlive the SharedDictionary
+     */
+    class SharedDictionary
+    {
+    public:
+        /** Create the segment, replacing any existing one with this name
+         *
+         * @arg name the POSIX shared memory name, e.g. "/canopen_master"
+         * @arg capacity the maximum number of exported objects
+         * @throw std::runtime_error if the segment cannot be created
+         */
+        SharedDictionary(std::string const& name, size_t capacity);
+
+        /** Unsubscribes, unmaps and unlinks the segment. Readers that
+         * have it mapped keep their mapping */
+        ~SharedDictionary();
+
+        SharedDictionary(SharedDictionary const&) = delete;
+        SharedDictionary& operator =(SharedDictionary const&) = delete;
+
+        std::string const& getName() const;
+        size_t getCapacity() const;
+        size_t getEntryCount() const;
+
+        /** Export an object of a state machine
+         *
+         * Its current value, if any, is published immediately
+         *
+         * @return the entry index
+         * @throw std::length_error if the segment is full
+         */
+        size_t add(StateMachine& machine, uint16_t objectId, uint8_t subId);
+
+        /** Export an object defined with CANOPEN_DEFINE_OBJECT */
+        template<typename T>
+        size_t add(StateMachine& machine, int offsetId = 0, int offsetSubId = 0) {
+            return add(machine, T::OBJECT_ID + offsetId,
+                       T::OBJECT_SUB_ID + offsetSubId);
+        }
+
+        /** Publish a value in an entry */
+        void write(size_t index, uint8_t const* data, uint8_t size,
+                   Timestamp timestamp);
+
+    private:
+        std::string name;
+        size_t capacity;
+        size_t mappingSize;
+        void* mapping;
+        shared_dictionary::Header* header;
+        shared_dictionary::Entry* entries;
+
+        std::vector<std::pair<StateMachine*, StateMachine::SubscriptionID>> subscriptions;
+    };
+
+    /** Read access to a SharedDictionary from another process
+     *
+     * Reads never block the writer. A read that overlaps a write is
+     * retried, so read() always returns a consistent value and timestamp
+     */
+    class SharedDictionaryReader
+    {
+    public:
+        /** Map an existing segment
+         *
+         * @throw std::runtime_error if it does not exist, or if its layout
+         *   is not the one of this version of the library
+         */
+        explicit SharedDictionaryReader(std::string const& name);
+        ~SharedDictionaryReader();
+
+        SharedDictionaryReader(SharedDictionaryReader const&) = delete;
+        SharedDictionaryReader& operator =(SharedDictionaryReader const&) = delete;
+
+        /** Number of entries published so far */
+        size_t getEntryCount() const;
+
+        /** Index of the entry of the given object, or -1
+         *
+         * This is a linear search, meant to be done once at startup
+         */
+        int find(uint8_t nodeId, uint16_t objectId, uint8_t subId) const;
+
+        template<typename T>
+        int find(uint8_t nodeId, int offsetId = 0, int offsetSubId = 0) const {
+            return find(nodeId, T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId);
+        }
+
+        /** Read an entry
+         *
+         * @return false if the object has not been written yet
+         * @throw std::out_of_range if the entry does not exist
+         */
+        bool read(size_t index, SharedObjectValue& value) const;
+
+        /** Read an entry and decode it
+         *
+         * @throw ObjectNotRead if the object has not been written yet
+         */
+        template<typename T>
+        T get(size_t index) const {
+            SharedObjectValue value;
+            if (!read(index, value))
+                throw ObjectNotRead("attempting to get an object that has never been read");
+            return value.as<T>();
+        }
+
+    private:
+        size_t mappingSize;
+        void* mapping;
+        shared_dictionary::Header const* header;
+        shared_dictionary::Entry const* entries;
+    };
+}
+
+#endif
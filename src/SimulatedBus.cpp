@@ -0,0 +1,255 @@
+#include <canopen_master/SimulatedBus.hpp>
+#include <cmath>
+
+using namespace std;
+using namespace canopen_master;
+
+SimulatedBus::SimulatedBus(uint32_t bitrate, base::Time const& start)
+    : bitrate(bitrate)
+    , start(start)
+    , time(start)
+    , clock(*this)
+    , busFree(start)
+    , nextSync(base::Time::max())
+{
+    if (bitrate == 0)
+        throw std::invalid_argument("the bitrate must be strictly positive");
+}
+
+SimulatedNode& SimulatedBus::addNode(uint8_t nodeId)
+{
+    if (nodeId == 0 || nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+    else if (nodes[nodeId])
+        throw std::invalid_argument("a node with this ID already exists");
+
+    nodes[nodeId].reset(new SimulatedNode(nodeId));
+    nodeIds.push_back(nodeId);
+    scheduled[nodeId] = base::Time::max();
+    schedule(*nodes[nodeId]);
+    return *nodes[nodeId];
+}
+
+SimulatedNode& SimulatedBus::getNode(uint8_t nodeId)
+{
+    if (nodeId > 127 || !nodes[nodeId])
+        throw std::invalid_argument("no node with this ID");
+    return *nodes[nodeId];
+}
+
+size_t SimulatedBus::getNodeCount() const
+{
+    return nodeIds.size();
+}
+
+void SimulatedBus::setSyncPeriod(base::Time const& period)
+{
+    syncPeriod = period;
+    nextSync = period.isNull() ? base::Time::max() : time + period;
+}
+
+base::Time SimulatedBus::getTime() const
+{
+    return time;
+}
+
+Clock const& SimulatedBus::getClock() const
+{
+    return clock;
+}
+
+SimulatedBus::VirtualClock::VirtualClock(SimulatedBus const& bus)
+    : bus(bus)
+{
+}
+
+base::Time SimulatedBus::VirtualClock::now() const
+{
+    return bus.time;
+}
+
+void SimulatedBus::write(canbus::Message const& msg)
+{
+    queue(msg, SOURCE_MASTER, time);
+}
+
+bool SimulatedBus::read(canbus::Message& msg)
+{
+    if (received.empty())
+        return false;
+    msg = received.front();
+    received.pop_front();
+    return true;
+}
+
+bool SimulatedBus::read(canbus::Message& msg, base::Time const& timeout)
+{
+    base::Time deadline = time + timeout;
+    scheduleAll();
+    while (received.empty() && step(deadline));
+    return read(msg);
+}
+
+size_t SimulatedBus::getReceivedCount() const
+{
+    return received.size();
+}
+
+void SimulatedBus::run(base::Time const& duration)
+{
+    runUntil(time + duration);
+}
+
+void SimulatedBus::runUntil(base::Time const& end)
+{
+    scheduleAll();
+    while (step(end));
+}
+
+uint64_t SimulatedBus::getFrameCount() const
+{
+    return frameCount;
+}
+
+double SimulatedBus::getBusLoad() const
+{
+    if (time == start)
+        return 0;
+    return static_cast<double>(busyTime.toMicroseconds()) /
+        (time - start).toMicroseconds();
+}
+
+uint32_t SimulatedBus::getFrameBits(uint8_t size)
+{
+    // 47 bits of framing and interframe space, and at most one stuff bit
+    // every four bits over the 34 + 8 * size stuffed bits
+    return 47 + 8 * size + (34 + 8 * size - 1) / 4;
+}
+
+void SimulatedBus::queue(canbus::Message const& msg, int source, base::Time const& readyTime)
+{
+    Frame frame;
+    frame.seq = seq++;
+    frame.source = source;
+    frame.msg = msg;
+    future.insert(make_pair(readyTime, frame));
+}
+
+void SimulatedBus::schedule(SimulatedNode const& node)
+{
+    base::Time deadline = node.getNextDeadline();
+    if (deadline < time)
+        deadline = time;
+
+    uint8_t nodeId = node.getNodeID();
+    if (deadline != base::Time::max() && deadline != scheduled[nodeId])
+        timers.push(make_pair(deadline, nodeId));
+    scheduled[nodeId] = deadline;
+}
+
+void SimulatedBus::scheduleAll()
+{
+    for (uint8_t nodeId : nodeIds)
+        schedule(*nodes[nodeId]);
+}
+
+void SimulatedBus::deliver(Frame const& frame)
+{
+    canbus::Message msg = frame.msg;
+    msg.time = time;
+    if (frame.source != SOURCE_MASTER)
+        received.push_back(msg);
+
+    for (uint8_t nodeId : nodeIds) {
+        if (nodeId == frame.source)
+            continue;
+
+        SimulatedNode& node = *nodes[nodeId];
+        nodeOutput.clear();
+        node.process(msg, time, nodeOutput);
+        for (auto const& out : nodeOutput)
+            queue(out, nodeId, time + node.getResponseTime());
+        schedule(node);
+    }
+}
+
+void SimulatedBus::produceSync()
+{
+    auto sync = canbus::Message::Zeroed();
+    sync.can_id = BROADCAST_SYNC;
+    sync.size = 0;
+    queue(sync, SOURCE_SYNC, time);
+    nextSync = time + syncPeriod;
+}
+
+void SimulatedBus::updateNode()
+{
+    uint8_t nodeId = timers.top().second;
+    timers.pop();
+    scheduled[nodeId] = base::Time::max();
+
+    SimulatedNode& node = *nodes[nodeId];
+    nodeOutput.clear();
+    node.update(time, nodeOutput);
+    for (auto const& out : nodeOutput)
+        queue(out, nodeId, time);
+    schedule(node);
+}
+
+bool SimulatedBus::step(base::Time const& end)
+{
+    while (!timers.empty() && timers.top().first != scheduled[timers.top().second])
+        timers.pop();
+
+    // Generate the frames that are due now first, so that they take part
+    // in the arbitration
+    if (nextSync <= time) {
+        produceSync();
+        return true;
+    }
+    else if (!timers.empty() && timers.top().first <= time) {
+        updateNode();
+        return true;
+    }
+
+    while (!future.empty() && future.begin()->first <= time) {
+        ready.push(future.begin()->second);
+        future.erase(future.begin());
+    }
+
+    if (!inFlight && !ready.empty()) {
+        transmitted = ready.top();
+        ready.pop();
+        inFlight = true;
+        transmissionStart = time;
+
+        double bits = getFrameBits(transmitted.msg.size);
+        base::Time duration = base::Time::fromMicroseconds(
+            llround(bits * 1e6 / bitrate));
+        busFree = time + duration;
+        return true;
+    }
+
+    base::Time next = base::Time::max();
+    if (inFlight)
+        next = busFree;
+    if (!future.empty())
+        next = min(next, future.begin()->first);
+    if (!timers.empty())
+        next = min(next, timers.top().first);
+    next = min(next, nextSync);
+
+    if (next > end) {
+        time = max(time, end);
+        return false;
+    }
+
+    time = next;
+    if (inFlight && busFree == time) {
+        inFlight = false;
+        ++frameCount;
+        busyTime = busyTime + (busFree - transmissionStart);
+        deliver(transmitted);
+    }
+    return true;
+}
@@ -0,0 +1,191 @@
+#ifndef CANOPEN_MASTER_SIMULATED_BUS_HPP
+#define CANOPEN_MASTER_SIMULATED_BUS_HPP
+
+#include <canopen_master/Clock.hpp>
+#include <canopen_master/SimulatedNode.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <queue>
+
+namespace canopen_master
+{
+    /** In-process simulation of a CANopen network
+     *
+     * The bus holds a set of SimulatedNode and plays the role of the CAN
+     * driver for the master. It runs in virtual time, so a simulation is
+     * fully deterministic and runs as fast as the host allows.
+     *
+     * Frames are transmitted one at a time, lowest CAN ID first among the
+     * frames that are ready when the bus becomes free, and take their
+     * worst-case transmission time at the configured bitrate. Received
+     * frames are timestamped with the time at which their transmission
+     * ended.
+     *
+     * The general process is:
+     *
+     * ~~~ cpp
+     * SimulatedBus bus;
+     * bus.addNode(1).setHeartbeatPeriod(base::Time::fromMilliseconds(100));
+     * bus.write(makeModuleControlCommand(NODE_START, 0));
+     * bus.run(base::Time::fromSeconds(1));
+     *
+     * canbus::Message msg;
+     * while (bus.read(msg))
+     *     stateMachine.process(msg);
+     * ~~~
+     */
+    class SimulatedBus
+    {
+    public:
+        /**
+         * @arg bitrate the bus bitrate in bits per second
+         * @arg start the virtual time at which the simulation starts
+         */
+        explicit SimulatedBus(uint32_t bitrate = 1000000,
+                              base::Time const& start = base::Time::fromSeconds(1000));
+
+        /** Add a node to the bus. It boots (and sends its boot-up message)
+         * at the current time
+         *
+         * @throw std::invalid_argument if a node with the same ID exists
+         */
+        SimulatedNode& addNode(uint8_t nodeId);
+
+        /** @throw std::invalid_argument if there is no node with this ID */
+        SimulatedNode& getNode(uint8_t nodeId);
+
+        size_t getNodeCount() const;
+
+        /** Make the bus produce SYNC messages at the given period, starting
+         * one period from now. Set to zero to disable */
+        void setSyncPeriod(base::Time const& period);
+
+        /** The current virtual time */
+        base::Time getTime() const;
+
+        /** A clock returning the current virtual time
+         *
+         * Pass it to StateMachine::setClock so that the objects written
+         * by the master are timestamped in virtual time
+         */
+        Clock const& getClock() const;
+
+        /** Queue a frame sent by the master at the current time */
+        void write(canbus::Message const& msg);
+
+        /** Get the oldest frame received by the master
+         *
+         * @return false if there are none. The simulation is not advanced
+         */
+        bool read(canbus::Message& msg);
+
+        /** Advance the simulation until a frame is received by the master,
+         * or until the timeout expires
+         *
+         * @return false on timeout
+         */
+        bool read(canbus::Message& msg, base::Time const& timeout);
+
+        /** Count of frames received by the master and not read yet */
+        size_t getReceivedCount() const;
+
+        /** Advance the simulation by the given duration */
+        void run(base::Time const& duration);
+
+        /** Advance the simulation until the given time */
+        void runUntil(base::Time const& time);
+
+        /** Count of frames transmitted on the bus so far */
+        uint64_t getFrameCount() const;
+
+        /** Ratio of time the bus has been transmitting since the start */
+        double getBusLoad() const;
+
+        /** Worst-case size in bits of a standard frame on the wire,
+         * including stuff bits and the interframe space */
+        static uint32_t getFrameBits(uint8_t size);
+
+    private:
+        /** Source of the frames written by the master */
+        static const int SOURCE_MASTER = -1;
+        /** Source of the frames produced by the internal SYNC producer */
+        static const int SOURCE_SYNC = 0;
+
+        struct Frame
+        {
+            uint64_t seq;
+            int source;
+            canbus::Message msg;
+        };
+
+        /** Lowest CAN ID wins the arbitration */
+        struct ArbitrationOrder
+        {
+            bool operator ()(Frame const& a, Frame const& b) const {
+                if (a.msg.can_id != b.msg.can_id)
+                    return a.msg.can_id > b.msg.can_id;
+                return a.seq > b.seq;
+            }
+        };
+
+        class VirtualClock : public Clock
+        {
+        public:
+            explicit VirtualClock(SimulatedBus const& bus);
+            base::Time now() const override;
+
+        private:
+            SimulatedBus const& bus;
+        };
+
+        typedef std::pair<base::Time, uint8_t> Timer;
+
+        uint32_t bitrate;
+        base::Time start;
+        base::Time time;
+        VirtualClock clock;
+
+        std::unique_ptr<SimulatedNode> nodes[128];
+        std::vector<uint8_t> nodeIds;
+
+        uint64_t seq = 0;
+        /** Frames that will be ready for transmission at a later time */
+        std::multimap<base::Time, Frame> future;
+        /** Frames ready for transmission */
+        std::priority_queue<Frame, std::vector<Frame>, ArbitrationOrder> ready;
+        bool inFlight = false;
+        Frame transmitted;
+        base::Time transmissionStart;
+        base::Time busFree;
+
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers;
+        base::Time scheduled[128];
+
+        base::Time syncPeriod;
+        base::Time nextSync;
+
+        std::deque<canbus::Message> received;
+        uint64_t frameCount = 0;
+        base::Time busyTime;
+        std::vector<canbus::Message> nodeOutput;
+
+        void queue(canbus::Message const& msg, int source, base::Time const& time);
+        void schedule(SimulatedNode const& node);
+        /** Update the timers of all nodes, as they may have been modified
+         * directly between two calls to the bus */
+        void scheduleAll();
+        void deliver(Frame const& frame);
+        void produceSync();
+        /** Call update on the node whose timer is the first to expire */
+        void updateNode();
+        /** Process the next event, if it happens before the given time
+         *
+         * @return false if there was none, in which case the time is advanced
+         *   to the given time
+         */
+        bool step(base::Time const& end);
+    };
+}
+
+#endif
@@ -0,0 +1,532 @@
+#include <canopen_master/SimulatedNode.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/PDO.hpp>
+#include <canopen_master/SDO.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+static const uint16_t OBJECT_DEVICE_TYPE = 0x1000;
+static const uint16_t OBJECT_ERROR_REGISTER = 0x1001;
+static const uint16_t OBJECT_HEARTBEAT_PRODUCER = 0x1017;
+static const uint16_t OBJECT_IDENTITY = 0x1018;
+
+static const uint32_t PDO_DISABLED = 0x80000000;
+static const uint8_t PDO_MAX_MAPPED_OBJECTS = 8;
+
+static const uint32_t SDO_ABORT_INVALID_COMMAND = 0x05040001;
+static const uint32_t SDO_ABORT_READ_ONLY = 0x06010002;
+static const uint32_t SDO_ABORT_NO_OBJECT = 0x06020000;
+static const uint32_t SDO_ABORT_CANNOT_MAP = 0x06040041;
+static const uint32_t SDO_ABORT_PDO_LENGTH = 0x06040042;
+static const uint32_t SDO_ABORT_LENGTH_TOO_HIGH = 0x06070012;
+
+static uint32_t encodeMapping(PDOMapping::MappedObject const& m)
+{
+    return static_cast<uint32_t>(m.objectId) << 16 | m.subId << 8 | m.size * 8;
+}
+
+static bool isCommunicationObject(uint16_t objectId)
+{
+    return objectId == OBJECT_HEARTBEAT_PRODUCER ||
+        (objectId >= 0x1400 && objectId < 0x1C00);
+}
+
+SimulatedNode::SimulatedNode(uint8_t nodeId)
+    : nodeId(nodeId)
+    , state(NODE_INITIALIZING)
+    , responseTime(base::Time::fromMicroseconds(100))
+    , nextHeartbeat(base::Time::max())
+{
+    if (nodeId == 0 || nodeId > 127)
+        throw std::invalid_argument("invalid node ID");
+    declareCommunicationObjects();
+    loadCommunicationObjects();
+}
+
+void SimulatedNode::declareCommunicationObjects()
+{
+    declare(OBJECT_DEVICE_TYPE, 0, 4);
+    declare(OBJECT_ERROR_REGISTER, 0, 1);
+    declare(OBJECT_HEARTBEAT_PRODUCER, 0, 2);
+    declare(OBJECT_IDENTITY, 0, 1, 4);
+    for (int i = 1; i <= 4; ++i)
+        declare(OBJECT_IDENTITY, i, 4);
+
+    for (int i = 0; i < PDO_COUNT; ++i) {
+        uint16_t rpdoParameters = getPDOParametersObjectId(false, i);
+        declare(rpdoParameters, 1, 4, PDO_DISABLED | getPDODefaultCOBID(false, i, nodeId));
+        declare(rpdoParameters, 2, 1, 254);
+
+        uint16_t tpdoParameters = getPDOParametersObjectId(true, i);
+        declare(tpdoParameters, 1, 4, PDO_DISABLED | getPDODefaultCOBID(true, i, nodeId));
+        declare(tpdoParameters, 2, 1, 254);
+        declare(tpdoParameters, 3, 2);
+        declare(tpdoParameters, 5, 2);
+
+        for (int transmit = 0; transmit < 2; ++transmit) {
+            uint16_t mappingId = getPDOMappingObjectId(transmit, i);
+            declare(mappingId, 0, 1);
+            for (int sub = 1; sub <= PDO_MAX_MAPPED_OBJECTS; ++sub)
+                declare(mappingId, sub, 4);
+        }
+    }
+}
+
+uint8_t SimulatedNode::getNodeID() const
+{
+    return nodeId;
+}
+
+NODE_STATE SimulatedNode::getState() const
+{
+    return state;
+}
+
+void SimulatedNode::declare(uint16_t objectId, uint8_t subId, uint8_t size, uint32_t value)
+{
+    if (size == 0 || size > 4)
+        throw std::invalid_argument("simulated objects must be between 1 and 4 bytes");
+    Entry& entry = dictionary[make_pair(objectId, subId)];
+    entry.size = size;
+    entry.value = value;
+}
+
+bool SimulatedNode::has(uint16_t objectId, uint8_t subId) const
+{
+    return dictionary.find(make_pair(objectId, subId)) != dictionary.end();
+}
+
+uint32_t SimulatedNode::get(uint16_t objectId, uint8_t subId) const
+{
+    auto it = dictionary.find(make_pair(objectId, subId));
+    if (it == dictionary.end())
+        throw ObjectNotRead("object not declared in the simulated node");
+    return it->second.value;
+}
+
+void SimulatedNode::set(uint16_t objectId, uint8_t subId, uint32_t value)
+{
+    auto it = dictionary.find(make_pair(objectId, subId));
+    if (it == dictionary.end())
+        throw ObjectNotRead("object not declared in the simulated node");
+    it->second.value = value;
+    if (isCommunicationObject(objectId))
+        loadCommunicationObjects();
+}
+
+void SimulatedNode::configureTPDO(int pdoIndex, PDOCommunicationParameters const& parameters,
+                                  PDOMapping const& mapping)
+{
+    if (pdoIndex < 0 || pdoIndex >= PDO_COUNT)
+        throw std::invalid_argument("invalid PDO index");
+
+    uint8_t transmissionType = 254;
+    switch (parameters.transmission_mode) {
+        case PDO_SYNCHRONOUS: transmissionType = parameters.sync_period; break;
+        case PDO_SYNCHRONOUS_RTR_ONLY: transmissionType = 252; break;
+        case PDO_ASYNCHRONOUS_RTR_ONLY: transmissionType = 253; break;
+        case PDO_ASYNCHRONOUS: transmissionType = 254; break;
+    }
+
+    uint16_t parametersId = getPDOParametersObjectId(true, pdoIndex);
+    uint16_t cob_id = parameters.cob_id ? parameters.cob_id :
+        getPDODefaultCOBID(true, pdoIndex, nodeId);
+    set(parametersId, 1, PDO_DISABLED | cob_id);
+    set(parametersId, 2, transmissionType);
+    set(parametersId, 3, parameters.inhibit_time.toMicroseconds() / 100);
+    set(parametersId, 5, parameters.timer_period.toMilliseconds());
+
+    uint16_t mappingId = getPDOMappingObjectId(true, pdoIndex);
+    set(mappingId, 0, 0);
+    for (size_t i = 0; i < mapping.mappings.size(); ++i) {
+        auto const& m = mapping.mappings[i];
+        set(mappingId, i + 1, encodeMapping(m));
+    }
+    set(mappingId, 0, mapping.mappings.size());
+    set(parametersId, 1, cob_id);
+}
+
+void SimulatedNode::configureRPDO(int pdoIndex, PDOMapping const& mapping)
+{
+    if (pdoIndex < 0 || pdoIndex >= PDO_COUNT)
+        throw std::invalid_argument("invalid PDO index");
+
+    uint16_t parametersId = getPDOParametersObjectId(false, pdoIndex);
+    uint16_t mappingId = getPDOMappingObjectId(false, pdoIndex);
+    set(mappingId, 0, 0);
+    for (size_t i = 0; i < mapping.mappings.size(); ++i) {
+        auto const& m = mapping.mappings[i];
+        set(mappingId, i + 1, encodeMapping(m));
+    }
+    set(mappingId, 0, mapping.mappings.size());
+    set(parametersId, 1, getPDODefaultCOBID(false, pdoIndex, nodeId));
+}
+
+void SimulatedNode::setHeartbeatPeriod(base::Time const& period)
+{
+    set(OBJECT_HEARTBEAT_PRODUCER, 0, period.toMilliseconds());
+}
+
+void SimulatedNode::setResponseTime(base::Time const& time)
+{
+    responseTime = time;
+}
+
+base::Time SimulatedNode::getResponseTime() const
+{
+    return responseTime;
+}
+
+void SimulatedNode::setUpdateHandler(UpdateHandler handler)
+{
+    updateHandler = handler;
+}
+
+void SimulatedNode::setState(NODE_STATE state)
+{
+    this->state = state;
+    if (state == NODE_OPERATIONAL) {
+        for (auto& pdo : tpdos)
+            pdo.nextTransmission = lastTime + pdo.eventTimer;
+    }
+}
+
+void SimulatedNode::raiseEmergency(uint16_t code, uint8_t errorRegister)
+{
+    set(OBJECT_ERROR_REGISTER, 0, errorRegister);
+
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = FUNCTION_EMERGENCY + nodeId;
+    msg.size = 8;
+    toLittleEndian<uint16_t>(msg.data, code);
+    msg.data[2] = errorRegister;
+    pendingEmergencies.push_back(msg);
+}
+
+void SimulatedNode::loadPDO(bool transmit, int pdoIndex)
+{
+    PDO& pdo = transmit ? tpdos[pdoIndex] : rpdos[pdoIndex];
+
+    uint16_t parametersId = getPDOParametersObjectId(transmit, pdoIndex);
+    uint32_t cob_id = get(parametersId, 1);
+    pdo.enabled = !(cob_id & PDO_DISABLED);
+    pdo.cob_id = cob_id & 0x7FF;
+    pdo.transmissionType = get(parametersId, 2);
+    pdo.eventTimer = transmit ?
+        base::Time::fromMilliseconds(get(parametersId, 5)) : base::Time();
+    pdo.nextTransmission = lastTime + pdo.eventTimer;
+    pdo.syncCount = 0;
+
+    uint16_t mappingId = getPDOMappingObjectId(transmit, pdoIndex);
+    pdo.mappings.clear();
+    uint8_t count = min<uint32_t>(get(mappingId, 0), PDO_MAX_MAPPED_OBJECTS);
+    for (uint8_t i = 1; i <= count; ++i) {
+        uint32_t entry = get(mappingId, i);
+        PDOMapping::MappedObject m;
+        m.objectId = entry >> 16;
+        m.subId = (entry >> 8) & 0xFF;
+        m.size = (entry & 0xFF) / 8;
+        pdo.mappings.push_back(m);
+    }
+}
+
+void SimulatedNode::loadCommunicationObjects()
+{
+    for (int i = 0; i < PDO_COUNT; ++i) {
+        loadPDO(true, i);
+        loadPDO(false, i);
+    }
+
+    heartbeatPeriod = base::Time::fromMilliseconds(get(OBJECT_HEARTBEAT_PRODUCER, 0));
+    if (heartbeatPeriod.isNull())
+        nextHeartbeat = base::Time::max();
+    else if (nextHeartbeat == base::Time::max() || nextHeartbeat > lastTime + heartbeatPeriod)
+        nextHeartbeat = lastTime + heartbeatPeriod;
+}
+
+void SimulatedNode::resetCommunication(std::vector<canbus::Message>& out)
+{
+    state = NODE_PRE_OPERATIONAL;
+    guardToggle = false;
+    nextHeartbeat = base::Time::max();
+    loadCommunicationObjects();
+
+    auto bootup = canbus::Message::Zeroed();
+    bootup.can_id = FUNCTION_NMT_HEARTBEAT + nodeId;
+    bootup.size = 1;
+    bootup.data[0] = NODE_INITIALIZING;
+    out.push_back(bootup);
+}
+
+void SimulatedNode::process(canbus::Message const& msg, base::Time const& time,
+                            std::vector<canbus::Message>& out)
+{
+    lastTime = time;
+    if (state == NODE_INITIALIZING)
+        return;
+
+    if (msg.can_id == BROADCAST_NMT_MODULE_CONTROL)
+        return processNMT(msg, out);
+    else if (msg.can_id == BROADCAST_SYNC) {
+        if (state == NODE_OPERATIONAL)
+            processSync(time, out);
+        return;
+    }
+    else if (msg.can_id == static_cast<uint32_t>(FUNCTION_NMT_HEARTBEAT + nodeId) && msg.size == 0) {
+        // Node guarding
+        auto reply = canbus::Message::Zeroed();
+        reply.can_id = FUNCTION_NMT_HEARTBEAT + nodeId;
+        reply.size = 1;
+        reply.data[0] = state | (guardToggle ? 0x80 : 0);
+        guardToggle = !guardToggle;
+        out.push_back(reply);
+        return;
+    }
+    else if (msg.can_id == static_cast<uint32_t>(FUNCTION_SDO_RECEIVE + nodeId)) {
+        if (state != NODE_STOPPED)
+            processSDO(msg, out);
+        return;
+    }
+
+    if (state != NODE_OPERATIONAL)
+        return;
+    for (auto const& pdo : rpdos) {
+        if (pdo.enabled && pdo.cob_id == msg.can_id) {
+            processRPDO(pdo, msg);
+            return;
+        }
+    }
+}
+
+void SimulatedNode::processNMT(canbus::Message const& msg,
+                               std::vector<canbus::Message>& out)
+{
+    if (msg.data[1] != 0 && msg.data[1] != nodeId)
+        return;
+
+    switch (msg.data[0]) {
+        case NODE_START:
+            setState(NODE_OPERATIONAL);
+            break;
+        case NODE_STOP:
+            setState(NODE_STOPPED);
+            break;
+        case NODE_ENTER_PRE_OPERATIONAL:
+            setState(NODE_PRE_OPERATIONAL);
+            break;
+        case NODE_RESET:
+        case NODE_RESET_COMMUNICATION:
+            resetCommunication(out);
+            break;
+    }
+}
+
+void SimulatedNode::processSync(base::Time const& time, std::vector<canbus::Message>& out)
+{
+    bool updated = false;
+    for (auto& pdo : tpdos) {
+        if (!pdo.enabled || pdo.transmissionType > 240)
+            continue;
+
+        // Acyclic synchronous PDOs (type 0) are sent on every SYNC
+        if (++pdo.syncCount < pdo.transmissionType)
+            continue;
+        pdo.syncCount = 0;
+
+        if (!updated && updateHandler) {
+            updateHandler(*this, time);
+            updated = true;
+        }
+        out.push_back(makeTPDO(pdo));
+    }
+}
+
+canbus::Message SimulatedNode::makeSDOAbort(uint16_t objectId, uint8_t subId, uint32_t code) const
+{
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = FUNCTION_SDO_TRANSMIT + nodeId;
+    msg.size = 8;
+    msg.data[0] = SDO_ABORT_DOMAIN_TRANSFER << 5;
+    toLittleEndian<uint16_t>(msg.data + 1, objectId);
+    msg.data[3] = subId;
+    toLittleEndian<uint32_t>(msg.data + 4, code);
+    return msg;
+}
+
+void SimulatedNode::processSDO(canbus::Message const& msg, std::vector<canbus::Message>& out)
+{
+    ++sdoCount;
+
+    SDOCommand cmd = getSDOCommand(msg);
+    uint16_t objectId = getSDOObjectID(msg);
+    uint8_t subId = getSDOObjectSubID(msg);
+    // Requests and replies use different command specifiers for the
+    // same value, so compare with the raw request specifiers
+    uint8_t specifier = msg.data[0] >> 5;
+    if (specifier == SDO_ABORT_DOMAIN_TRANSFER)
+        return;
+
+    auto it = dictionary.find(make_pair(objectId, subId));
+    if (specifier != SDO_INITIATE_DOMAIN_UPLOAD &&
+        specifier != SDO_INITIATE_DOMAIN_DOWNLOAD) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_INVALID_COMMAND));
+        return;
+    }
+    else if (it == dictionary.end()) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_NO_OBJECT));
+        return;
+    }
+
+    Entry& entry = it->second;
+    auto reply = canbus::Message::Zeroed();
+    reply.can_id = FUNCTION_SDO_TRANSMIT + nodeId;
+    reply.size = 8;
+    toLittleEndian<uint16_t>(reply.data + 1, objectId);
+    reply.data[3] = subId;
+
+    if (specifier == SDO_INITIATE_DOMAIN_UPLOAD) {
+        reply.data[0] = SDO_INITIATE_DOMAIN_UPLOAD_REPLY << 5 | 0x3 | (4 - entry.size) << 2;
+        toLittleEndian<uint32_t>(reply.data + 4, entry.value);
+        out.push_back(reply);
+        return;
+    }
+
+    if (!cmd.expedited_transfer) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_INVALID_COMMAND));
+        return;
+    }
+    else if (objectId == OBJECT_DEVICE_TYPE || objectId == OBJECT_IDENTITY) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_READ_ONLY));
+        return;
+    }
+
+    uint32_t value = fromLittleEndian<uint32_t>(msg.data + 4);
+    if (cmd.size != 0 && cmd.size < 4)
+        value &= (1ULL << (cmd.size * 8)) - 1;
+    if (entry.size < 4 && (value >> (entry.size * 8)) != 0) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_LENGTH_TOO_HIGH));
+        return;
+    }
+
+    // Validate PDO mappings the way a device would
+    bool isMapping = (objectId >= 0x1600 && objectId < 0x1600 + PDO_COUNT) ||
+        (objectId >= 0x1A00 && objectId < 0x1A00 + PDO_COUNT);
+    if (isMapping && subId != 0 && value != 0 &&
+        !has(value >> 16, (value >> 8) & 0xFF)) {
+        out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_CANNOT_MAP));
+        return;
+    }
+    else if (isMapping && subId == 0) {
+        unsigned int bits = 0;
+        for (uint8_t i = 1; i <= min<uint32_t>(value, PDO_MAX_MAPPED_OBJECTS); ++i)
+            bits += get(objectId, i) & 0xFF;
+        if (value > PDO_MAX_MAPPED_OBJECTS || bits > 64) {
+            out.push_back(makeSDOAbort(objectId, subId, SDO_ABORT_PDO_LENGTH));
+            return;
+        }
+    }
+
+    set(objectId, subId, value);
+    reply.data[0] = SDO_INITIATE_DOMAIN_DOWNLOAD_REPLY << 5;
+    out.push_back(reply);
+}
+
+void SimulatedNode::processRPDO(PDO const& pdo, canbus::Message const& msg)
+{
+    int offset = 0;
+    for (auto const& m : pdo.mappings) {
+        if (offset + m.size > msg.size)
+            return;
+
+        auto it = dictionary.find(make_pair(m.objectId, m.subId));
+        if (it != dictionary.end()) {
+            uint8_t buffer[4] = { 0, 0, 0, 0 };
+            copy(msg.data + offset, msg.data + offset + m.size, buffer);
+            it->second.value = fromLittleEndian<uint32_t>(buffer);
+        }
+        offset += m.size;
+    }
+}
+
+canbus::Message SimulatedNode::makeTPDO(PDO const& pdo) const
+{
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = pdo.cob_id;
+    int offset = 0;
+    for (auto const& m : pdo.mappings) {
+        auto it = dictionary.find(make_pair(m.objectId, m.subId));
+        uint8_t buffer[4] = { 0, 0, 0, 0 };
+        if (it != dictionary.end())
+            toLittleEndian<uint32_t>(buffer, it->second.value);
+        copy(buffer, buffer + m.size, msg.data + offset);
+        offset += m.size;
+    }
+    msg.size = offset;
+    return msg;
+}
+
+void SimulatedNode::flushEmergencies(std::vector<canbus::Message>& out)
+{
+    out.insert(out.end(), pendingEmergencies.begin(), pendingEmergencies.end());
+    pendingEmergencies.clear();
+}
+
+void SimulatedNode::update(base::Time const& time, std::vector<canbus::Message>& out)
+{
+    lastTime = time;
+    if (state == NODE_INITIALIZING)
+        resetCommunication(out);
+    flushEmergencies(out);
+
+    if (time >= nextHeartbeat) {
+        auto heartbeat = canbus::Message::Zeroed();
+        heartbeat.can_id = FUNCTION_NMT_HEARTBEAT + nodeId;
+        heartbeat.size = 1;
+        heartbeat.data[0] = state;
+        out.push_back(heartbeat);
+
+        nextHeartbeat = nextHeartbeat + heartbeatPeriod;
+        if (nextHeartbeat <= time)
+            nextHeartbeat = time + heartbeatPeriod;
+    }
+
+    if (state != NODE_OPERATIONAL)
+        return;
+
+    bool updated = false;
+    for (auto& pdo : tpdos) {
+        if (!pdo.enabled || pdo.transmissionType < 254 ||
+            pdo.eventTimer.isNull() || time < pdo.nextTransmission)
+            continue;
+
+        if (!updated && updateHandler) {
+            updateHandler(*this, time);
+            updated = true;
+        }
+        out.push_back(makeTPDO(pdo));
+        pdo.nextTransmission = pdo.nextTransmission + pdo.eventTimer;
+        if (pdo.nextTransmission <= time)
+            pdo.nextTransmission = time + pdo.eventTimer;
+    }
+}
+
+base::Time SimulatedNode::getNextDeadline() const
+{
+    if (state == NODE_INITIALIZING || !pendingEmergencies.empty())
+        return base::Time();
+
+    base::Time deadline = nextHeartbeat;
+    if (state != NODE_OPERATIONAL)
+        return deadline;
+    for (auto const& pdo : tpdos) {
+        if (pdo.enabled && pdo.transmissionType >= 254 && !pdo.eventTimer.isNull())
+            deadline = min(deadline, pdo.nextTransmission);
+    }
+    return deadline;
+}
+
+uint64_t SimulatedNode::getSDOCount() const
+{
+    return sdoCount;
+}
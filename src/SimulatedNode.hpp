@@ -0,0 +1,188 @@
+#ifndef CANOPEN_MASTER_SIMULATED_NODE_HPP
+#define CANOPEN_MASTER_SIMULATED_NODE_HPP
+
+#include <canopen_master/Frame.hpp>
+#include <canopen_master/PDOMapping.hpp>
+#include <canopen_master/PDOCommunicationParameters.hpp>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace canopen_master
+{
+    /** A virtual CANopen slave, meant to be used within a SimulatedBus
+     *
+     * The node has its own object dictionary, which is accessed by an
+     * expedited SDO server. It produces heartbeats and boot-up messages, and
+     * transmits and receives PDOs as configured in the standard communication
+     * objects (0x1400, 0x1600, 0x1800 and 0x1A00 ranges). The PDO configuration
+     * can therefore be done either by the master through SDOs (e.g. with
+     * StateMachine::configurePDO), or directly with configureTPDO and
+     * configureRPDO.
+     *
+     * The node is purely reactive: all times are given by the bus
+     */
+    class SimulatedNode
+    {
+    public:
+        /** Number of PDOs of each direction */
+        static const int PDO_COUNT = 4;
+
+        /** Called before the node produces its TPDOs so that the object
+         * values can evolve with time */
+        typedef std::function<void (SimulatedNode&, base::Time const&)> UpdateHandler;
+
+        explicit SimulatedNode(uint8_t nodeId);
+
+        uint8_t getNodeID() const;
+        NODE_STATE getState() const;
+
+        /** Declare an object in the dictionary
+         *
+         * @arg size the object size in bytes, between 1 and 4
+         */
+        void declare(uint16_t objectId, uint8_t subId, uint8_t size, uint32_t value = 0);
+
+        /** Declare an object defined with CANOPEN_DEFINE_OBJECT */
+        template<typename T>
+        void declare(typename T::OBJECT_TYPE value = typename T::OBJECT_TYPE()) {
+            declare(T::OBJECT_ID, T::OBJECT_SUB_ID,
+                    sizeof(typename T::OBJECT_TYPE), encode(value));
+        }
+
+        /** Whether an object is declared in the dictionary */
+        bool has(uint16_t objectId, uint8_t subId) const;
+
+        /** Get the raw value of an object
+         *
+         * @throw ObjectNotRead if the object is not declared
+         */
+        uint32_t get(uint16_t objectId, uint8_t subId) const;
+
+        /** Change the value of an object
+         *
+         * @throw ObjectNotRead if the object is not declared
+         */
+        void set(uint16_t objectId, uint8_t subId, uint32_t value);
+
+        template<typename T>
+        typename T::OBJECT_TYPE get() const {
+            return decode<typename T::OBJECT_TYPE>(get(T::OBJECT_ID, T::OBJECT_SUB_ID));
+        }
+
+        template<typename T>
+        void set(typename T::OBJECT_TYPE value) {
+            set(T::OBJECT_ID, T::OBJECT_SUB_ID, encode(value));
+        }
+
+        /** Configure a TPDO by writing its communication and mapping
+         * objects, as the master would do through SDOs
+         *
+         * Only the transmission type and the event timer of the
+         * communication parameters are used
+         */
+        void configureTPDO(int pdoIndex, PDOCommunicationParameters const& parameters,
+                           PDOMapping const& mapping);
+
+        /** Configure a RPDO by writing its communication and mapping objects */
+        void configureRPDO(int pdoIndex, PDOMapping const& mapping);
+
+        /** Set the heartbeat producer time (object 0x1017) */
+        void setHeartbeatPeriod(base::Time const& period);
+
+        /** Set the time the node takes to answer a SDO request or a SYNC */
+        void setResponseTime(base::Time const& time);
+        base::Time getResponseTime() const;
+
+        /** Set the handler called before the TPDOs are produced */
+        void setUpdateHandler(UpdateHandler handler);
+
+        /** Change the NMT state, without sending any message */
+        void setState(NODE_STATE state);
+
+        /** Queue an emergency message. It is sent on the next call to process
+         * or update */
+        void raiseEmergency(uint16_t code, uint8_t errorRegister);
+
+        /** Process a message received from the bus
+         *
+         * @arg out messages that the node sends in response, to be
+         *   transmitted after getResponseTime()
+         */
+        void process(canbus::Message const& msg, base::Time const& time,
+                     std::vector<canbus::Message>& out);
+
+        /** Produce the messages that are due at the given time (heartbeats,
+         * event-timer TPDOs)
+         */
+        void update(base::Time const& time, std::vector<canbus::Message>& out);
+
+        /** The next time at which update must be called, or base::Time::max()
+         * if there is none */
+        base::Time getNextDeadline() const;
+
+        /** Count of SDO requests that have been answered */
+        uint64_t getSDOCount() const;
+
+    private:
+        struct Entry
+        {
+            uint32_t value;
+            uint8_t size;
+        };
+
+        struct PDO
+        {
+            bool enabled = false;
+            uint16_t cob_id = 0;
+            uint8_t transmissionType = 0;
+            base::Time eventTimer;
+            base::Time nextTransmission;
+            unsigned int syncCount = 0;
+            std::vector<PDOMapping::MappedObject> mappings;
+        };
+
+        uint8_t nodeId;
+        NODE_STATE state;
+        std::map<std::pair<uint16_t, uint8_t>, Entry> dictionary;
+        PDO tpdos[PDO_COUNT];
+        PDO rpdos[PDO_COUNT];
+        base::Time responseTime;
+        base::Time heartbeatPeriod;
+        base::Time nextHeartbeat;
+        base::Time lastTime;
+        bool guardToggle = false;
+        uint64_t sdoCount = 0;
+        UpdateHandler updateHandler;
+        std::vector<canbus::Message> pendingEmergencies;
+
+        void declareCommunicationObjects();
+        void loadPDO(bool transmit, int pdoIndex);
+        void loadCommunicationObjects();
+        void resetCommunication(std::vector<canbus::Message>& out);
+        void processNMT(canbus::Message const& msg,
+                        std::vector<canbus::Message>& out);
+        void processSync(base::Time const& time, std::vector<canbus::Message>& out);
+        void processSDO(canbus::Message const& msg, std::vector<canbus::Message>& out);
+        void processRPDO(PDO const& pdo, canbus::Message const& msg);
+        canbus::Message makeTPDO(PDO const& pdo) const;
+        canbus::Message makeSDOAbort(uint16_t objectId, uint8_t subId, uint32_t code) const;
+        void flushEmergencies(std::vector<canbus::Message>& out);
+
+        template<typename T>
+        static uint32_t encode(T value) {
+            uint8_t buffer[4] = { 0, 0, 0, 0 };
+            toLittleEndian<T>(buffer, value);
+            return fromLittleEndian<uint32_t>(buffer);
+        }
+
+        template<typename T>
+        static T decode(uint32_t value) {
+            uint8_t buffer[4];
+            toLittleEndian<uint32_t>(buffer, value);
+            return fromLittleEndian<T>(buffer);
+        }
+    };
+}
+
+#endif
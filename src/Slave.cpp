@@ -1,5 +1,6 @@
 #include <canopen_master/Slave.hpp>
 #include <canopen_master/Objects.hpp>
+#include <canopen_master/SyncProducer.hpp>
 
 using namespace canopen_master;
 
@@ -11,6 +12,14 @@ canbus::Message canopen_master::querySync() {
     return msg;
 }
 
+canbus::Message canopen_master::querySync(uint8_t counter) {
+    return makeSyncMessage(counter, base::Time::now());
+}
+
+canbus::Message canopen_master::querySync(Clock const& clock, uint8_t counter) {
+    return makeSyncMessage(counter, clock.now());
+}
+
 Slave::Slave(StateMachine& state_machine)
     : mCANOpen(state_machine) {
 }
@@ -19,6 +28,10 @@ Slave::~Slave() {
 
 }
 
+void Slave::unsubscribe(StateMachine::SubscriptionID id) {
+    mCANOpen.unsubscribe(id);
+}
+
 canbus::Message Slave::queryNodeState() const {
     return mCANOpen.queryState();
 }
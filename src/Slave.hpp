@@ -9,6 +9,13 @@ namespace canopen_master {
     /** Create a Sync message */
     canbus::Message querySync();
 
+    /** Create a Sync message with the given SYNC counter */
+    canbus::Message querySync(uint8_t counter);
+
+    /** Create a Sync message timestamped using the given clock, with an
+     * optional SYNC counter */
+    canbus::Message querySync(Clock const& clock, uint8_t counter = 0);
+
     enum StandardUpdates {
         UPDATE_HEARTBEAT      = 0x00000001,
         UPDATE_CUSTOM_START   = 0x00000010
@@ -100,9 +107,17 @@ namespace canopen_master {
                                       T::OBJECT_SUB_ID + offsetSubId);
         }
 
+        /** Set an object in the object database, timestamped with the
+         * state machine's clock */
         template<typename T>
-        void set(typename T::OBJECT_TYPE value,
-                 base::Time const& time = base::Time::now()) {
+        void set(typename T::OBJECT_TYPE value) {
+            return mCANOpen.set<typename T::OBJECT_TYPE>(
+                T::OBJECT_ID, T::OBJECT_SUB_ID, value
+            );
+        }
+
+        template<typename T>
+        void set(typename T::OBJECT_TYPE value, base::Time const& time) {
             return mCANOpen.set<typename T::OBJECT_TYPE>(
                 T::OBJECT_ID, T::OBJECT_SUB_ID,
                 value, time
@@ -111,14 +126,37 @@ namespace canopen_master {
 
         template<typename T>
         void set(typename T::OBJECT_TYPE value,
-                 int offsetId, int offsetSubId = 0,
-                 base::Time const& time = base::Time::now()) {
+                 int offsetId, int offsetSubId = 0) {
+            return mCANOpen.set<typename T::OBJECT_TYPE>(
+                T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId,
+                value
+            );
+        }
+
+        template<typename T>
+        void set(typename T::OBJECT_TYPE value,
+                 int offsetId, int offsetSubId,
+                 base::Time const& time) {
             return mCANOpen.set<typename T::OBJECT_TYPE>(
                 T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId,
                 value, time
             );
         }
 
+        /** Call the callback each time process() writes the given object
+         *
+         * See StateMachine::subscribe
+         */
+        template<typename T>
+        StateMachine::SubscriptionID subscribe(
+            std::function<void(typename T::OBJECT_TYPE, base::Time const&)> callback,
+            int offsetId = 0, int offsetSubId = 0) {
+            return mCANOpen.subscribe<T>(callback, offsetId, offsetSubId);
+        }
+
+        /** Remove a subscription created with subscribe */
+        void unsubscribe(StateMachine::SubscriptionID id);
+
         virtual StateMachine::Update process(canbus::Message const& message);
 
         /** Create the given RPDO message
@@ -7,6 +7,7 @@
 #include <canopen_master/PDO.hpp>
 #include <canopen_master/SDO.hpp>
 #include <canopen_master/StateMachine.hpp>
+#include <canopen_master/SyncProducer.hpp>
 #include <cstring>
 #include <iostream>
 
@@ -18,8 +19,6 @@ StateMachine::Dictionary::iterator StateMachine::declareInternal(uint16_t object
     bool knownSize)
 {
     ObjectValue value;
-    value.objectId = objectId;
-    value.subId = subId;
     value.size = size;
     value.knownSize = knownSize;
     return dictionary.insert(std::make_pair(ObjectIdentifier(objectId, subId), value))
@@ -32,6 +31,7 @@ StateMachine::StateMachine(uint8_t nodeId, bool useUnknownSizes)
 {
     rpdoMappings.resize(MAX_PDO);
     tpdoMappings.resize(MAX_PDO);
+    tpdoTracking.resize(MAX_PDO);
 }
 
 void StateMachine::setQuirks(uint64_t value)
@@ -86,13 +86,145 @@ void StateMachine::setUseUnknownSizes(bool toggle)
     useUnknownSizes = toggle;
 }
 
+Clock const& StateMachine::getClock() const
+{
+    return *clock;
+}
+
+void StateMachine::setClock(Clock const& clock)
+{
+    this->clock = &clock;
+}
+
+base::Time StateMachine::now() const
+{
+    return clock->now();
+}
+
+bool StateMachine::getThrowOnDeviceErrors() const
+{
+    return throwOnDeviceErrors;
+}
+
+void StateMachine::setThrowOnDeviceErrors(bool toggle)
+{
+    throwOnDeviceErrors = toggle;
+}
+
+Emergency StateMachine::getLastEmergency() const
+{
+    return lastEmergency;
+}
+
+uint32_t StateMachine::getLastSDOAbortCode() const
+{
+    return lastSDOAbortCode;
+}
+
+const int32_t StateMachine::NO_SUBSCRIPTION_SLOT;
+const int32_t StateMachine::NO_HISTORY_SLOT;
+
 StateMachine::Update StateMachine::process(canbus::Message const& msg)
+{
+    updatedObjectCount = 0;
+    Update update;
+    try {
+        update = processMessage(msg);
+    }
+    catch(...) {
+        notifySubscribers();
+        throw;
+    }
+    notifySubscribers();
+    return update;
+}
+
+StateMachine::SubscriptionID StateMachine::subscribe(uint16_t objectId, uint8_t subId,
+    ObjectCallback callback)
+{
+    auto it = dictionary.find(ObjectIdentifier(objectId, subId));
+    if (it == dictionary.end()) {
+        // Size zero until the object is first written
+        it = declareInternal(objectId, subId, 0, false);
+    }
+
+    ObjectValue& value = it->second;
+    if (value.subscriptionSlot == NO_SUBSCRIPTION_SLOT) {
+        value.subscriptionSlot = subscriptionSlots.size();
+        SubscriptionSlot slot;
+        slot.object = it->first;
+        subscriptionSlots.push_back(slot);
+    }
+
+    Subscription subscription = { nextSubscriptionID++, callback };
+    subscriptionSlots[value.subscriptionSlot].subscriptions.push_back(subscription);
+    return subscription.id;
+}
+
+void StateMachine::unsubscribe(SubscriptionID id)
+{
+    for (auto& slot : subscriptionSlots) {
+        for (auto it = slot.subscriptions.begin(); it != slot.subscriptions.end(); ++it) {
+            if (it->id == id) {
+                slot.subscriptions.erase(it);
+                return;
+            }
+        }
+    }
+}
+
+ObjectHistory const& StateMachine::enableHistory(uint16_t objectId, uint8_t subId,
+                                                 size_t capacity)
+{
+    auto it = dictionary.find(ObjectIdentifier(objectId, subId));
+    if (it == dictionary.end()) {
+        // Size zero until the object is first written
+        it = declareInternal(objectId, subId, 0, false);
+    }
+
+    ObjectValue& value = it->second;
+    if (value.historySlot == NO_HISTORY_SLOT) {
+        histories.emplace_back(capacity);
+        value.historySlot = histories.size() - 1;
+    }
+    return histories[value.historySlot];
+}
+
+ObjectHistory const& StateMachine::getHistory(uint16_t objectId, uint8_t subId) const
+{
+    auto it = dictionary.find(ObjectIdentifier(objectId, subId));
+    if (it == dictionary.end() || it->second.historySlot == NO_HISTORY_SLOT)
+        throw std::invalid_argument("no history for this object");
+    return histories[it->second.historySlot];
+}
+
+void StateMachine::notifySubscribers()
+{
+    // Callbacks may call set(), which records more objects
+    size_t count = updatedObjectCount;
+    for (size_t i = 0; i < count; ++i) {
+        ObjectValue const& value = *updatedObjects[i];
+        SubscriptionSlot const& slot = subscriptionSlots[value.subscriptionSlot];
+        ObjectUpdate update = {
+            slot.object.first, slot.object.second,
+            value.data, value.size, value.lastUpdate
+        };
+        for (auto const& subscription : slot.subscriptions)
+            subscription.callback(update);
+    }
+    updatedObjectCount = 0;
+}
+
+StateMachine::Update StateMachine::processMessage(canbus::Message const& msg)
 {
     if (canopen_master::getNodeID(msg) == nodeId)
         lastMessageTime = msg.time;
     else
         return Update(PROCESSED_NOT_FOR_ME);
 
+    count(COUNTER_FRAMES);
+    count(COUNTER_BYTES, msg.size);
+
     uint16_t functionCode = getFunctionCode(msg);
     if (functionCode == FUNCTION_EMERGENCY)
         return processEmergency(msg);
@@ -109,6 +241,7 @@ StateMachine::Update StateMachine::process(canbus::Message const& msg)
 
 StateMachine::Update StateMachine::processEmergency(canbus::Message const& msg)
 {
+    count(COUNTER_EMERGENCIES);
     Emergency em = parseEmergencyMessage(msg);
     if (em.code >> 8 == 0) // "No error" ????
         return Update(PROCESSED_EMERGENCY_NO_ERROR);
@@ -116,12 +249,20 @@ StateMachine::Update StateMachine::processEmergency(canbus::Message const& msg)
     uint16_t objectId = ErrorRegister::OBJECT_ID;
     uint16_t objectSubId = ErrorRegister::OBJECT_SUB_ID;
 
-    set<uint8_t>(objectId, objectSubId, msg.data[2]);
+    // Emergencies are reported even if the frame has no reception time
+    Timestamp timestamp = msg.time.isNull() ? clock->nowTimestamp()
+                                            : toTimestamp(msg.time);
+    setTimestamped<uint8_t>(objectId, objectSubId, msg.data[2], timestamp);
+    if (!throwOnDeviceErrors) {
+        lastEmergency = em;
+        return Update(PROCESSED_EMERGENCY, objectId, objectSubId);
+    }
     throw EmergencyMessageReceived(em);
 }
 
 StateMachine::Update StateMachine::processHeartbeat(canbus::Message const& msg)
 {
+    count(COUNTER_HEARTBEATS);
     state = static_cast<NODE_STATE>(msg.data[0]);
     lastStateUpdate = msg.time;
     return Update(PROCESSED_HEARTBEAT);
@@ -130,35 +271,119 @@ StateMachine::Update StateMachine::processHeartbeat(canbus::Message const& msg)
 StateMachine::Update StateMachine::processPDOReceive(int pdoIndex,
     canbus::Message const& msg)
 {
-    if (tpdoMappings.size() < pdoIndex + 1u)
+    if (tpdoMappings.size() < pdoIndex + 1u) {
+        count(COUNTER_UNEXPECTED_PDOS);
         return Update(PROCESSED_PDO_UNEXPECTED);
+    }
     PDOMapping const& mapping = tpdoMappings[pdoIndex];
 
+    if (msg.time.isNull()) {
+        throw std::invalid_argument(
+            "attempting to set an object with a zero update time");
+    }
+    Timestamp timestamp = toTimestamp(msg.time);
+
     Update update(PROCESSED_PDO);
     int offset = 0;
-    for (const auto m : mapping.mappings) {
-        setObjectValue(m.objectId, m.subId, msg.time, msg.data + offset, m.size);
+    for (const auto& m : mapping.mappings) {
+        setObjectValue(m.objectId, m.subId, timestamp, msg.data + offset, m.size);
         offset += m.size;
         update.addUpdate(m.objectId, m.subId);
     }
     if (!update.hasUpdatedObjects()) {
+        count(COUNTER_UNEXPECTED_PDOS);
         return Update(PROCESSED_PDO_UNEXPECTED);
     }
     else {
+        trackSynchronousPDO(pdoIndex, msg, update);
+        if (!latencyStatistics.empty() && pdoIndex <= MAX_PDO)
+            recordTPDOJitter(pdoIndex, msg.time);
         return update;
     }
 }
 
+void StateMachine::count(PROTOCOL_COUNTER counter, uint64_t value)
+{
+    if (protocolCounters)
+        protocolCounters->add(nodeId, counter, value);
+}
+
+void StateMachine::recordTPDOJitter(int pdoIndex, base::Time const& time)
+{
+    LatencyStatistics& stats = latencyStatistics[0];
+    base::Time& last = stats.tpdoLastReception[pdoIndex];
+    base::Time& lastInterval = stats.tpdoLastInterval[pdoIndex];
+    if (!last.isNull()) {
+        base::Time interval = time - last;
+        if (!lastInterval.isNull()) {
+            base::Time jitter = interval - lastInterval;
+            stats.tpdoJitter[pdoIndex].record(
+                jitter < base::Time() ? base::Time() - jitter : jitter);
+        }
+        lastInterval = interval;
+    }
+    last = time;
+}
+
+void StateMachine::trackSynchronousPDO(int pdoIndex,
+    canbus::Message const& msg,
+    Update& update)
+{
+    TPDOTracking& tracking = tpdoTracking[pdoIndex];
+    if (!tracking.synchronous || syncCycle == 0)
+        return;
+
+    if (!latencyStatistics.empty() && pdoIndex <= MAX_PDO)
+        latencyStatistics[0].syncToTPDO[pdoIndex].record(msg.time - syncTime);
+
+    TPDOStatistics& stats = tracking.statistics;
+    update.sync_cycle = syncCycle;
+    if (stats.received && stats.lastCycle == syncCycle) {
+        update.flags |= PDO_DUPLICATE;
+        stats.duplicates++;
+    }
+    else if (stats.received && tracking.syncPeriod) {
+        uint64_t elapsed = syncCycle - stats.lastCycle;
+        uint64_t missed = elapsed / tracking.syncPeriod;
+        if (missed > 1) {
+            update.flags |= PDO_MISSED;
+            stats.missed += missed - 1;
+        }
+    }
+
+    if (!syncWindow.isNull() && msg.time - syncTime > syncWindow) {
+        update.flags |= PDO_LATE;
+        stats.late++;
+    }
+
+    stats.received++;
+    stats.lastCycle = syncCycle;
+}
+
 StateMachine::Update StateMachine::processSDOReceive(canbus::Message const& msg)
 {
+    if (!sdoRequestTime.isNull() &&
+        getSDOObjectID(msg) == sdoRequestObjectId &&
+        getSDOObjectSubID(msg) == sdoRequestSubId) {
+        if (!latencyStatistics.empty())
+            latencyStatistics[0].sdoRoundTrip.record(msg.time - sdoRequestTime);
+        sdoRequestTime = base::Time();
+    }
+
     SDOCommand cmd = getSDOCommand(msg);
     if (cmd.command == SDO_ABORT_DOMAIN_TRANSFER) {
+        count(COUNTER_SDO_ABORTS);
+        if (!throwOnDeviceErrors) {
+            lastSDOAbortCode = fromLittleEndian<uint32_t>(msg.data + 4);
+            return Update(PROCESSED_SDO_ABORT, getSDOObjectID(msg), getSDOObjectSubID(msg));
+        }
         parseSDODomainTransferAbort(msg);
         // never returns
         return Update();
     }
     if (cmd.command == SDO_INITIATE_DOMAIN_UPLOAD_REPLY) {
         if (!cmd.expedited_transfer) {
+            count(COUNTER_IGNORED_SDOS);
             std::cerr << "can_master::StateMachine nodeId=" << nodeId
                       << " ignored non-expedited SDO transfer" << std::endl;
             return Update();
@@ -177,7 +402,7 @@ StateMachine::Update StateMachine::processSDOReceive(canbus::Message const& msg)
                 declareInternal(objectId, subId, cmd.size, false);
             }
         }
-        setObjectValue(objectId, subId, msg.time, msg.data + 4, cmd.size);
+        setObjectValue(objectId, subId, toTimestamp(msg.time), msg.data + 4, cmd.size);
         return Update(PROCESSED_SDO, objectId, subId);
     }
     else if (cmd.command == SDO_INITIATE_DOMAIN_DOWNLOAD_REPLY) {
@@ -186,6 +411,7 @@ StateMachine::Update StateMachine::processSDOReceive(canbus::Message const& msg)
         return Update(PROCESSED_SDO_INITIATE_DOWNLOAD, objectId, subId);
     }
     else {
+        count(COUNTER_IGNORED_SDOS);
         std::cerr << "can_master::StateMachine nodeId=" << nodeId
                   << " ignored SDO command " << cmd.command << std::endl;
         return Update(PROCESSED_SDO_IGNORED_COMMAND);
@@ -195,7 +421,7 @@ StateMachine::Update StateMachine::processSDOReceive(canbus::Message const& msg)
 
 void StateMachine::setObjectValue(uint16_t objectId,
     uint8_t subId,
-    base::Time const& time,
+    Timestamp timestamp,
     uint8_t const* data,
     uint32_t dataSize)
 {
@@ -208,13 +434,17 @@ void StateMachine::setObjectValue(uint16_t objectId,
     if ((value.size != dataSize) && value.knownSize)
         throw ProtocolError("unexpected object size in dictionary");
 
-    if (time.isNull()) {
-        throw std::invalid_argument(
-            "attempting to set an object with a zero update time");
-    }
-
-    value.lastUpdate = time;
+    value.lastUpdate = timestamp;
+    if (value.size == 0)
+        value.size = dataSize;
     std::copy(data, data + dataSize, value.data);
+
+    if (value.historySlot != NO_HISTORY_SLOT)
+        histories[value.historySlot].push(timestamp, data, dataSize);
+    if (value.subscriptionSlot != NO_SUBSCRIPTION_SLOT &&
+        updatedObjectCount < MAX_PDO_MAPPED_OBJECTS) {
+        updatedObjects[updatedObjectCount++] = &value;
+    }
 }
 
 canbus::Message StateMachine::upload(uint16_t objectId, uint8_t subId) const
@@ -224,7 +454,12 @@ canbus::Message StateMachine::upload(uint16_t objectId, uint8_t subId) const
 
 void StateMachine::declare(uint16_t objectId, uint8_t subId, uint32_t size)
 {
-    declareInternal(objectId, subId, size, true);
+    ObjectValue& value = declareInternal(objectId, subId, size, true)->second;
+    // subscribe and enableHistory create entries of unknown size
+    if (value.size == 0 && !value.knownSize) {
+        value.size = size;
+        value.knownSize = true;
+    }
 }
 
 bool StateMachine::has(uint16_t objectId, uint8_t subId) const
@@ -242,10 +477,19 @@ uint32_t StateMachine::sizeOf(uint16_t objectId, uint8_t subId) const
 }
 
 base::Time StateMachine::timestamp(uint16_t objectId, uint8_t subId) const
+{
+    Timestamp timestamp = getTimestamp(objectId, subId);
+    if (timestamp == 0)
+        return base::Time();
+    else
+        return toTime(timestamp);
+}
+
+Timestamp StateMachine::getTimestamp(uint16_t objectId, uint8_t subId) const
 {
     auto it = dictionary.find(ObjectIdentifier(objectId, subId));
     if (it == dictionary.end())
-        return base::Time();
+        return 0;
     else
         return it->second.lastUpdate;
 }
@@ -259,6 +503,16 @@ canbus::Message StateMachine::sync()
     return msg;
 }
 
+canbus::Message StateMachine::sync(uint8_t counter)
+{
+    return makeSyncMessage(counter, base::Time::now());
+}
+
+canbus::Message StateMachine::sync(Clock const& clock, uint8_t counter)
+{
+    return makeSyncMessage(counter, clock.now());
+}
+
 canbus::Message StateMachine::download(uint16_t objectId,
     uint8_t subId,
     uint8_t const* data,
@@ -296,7 +550,7 @@ uint32_t StateMachine::get(uint16_t objectId,
     auto it = dictionary.find(ObjectIdentifier(objectId, subId));
     if (it == dictionary.end())
         return 0;
-    if (it->second.lastUpdate.isNull())
+    if (it->second.lastUpdate == 0)
         return 0;
     uint32_t actualSize = it->second.size;
     if (actualSize > bufferSize)
@@ -310,17 +564,17 @@ uint32_t StateMachine::getObjectSize(uint16_t objectId, uint16_t subId) const
     auto it = dictionary.find(ObjectIdentifier(objectId, subId));
     if (it == dictionary.end())
         return 0;
-    if (it->second.lastUpdate.isNull())
+    if (it->second.lastUpdate == 0)
         return 0;
     return it->second.size;
 }
 
 canbus::Message StateMachine::getRPDOMessage(unsigned int pdoIndex)
 {
-    if (rpdoMappings.size() < pdoIndex)
+    if (rpdoMappings.size() <= pdoIndex)
         throw std::invalid_argument("no RPDO declared with this index");
 
-    auto mapping = rpdoMappings[pdoIndex];
+    PDOMapping const& mapping = rpdoMappings[pdoIndex];
 
     canbus::Message msg;
     msg.can_id = getPDODefaultCOBID(false, pdoIndex, nodeId);
@@ -376,9 +630,145 @@ std::vector<canbus::Message> StateMachine::configurePDOMapping(bool transmit,
     return makePDOMappingMessages(transmit, nodeId, pdoIndex, mapping);
 }
 
+size_t StateMachine::configurePDO(bool transmit,
+    uint8_t pdoIndex,
+    PDOCommunicationParameters const& parameters,
+    PDOMapping const& mapping,
+    canbus::Message* messages) const
+{
+    return makePDOConfigurationMessagesInto(transmit,
+        nodeId,
+        pdoIndex,
+        parameters,
+        mapping,
+        messages,
+        quirks & PDO_COBID_MESSAGE_RESERVED_BIT_QUIRK);
+}
+
+size_t StateMachine::configurePDOMapping(bool transmit,
+    uint8_t pdoIndex,
+    PDOMapping const& mapping,
+    canbus::Message* messages) const
+{
+    validatePDOMapping(mapping);
+    return makePDOMappingMessagesInto(transmit, nodeId, pdoIndex, mapping, messages);
+}
+
+size_t StateMachine::configurePDOParameters(bool transmit,
+    uint8_t pdoIndex,
+    PDOCommunicationParameters const& parameters,
+    canbus::Message* messages) const
+{
+    return makePDOCommunicationParametersMessagesInto(
+        transmit, nodeId, pdoIndex, parameters, messages);
+}
+
 void StateMachine::declareTPDOMapping(uint8_t pdoIndex, PDOMapping const& mapping)
+{
+    declareTPDOMapping(pdoIndex, mapping, PDOCommunicationParameters::Async());
+}
+
+void StateMachine::declareTPDOMapping(uint8_t pdoIndex,
+    PDOMapping const& mapping,
+    PDOCommunicationParameters const& parameters)
 {
     declarePDOMapping(pdoIndex, mapping, tpdoMappings);
+    if (pdoIndex + 1u > tpdoTracking.size())
+        tpdoTracking.resize(pdoIndex + 1);
+
+    TPDOTracking tracking;
+    tracking.synchronous = (parameters.transmission_mode == PDO_SYNCHRONOUS);
+    if (tracking.synchronous)
+        tracking.syncPeriod = parameters.sync_period;
+    tpdoTracking[pdoIndex] = tracking;
+}
+
+void StateMachine::setSyncCycle(uint64_t cycle, base::Time const& time)
+{
+    syncCycle = cycle;
+    syncTime = time;
+}
+
+uint64_t StateMachine::getSyncCycle() const
+{
+    return syncCycle;
+}
+
+void StateMachine::setSyncWindow(base::Time const& window)
+{
+    syncWindow = window;
+}
+
+StateMachine::TPDOStatistics const& StateMachine::getTPDOStatistics(
+    uint8_t pdoIndex) const
+{
+    if (pdoIndex >= tpdoTracking.size())
+        throw std::invalid_argument("no TPDO declared with this index");
+    return tpdoTracking[pdoIndex].statistics;
+}
+
+uint64_t StateMachine::getTPDOAge(uint8_t pdoIndex) const
+{
+    return syncCycle - getTPDOStatistics(pdoIndex).lastCycle;
+}
+
+void StateMachine::enableLatencyStatistics()
+{
+    if (latencyStatistics.empty())
+        latencyStatistics.resize(1);
+}
+
+bool StateMachine::hasLatencyStatistics() const
+{
+    return !latencyStatistics.empty();
+}
+
+void StateMachine::notifySent(canbus::Message const& msg, base::Time const& time)
+{
+    if (msg.can_id == static_cast<uint32_t>(FUNCTION_SDO_RECEIVE + nodeId)) {
+        sdoRequestTime = time;
+        sdoRequestObjectId = getSDOObjectID(msg);
+        sdoRequestSubId = getSDOObjectSubID(msg);
+    }
+}
+
+static void validatePDOIndex(uint8_t pdoIndex)
+{
+    if (pdoIndex > MAX_PDO)
+        throw std::out_of_range("invalid PDO index " + std::to_string(pdoIndex));
+}
+
+LatencyHistogram const& StateMachine::getSDORoundTripHistogram() const
+{
+    if (latencyStatistics.empty())
+        throw std::logic_error("latency statistics are not enabled");
+    return latencyStatistics[0].sdoRoundTrip;
+}
+
+LatencyHistogram const& StateMachine::getSyncToTPDOHistogram(uint8_t pdoIndex) const
+{
+    if (latencyStatistics.empty())
+        throw std::logic_error("latency statistics are not enabled");
+    validatePDOIndex(pdoIndex);
+    return latencyStatistics[0].syncToTPDO[pdoIndex];
+}
+
+LatencyHistogram const& StateMachine::getTPDOJitterHistogram(uint8_t pdoIndex) const
+{
+    if (latencyStatistics.empty())
+        throw std::logic_error("latency statistics are not enabled");
+    validatePDOIndex(pdoIndex);
+    return latencyStatistics[0].tpdoJitter[pdoIndex];
+}
+
+void StateMachine::setProtocolCounters(ProtocolCounters* counters)
+{
+    protocolCounters = counters;
+}
+
+ProtocolCounters* StateMachine::getProtocolCounters() const
+{
+    return protocolCounters;
 }
 
 void StateMachine::declareRPDOMapping(uint8_t pdoIndex, PDOMapping const& mapping)
@@ -410,11 +800,15 @@ std::vector<canbus::Message> StateMachine::configurePDOParameters(bool transmit,
 StateMachine::Update::Update()
     : mode(PROCESSED_IGNORED_MESSAGE)
     , update_count(0)
+    , flags(0)
+    , sync_cycle(0)
 {
 }
 StateMachine::Update::Update(UPDATE_EVENT mode)
     : mode(mode)
     , update_count(0)
+    , flags(0)
+    , sync_cycle(0)
 {
 }
 StateMachine::Update::Update(UPDATE_EVENT mode, uint16_t objectId, uint8_t subId)
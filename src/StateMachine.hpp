@@ -3,11 +3,19 @@
 
 #include <base/Time.hpp>
 #include <canmessage.hh>
+#include <canopen_master/Clock.hpp>
 #include <canopen_master/Exceptions.hpp>
 #include <canopen_master/Frame.hpp>
+#include <canopen_master/LatencyHistogram.hpp>
+#include <canopen_master/ObjectHistory.hpp>
+#include <canopen_master/PDO.hpp>
 #include <canopen_master/PDOCommunicationParameters.hpp>
 #include <canopen_master/PDOMapping.hpp>
+#include <canopen_master/ProtocolCounters.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <limits>
 #include <map>
 #include <vector>
@@ -41,7 +49,27 @@ namespace canopen_master {
             /** Received a heartbeat */
             PROCESSED_HEARTBEAT,
             /** Received an emergency message with no error in it */
-            PROCESSED_EMERGENCY_NO_ERROR
+            PROCESSED_EMERGENCY_NO_ERROR,
+            /** Received an emergency message reporting an error, when
+             * setThrowOnDeviceErrors is false. See getLastEmergency */
+            PROCESSED_EMERGENCY,
+            /** Received a SDO abort, when setThrowOnDeviceErrors is false.
+             * See getLastSDOAbortCode */
+            PROCESSED_SDO_ABORT
+        };
+
+        /** Flags set in Update::flags when processing synchronous TPDOs
+         *
+         * See declareTPDOMapping and setSyncCycle
+         */
+        enum UPDATE_FLAGS {
+            /** The PDO arrived after the end of the synchronous window */
+            PDO_LATE = 0x1,
+            /** The PDO has already been received for this SYNC cycle */
+            PDO_DUPLICATE = 0x2,
+            /** One or more occurences of this PDO have been missed since
+             * the last one was received */
+            PDO_MISSED = 0x4
         };
 
         enum QUIRKS {
@@ -52,6 +80,11 @@ namespace canopen_master {
             UPDATE_EVENT mode;
             int update_count;
             ObjectIdentifier updated[8];
+            /** Combination of UPDATE_FLAGS */
+            uint8_t flags;
+            /** For synchronous TPDOs, the SYNC cycle the PDO has been
+             * attributed to */
+            uint64_t sync_cycle;
 
             Update();
             Update(UPDATE_EVENT mode);
@@ -105,6 +138,34 @@ namespace canopen_master {
             }
         };
 
+        /** Statistics about the reception of a synchronous TPDO */
+        struct TPDOStatistics {
+            uint32_t received = 0;
+            uint32_t late = 0;
+            uint32_t duplicates = 0;
+            uint32_t missed = 0;
+            /** SYNC cycle of the last received PDO */
+            uint64_t lastCycle = 0;
+        };
+
+        /** An object written by process(), as passed to its subscribers */
+        struct ObjectUpdate {
+            uint16_t objectId;
+            uint8_t subId;
+            uint8_t const* data;
+            uint8_t size;
+            Timestamp timestamp;
+
+            /** See decodeObjectValue */
+            template <typename T> T as() const
+            {
+                return decodeObjectValue<T>(data, size);
+            }
+        };
+
+        typedef std::function<void(ObjectUpdate const&)> ObjectCallback;
+        typedef uint32_t SubscriptionID;
+
     private:
         /** The ID of the node we're talking to
          */
@@ -112,14 +173,34 @@ namespace canopen_master {
 
         uint64_t quirks = 0;
 
-        struct ObjectValue {
-            uint16_t objectId;
-            uint8_t subId;
+        Clock const* clock = &SystemClock::instance();
 
-            base::Time lastUpdate;
+        static const int32_t NO_SUBSCRIPTION_SLOT = -1;
+        static const int32_t NO_HISTORY_SLOT = -1;
+
+        /** Dictionary entry. The object ID is the dictionary key */
+        struct ObjectValue {
+            /** Time of the last update, or zero if the object has never been
+             * read */
+            Timestamp lastUpdate = 0;
             uint8_t data[4];
             mutable uint8_t size;
             mutable bool knownSize;
+            /** Index of the object's subscribers in subscriptionSlots */
+            int32_t subscriptionSlot = NO_SUBSCRIPTION_SLOT;
+            /** Index of the object's history in histories */
+            int32_t historySlot = NO_HISTORY_SLOT;
+        };
+
+        struct Subscription {
+            SubscriptionID id;
+            ObjectCallback callback;
+        };
+
+        /** The subscribers of one object */
+        struct SubscriptionSlot {
+            ObjectIdentifier object;
+            std::vector<Subscription> subscriptions;
         };
 
         typedef std::map<ObjectIdentifier, ObjectValue> Dictionary;
@@ -132,8 +213,53 @@ namespace canopen_master {
 
         PDOMappings rpdoMappings;
         PDOMappings tpdoMappings;
+
+        struct TPDOTracking {
+            /** Expected number of SYNCs between two PDOs, or zero if the
+             * PDO is not cyclic synchronous */
+            uint16_t syncPeriod = 0;
+            bool synchronous = false;
+            TPDOStatistics statistics;
+        };
+        std::vector<TPDOTracking> tpdoTracking;
+
+        /** Latency histograms, see enableLatencyStatistics */
+        struct LatencyStatistics {
+            LatencyHistogram sdoRoundTrip;
+            LatencyHistogram syncToTPDO[MAX_PDO + 1];
+            LatencyHistogram tpdoJitter[MAX_PDO + 1];
+            base::Time tpdoLastReception[MAX_PDO + 1];
+            base::Time tpdoLastInterval[MAX_PDO + 1];
+        };
+        /** Empty unless enabled. A vector keeps the state machine copyable */
+        std::vector<LatencyStatistics> latencyStatistics;
+        /** Time of the pending SDO request, see notifySent */
+        base::Time sdoRequestTime;
+        /** Object of the pending SDO request, the reply must match it */
+        uint16_t sdoRequestObjectId = 0;
+        uint8_t sdoRequestSubId = 0;
+        /** Not owned, see setProtocolCounters */
+        ProtocolCounters* protocolCounters = nullptr;
+
+        uint64_t syncCycle = 0;
+        base::Time syncTime;
+        base::Time syncWindow;
         Dictionary dictionary;
         bool useUnknownSizes;
+        bool throwOnDeviceErrors = true;
+        Emergency lastEmergency = Emergency();
+        uint32_t lastSDOAbortCode = 0;
+
+        std::vector<SubscriptionSlot> subscriptionSlots;
+        SubscriptionID nextSubscriptionID = 1;
+        /** A deque so that the histories stay in place when others are
+         * added */
+        std::deque<ObjectHistory> histories;
+
+        /** Objects with subscribers written by the frame being processed */
+        ObjectValue const* updatedObjects[MAX_PDO_MAPPED_OBJECTS];
+        size_t updatedObjectCount = 0;
+
         Dictionary::iterator declareInternal(uint16_t objectId,
             uint8_t subId,
             uint8_t size,
@@ -178,9 +304,117 @@ namespace canopen_master {
         /** Sets whether data size field will be unset in SDO communications */
         void setUseUnknownSizes(bool toggle);
 
-        /** Process a message received from nodeId */
+        /** Returns whether errors reported by the device raise exceptions */
+        bool getThrowOnDeviceErrors() const;
+
+        /** Sets whether errors reported by the device raise exceptions
+         *
+         * By default, process throws EmergencyMessageReceived and
+         * SDODomainTransferAborted. When disabled, these are reported as
+         * PROCESSED_EMERGENCY and PROCESSED_SDO_ABORT updates instead, which
+         * unlike exceptions do not allocate.
+         */
+        void setThrowOnDeviceErrors(bool toggle);
+
+        /** The clock used to timestamp the objects written with set and
+         * the SYNC messages when no time is given explicitly */
+        Clock const& getClock() const;
+
+        /** Sets the clock used when no time is given explicitly
+         *
+         * The clock is not owned by the state machine and must remain
+         * valid as long as it is used. The default is
+         * SystemClock::instance()
+         */
+        void setClock(Clock const& clock);
+
+        /** The current time according to getClock() */
+        base::Time now() const;
+
+        /** The last emergency reported as PROCESSED_EMERGENCY */
+        Emergency getLastEmergency() const;
+
+        /** The abort code of the last SDO abort reported as
+         * PROCESSED_SDO_ABORT */
+        uint32_t getLastSDOAbortCode() const;
+
+        /** Process a message received from nodeId
+         *
+         * The subscribers of the objects it wrote are called before it
+         * returns, even if it throws
+         */
         Update process(canbus::Message const& msg);
 
+        /** Call the callback each time process() writes the given object
+         *
+         * The callbacks of a frame are called once the whole frame has been
+         * processed, in the order in which the objects were written.
+         * Finding them does not depend on the number of subscribed objects.
+         * Objects written with set() do not trigger the callbacks.
+         *
+         * Callbacks must not subscribe or unsubscribe.
+         *
+         * @return an ID to pass to unsubscribe
+         */
+        SubscriptionID subscribe(uint16_t objectId, uint8_t subId,
+                                 ObjectCallback callback);
+
+        /** Subscribe to an object defined with CANOPEN_DEFINE_OBJECT
+         *
+         * The callback gets the decoded value and its timestamp
+         */
+        template <typename T>
+        SubscriptionID subscribe(
+            std::function<void(typename T::OBJECT_TYPE, base::Time const&)> callback,
+            int offsetId = 0, int offsetSubId = 0)
+        {
+            return subscribe(T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId,
+                [callback](ObjectUpdate const& update) {
+                    callback(update.as<typename T::OBJECT_TYPE>(),
+                             toTime(update.timestamp));
+                });
+        }
+
+        /** Remove a subscription. Does nothing if it does not exist */
+        void unsubscribe(SubscriptionID id);
+
+        /** Keep the last values of an object
+         *
+         * Each time the object is written, its value and timestamp are
+         * appended to a history of the given capacity, allocated by this
+         * call. If the object already has a history, it is returned
+         * unchanged.
+         *
+         * The history can be read from other threads while this state
+         * machine processes frames, see ObjectHistory. It remains valid as
+         * long as the state machine.
+         */
+        ObjectHistory const& enableHistory(uint16_t objectId, uint8_t subId,
+                                           size_t capacity);
+
+        /** Keep the last values of an object defined with
+         * CANOPEN_DEFINE_OBJECT */
+        template <typename T>
+        ObjectHistory const& enableHistory(size_t capacity,
+                                           int offsetId = 0, int offsetSubId = 0)
+        {
+            return enableHistory(T::OBJECT_ID + offsetId,
+                                 T::OBJECT_SUB_ID + offsetSubId, capacity);
+        }
+
+        /** The history of an object
+         *
+         * @throw std::invalid_argument if enableHistory has not been called
+         *   for this object
+         */
+        ObjectHistory const& getHistory(uint16_t objectId, uint8_t subId) const;
+
+        template <typename T>
+        ObjectHistory const& getHistory(int offsetId = 0, int offsetSubId = 0) const
+        {
+            return getHistory(T::OBJECT_ID + offsetId, T::OBJECT_SUB_ID + offsetSubId);
+        }
+
         /** Request reading the given dictionary object */
         canbus::Message upload(uint16_t objectId, uint8_t subId) const;
 
@@ -226,6 +460,14 @@ namespace canopen_master {
          */
         base::Time timestamp(uint16_t objectId, uint8_t subId) const;
 
+        /** Returns the timestamp of the last read value for this object,
+         * in nanoseconds
+         *
+         * Returns zero if the object has never been read. Use this rather
+         * than timestamp() to compare the ages of objects in cyclic code
+         */
+        Timestamp getTimestamp(uint16_t objectId, uint8_t subId) const;
+
         /** Returns the SYNC message
          *
          * The SYNC message triggers sending the PDOs that have been
@@ -233,6 +475,19 @@ namespace canopen_master {
          */
         static canbus::Message sync();
 
+        /** Returns a SYNC message with the given CiA 301 SYNC counter
+         *
+         * See SyncProducer to produce SYNCs at a fixed period
+         */
+        static canbus::Message sync(uint8_t counter);
+
+        /** Returns a SYNC message timestamped using the given clock
+         *
+         * @arg counter the CiA 301 SYNC counter, or zero for a SYNC message
+         *   without counter
+         */
+        static canbus::Message sync(Clock const& clock, uint8_t counter = 0);
+
         /** Get raw data from a given object */
         uint32_t get(uint16_t objectId,
             uint16_t subId,
@@ -244,11 +499,38 @@ namespace canopen_master {
         void set(uint16_t objectId,
             uint8_t subId,
             T value,
-            base::Time const& time = base::Time::now())
+            base::Time const& time)
+        {
+            if (time.isNull()) {
+                throw std::invalid_argument(
+                    "attempting to set an object with a zero update time");
+            }
+            setTimestamped<T>(objectId, subId, value, toTimestamp(time));
+        }
+
+        /** Set an object's value in the dictionary, timestamped with
+         * getClock() */
+        template <typename T>
+        void set(uint16_t objectId, uint8_t subId, T value)
+        {
+            setTimestamped<T>(objectId, subId, value, clock->nowTimestamp());
+        }
+
+        /** Set an object's value in the dictionary, with a Timestamp
+         *
+         * @throw std::invalid_argument if the timestamp is zero
+         */
+        template <typename T>
+        void setTimestamped(uint16_t objectId, uint8_t subId, T value,
+                            Timestamp timestamp)
         {
+            if (timestamp == 0) {
+                throw std::invalid_argument(
+                    "attempting to set an object with a zero update time");
+            }
             uint8_t buffer[sizeof(value)];
             toLittleEndian(buffer, value);
-            setObjectValue(objectId, subId, time, buffer, sizeof(value));
+            setObjectValue(objectId, subId, timestamp, buffer, sizeof(value));
         }
 
         uint32_t getObjectSize(uint16_t objectId, uint16_t subId) const;
@@ -262,12 +544,6 @@ namespace canopen_master {
                 throw ObjectNotRead(
                     "attempting to get an object that has never been read");
 
-            // Extend `data` if the type is integral and signed
-            if (std::numeric_limits<T>::is_integer &&
-                std::numeric_limits<T>::is_signed) {
-                extendSignBit(data, size);
-            }
-
             const ObjectValue& object =
                 dictionary.find(ObjectIdentifier(objectId, subId))->second;
             if (size > sizeof(T) && object.knownSize) {
@@ -277,7 +553,7 @@ namespace canopen_master {
                 object.size = sizeof(T);
                 object.knownSize = true;
             }
-            return fromLittleEndian<T>(data);
+            return decodeObjectValue<T>(data, size);
         }
 
         static void extendSignBit(uint8_t* data, size_t dataSize);
@@ -303,6 +579,40 @@ namespace canopen_master {
             uint8_t pdoIndex,
             PDOMapping const& mapping) const;
 
+        /** Allocation-free version of configurePDO
+         *
+         * @arg messages output buffer, with room for at least
+         *   MAX_PDO_CONFIGURATION_MESSAGES messages
+         * @return the number of messages written in the buffer
+         */
+        size_t configurePDO(bool transmit,
+            uint8_t pdoIndex,
+            PDOCommunicationParameters const& parameters,
+            PDOMapping const& mapping,
+            canbus::Message* messages) const;
+
+        /** Allocation-free version of configurePDOParameters
+         *
+         * @arg messages output buffer, with room for at least
+         *   MAX_PDO_COMMUNICATION_PARAMETERS_MESSAGES messages
+         * @return the number of messages written in the buffer
+         */
+        size_t configurePDOParameters(bool transmit,
+            uint8_t pdoIndex,
+            PDOCommunicationParameters const& parameters,
+            canbus::Message* messages) const;
+
+        /** Allocation-free version of configurePDOMapping
+         *
+         * @arg messages output buffer, with room for at least
+         *   MAX_PDO_MAPPING_MESSAGES messages
+         * @return the number of messages written in the buffer
+         */
+        size_t configurePDOMapping(bool transmit,
+            uint8_t pdoIndex,
+            PDOMapping const& mapping,
+            canbus::Message* messages) const;
+
         /** Declare a TPDO mapping to the state machine
          *
          * TPDOs are PDOs sent by the slave
@@ -312,6 +622,85 @@ namespace canopen_master {
          */
         void declareTPDOMapping(uint8_t pdoIndex, PDOMapping const& mapping);
 
+        /** Declare a TPDO mapping along with the PDO communication parameters
+         *
+         * If the PDO is synchronous, the state machine will attribute each
+         * received PDO to the last SYNC cycle declared with setSyncCycle, and
+         * flag late, duplicate and missed PDOs (see UPDATE_FLAGS and
+         * getTPDOStatistics)
+         */
+        void declareTPDOMapping(uint8_t pdoIndex, PDOMapping const& mapping,
+                                PDOCommunicationParameters const& parameters);
+
+        /** Declare that a SYNC has been sent on the bus
+         *
+         * @arg cycle the cycle number, as e.g. SyncProducer::getCycle
+         * @arg time the time at which the SYNC has been sent
+         */
+        void setSyncCycle(uint64_t cycle, base::Time const& time);
+
+        /** Returns the cycle of the last SYNC declared with setSyncCycle */
+        uint64_t getSyncCycle() const;
+
+        /** Set the synchronous window length
+         *
+         * Synchronous TPDOs received more than this time after the SYNC
+         * are flagged as late. Set to a null time (the default) to disable
+         */
+        void setSyncWindow(base::Time const& window);
+
+        /** Reception statistics of a synchronous TPDO */
+        TPDOStatistics const& getTPDOStatistics(uint8_t pdoIndex) const;
+
+        /** Number of SYNC cycles since the given synchronous TPDO has last
+         * been received */
+        uint64_t getTPDOAge(uint8_t pdoIndex) const;
+
+        /** Start recording latency histograms
+         *
+         * The state machine then records:
+         * - the round-trip time of SDO transactions, from the time given
+         *   to notifySent for the request to the reception of the reply
+         * - for synchronous TPDOs, the delay between the SYNC declared
+         *   with setSyncCycle and the reception of the PDO
+         * - for all TPDOs, the reception jitter, i.e. the difference
+         *   between two consecutive intervals between receptions
+         *
+         * The histograms are allocated by this call. Recording is constant
+         * time and does not allocate. They can be read from another thread,
+         * see LatencyHistogram.
+         */
+        void enableLatencyStatistics();
+
+        bool hasLatencyStatistics() const;
+
+        /** Declare that a frame to this node has been sent
+         *
+         * This is used to measure the round-trip time of SDO requests. The
+         * time is recorded on the next reply for the same object. SDOClient
+         * calls it for the requests it sends
+         */
+        void notifySent(canbus::Message const& msg, base::Time const& time);
+
+        /** @throw std::logic_error if latency statistics are not enabled */
+        LatencyHistogram const& getSDORoundTripHistogram() const;
+
+        /** @throw std::logic_error if latency statistics are not enabled */
+        LatencyHistogram const& getSyncToTPDOHistogram(uint8_t pdoIndex) const;
+
+        /** @throw std::logic_error if latency statistics are not enabled */
+        LatencyHistogram const& getTPDOJitterHistogram(uint8_t pdoIndex) const;
+
+        /** Count the protocol events of this node in the given counters
+         *
+         * The counters are not owned, and are usually shared by all the
+         * state machines of a bus. Set to nullptr to stop counting.
+         */
+        void setProtocolCounters(ProtocolCounters* counters);
+
+        /** The counters set with setProtocolCounters, or nullptr */
+        ProtocolCounters* getProtocolCounters() const;
+
         /** Declare a RPDO mapping to the state machine
          *
          * RPDOs are PDOs sent to the slave
@@ -322,18 +711,28 @@ namespace canopen_master {
 
         /** Return the RPDO message that corresponds to the mapping declared with
          * declareRPDOMapping
+         *
+         * This does not allocate
          */
         canbus::Message getRPDOMessage(unsigned int pdoIndex);
 
     private:
         void validatePDOMapping(PDOMapping const& mapping) const;
+        Update processMessage(canbus::Message const& msg);
+        void notifySubscribers();
         Update processEmergency(canbus::Message const& msg);
         Update processSDOReceive(canbus::Message const& msg);
         Update processHeartbeat(canbus::Message const& msg);
         Update processPDOReceive(int pdoIndex, canbus::Message const& msg);
+        void recordTPDOJitter(int pdoIndex, base::Time const& time);
+        void count(PROTOCOL_COUNTER counter, uint64_t value = 1);
+        void trackSynchronousPDO(int pdoIndex, canbus::Message const& msg,
+                                 Update& update);
+        /** Write a value in the dictionary. The timestamp is expected to
+         * have been validated by the caller */
         void setObjectValue(uint16_t objectId,
             uint8_t subId,
-            base::Time const& time,
+            Timestamp timestamp,
             uint8_t const* data,
             uint32_t dataSize);
 
@@ -0,0 +1,153 @@
+#include <canopen_master/SyncProducer.hpp>
+#include <cerrno>
+#include <cmath>
+#include <stdexcept>
+#include <time.h>
+
+using namespace canopen_master;
+
+static const int64_t NS_PER_SEC = 1000000000LL;
+
+static int64_t monotonicNow()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void sleepUntil(int64_t deadline)
+{
+    timespec ts;
+    ts.tv_sec = deadline / NS_PER_SEC;
+    ts.tv_nsec = deadline % NS_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR);
+}
+
+canbus::Message canopen_master::makeSyncMessage(uint8_t counter,
+                                                base::Time const& time)
+{
+    canbus::Message msg;
+    msg.time = time;
+    msg.can_id = BROADCAST_SYNC;
+    if (counter) {
+        msg.size = 1;
+        msg.data[0] = counter;
+    }
+    else {
+        msg.size = 0;
+    }
+    return msg;
+}
+
+bool canopen_master::hasSyncCounter(canbus::Message const& msg)
+{
+    return msg.size != 0;
+}
+
+uint8_t canopen_master::getSyncCounter(canbus::Message const& msg)
+{
+    if (!testBroadcastMessage(msg, BROADCAST_SYNC))
+        throw std::invalid_argument("expected a SYNC message");
+    return msg.size ? msg.data[0] : 0;
+}
+
+void SyncStatistics::add(int64_t latency)
+{
+    if (cycles == 0 || latency < minLatency)
+        minLatency = latency;
+    if (cycles == 0 || latency > maxLatency)
+        maxLatency = latency;
+    cycles++;
+    sumLatency += latency;
+    sumSquaredLatency += static_cast<double>(latency) * latency;
+}
+
+double SyncStatistics::getMeanLatency() const
+{
+    return cycles ? sumLatency / cycles : 0;
+}
+
+double SyncStatistics::getLatencyStdDev() const
+{
+    if (cycles == 0)
+        return 0;
+    double mean = getMeanLatency();
+    double variance = sumSquaredLatency / cycles - mean * mean;
+    return variance > 0 ? std::sqrt(variance) : 0;
+}
+
+SyncProducer::SyncProducer(base::Time const& period, uint8_t counterOverflow)
+    : period(period.toMicroseconds() * 1000)
+    , counterOverflow(counterOverflow)
+{
+    if (this->period <= 0)
+        throw std::invalid_argument("SYNC period must be strictly positive");
+    if (counterOverflow == 1 || counterOverflow > 240)
+        throw std::invalid_argument(
+            "SYNC counter overflow must be zero or between 2 and 240");
+}
+
+void SyncProducer::setSpinTime(base::Time const& time)
+{
+    spinTime = time.toMicroseconds() * 1000;
+}
+
+void SyncProducer::start()
+{
+    deadline = monotonicNow() + period;
+    started = true;
+}
+
+canbus::Message SyncProducer::wait()
+{
+    if (!started)
+        start();
+
+    if (spinTime)
+        sleepUntil(deadline - spinTime);
+    else
+        sleepUntil(deadline);
+
+    int64_t now = monotonicNow();
+    while (now < deadline)
+        now = monotonicNow();
+
+    int64_t latency = now - deadline;
+    statistics.add(latency);
+    cycle++;
+
+    // If we are late by more than one period, skip the deadlines we missed
+    // instead of producing a burst of SYNCs
+    int64_t skipped = latency / period;
+    statistics.overruns += skipped;
+    deadline += (skipped + 1) * period;
+
+    return makeSyncMessage(getCounter(), base::Time::now());
+}
+
+uint64_t SyncProducer::getCycle() const
+{
+    return cycle;
+}
+
+uint8_t SyncProducer::getCounter() const
+{
+    return getCounter(cycle, counterOverflow);
+}
+
+uint8_t SyncProducer::getCounter(uint64_t cycle, uint8_t counterOverflow)
+{
+    if (counterOverflow == 0 || cycle == 0)
+        return 0;
+    return (cycle - 1) % counterOverflow + 1;
+}
+
+SyncStatistics const& SyncProducer::getStatistics() const
+{
+    return statistics;
+}
+
+void SyncProducer::resetStatistics()
+{
+    statistics = SyncStatistics();
+}
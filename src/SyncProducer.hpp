@@ -0,0 +1,109 @@
+#ifndef CANOPEN_MASTER_SYNC_PRODUCER_HPP
+#define CANOPEN_MASTER_SYNC_PRODUCER_HPP
+
+#include <base/Time.hpp>
+#include <canopen_master/Frame.hpp>
+
+namespace canopen_master
+{
+    /** Create a SYNC message
+     *
+     * @arg counter the CiA 301 SYNC counter, or zero to create a SYNC
+     *   message without counter
+     */
+    canbus::Message makeSyncMessage(uint8_t counter, base::Time const& time);
+
+    /** Whether the given SYNC message has a SYNC counter */
+    bool hasSyncCounter(canbus::Message const& msg);
+
+    /** Return the SYNC counter of a SYNC message, or zero if it has none */
+    uint8_t getSyncCounter(canbus::Message const& msg);
+
+    /** Statistics about the SYNC release times
+     *
+     * The latency is the time between the SYNC deadline and the actual time
+     * at which wait() returned. All values are in nanoseconds.
+     */
+    struct SyncStatistics
+    {
+        /** How many SYNCs have been produced */
+        uint64_t cycles = 0;
+        /** How many cycles have been skipped because the producer was late
+         * by more than one period */
+        uint64_t overruns = 0;
+        int64_t minLatency = 0;
+        int64_t maxLatency = 0;
+        double sumLatency = 0;
+        double sumSquaredLatency = 0;
+
+        void add(int64_t latency);
+        double getMeanLatency() const;
+        double getLatencyStdDev() const;
+    };
+
+    /** Production of SYNC messages at a fixed period
+     *
+     * The producer computes absolute deadlines on the monotonic clock, and
+     * sleeps until each of them using clock_nanosleep. Deadlines therefore
+     * do not drift, regardless of how much time is spent between two calls
+     * to wait(). The end of the sleep can optionally be replaced by a
+     * busy-wait (setSpinTime) to reduce the wakeup latency.
+     *
+     * If a CiA 301 counter overflow value is given, the SYNC messages
+     * carry the SYNC counter, which goes from 1 to the overflow value.
+     * getCycle() returns the (non-wrapping) number of the last produced
+     * SYNC, which allows to match PDOs with cycles
+     */
+    class SyncProducer
+    {
+    public:
+        /**
+         * @arg period the SYNC period
+         * @arg counterOverflow the value of the SYNC counter overflow
+         *   (object 0x1019). Zero disables the counter, otherwise it
+         *   must be between 2 and 240
+         */
+        SyncProducer(base::Time const& period, uint8_t counterOverflow = 0);
+
+        /** Busy-wait for the given amount of time before each deadline
+         * instead of sleeping */
+        void setSpinTime(base::Time const& time);
+
+        /** Set the time of the first deadline to one period from now
+         *
+         * It is called automatically by the first call to wait()
+         */
+        void start();
+
+        /** Wait for the next deadline, and return the SYNC message that
+         * should be sent */
+        canbus::Message wait();
+
+        /** Number of the last produced SYNC, starting at 1
+         *
+         * Zero if no SYNC has been produced yet
+         */
+        uint64_t getCycle() const;
+
+        /** SYNC counter of the last produced SYNC */
+        uint8_t getCounter() const;
+
+        /** Compute the SYNC counter of a given cycle */
+        static uint8_t getCounter(uint64_t cycle, uint8_t counterOverflow);
+
+        SyncStatistics const& getStatistics() const;
+        void resetStatistics();
+
+    private:
+        int64_t period;
+        int64_t spinTime = 0;
+        uint8_t counterOverflow;
+        uint64_t cycle = 0;
+        /** Next deadline on the monotonic clock, in nanoseconds */
+        int64_t deadline = 0;
+        bool started = false;
+        SyncStatistics statistics;
+    };
+}
+
+#endif
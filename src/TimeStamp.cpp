@@ -0,0 +1,40 @@
+#include <canopen_master/TimeStamp.hpp>
+#include <stdexcept>
+
+using namespace canopen_master;
+
+/** TIME_OF_DAY counts days since 1984-01-01, this is that date as a Unix
+ * timestamp */
+static const int64_t EPOCH_1984 = 441763200LL;
+static const int64_t MS_PER_DAY = 86400000LL;
+
+canbus::Message canopen_master::makeTimeStampMessage(base::Time const& time)
+{
+    int64_t ms = time.toMilliseconds() - EPOCH_1984 * 1000;
+    if (ms < 0)
+        throw std::invalid_argument("cannot represent times before 1984 in a TIME message");
+
+    uint32_t msOfDay = ms % MS_PER_DAY;
+    int64_t days = ms / MS_PER_DAY;
+    if (days > 0xFFFF)
+        throw std::invalid_argument("time too far in the future for a TIME message");
+
+    canbus::Message msg;
+    msg.time = time;
+    msg.can_id = BROADCAST_TIMESTAMP;
+    msg.size = 6;
+    toLittleEndian<uint32_t>(msg.data, msOfDay);
+    toLittleEndian<uint16_t>(msg.data + 4, days);
+    return msg;
+}
+
+base::Time canopen_master::parseTimeStampMessage(canbus::Message const& msg)
+{
+    if (!testBroadcastMessage(msg, BROADCAST_TIMESTAMP) || msg.size != 6)
+        throw std::invalid_argument("expected a TIME message");
+
+    int64_t msOfDay = fromLittleEndian<uint32_t>(msg.data) & 0x0FFFFFFF;
+    int64_t days = fromLittleEndian<uint16_t>(msg.data + 4);
+    return base::Time::fromMilliseconds(
+        EPOCH_1984 * 1000 + days * MS_PER_DAY + msOfDay);
+}
@@ -0,0 +1,20 @@
+#ifndef CANOPEN_MASTER_TIME_STAMP_HPP
+#define CANOPEN_MASTER_TIME_STAMP_HPP
+
+#include <base/Time.hpp>
+#include <canopen_master/Frame.hpp>
+
+namespace canopen_master
+{
+    /** Create a TIME message (CiA 301 TIME_OF_DAY) for the given time
+     *
+     * TIME_OF_DAY has a millisecond resolution, the sub-millisecond part of
+     * the time is dropped
+     */
+    canbus::Message makeTimeStampMessage(base::Time const& time);
+
+    /** Decode a TIME message */
+    base::Time parseTimeStampMessage(canbus::Message const& msg);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef CANOPEN_MASTER_TEST_ALLOCATION_COUNTER_HPP
+#define CANOPEN_MASTER_TEST_ALLOCATION_COUNTER_HPP
+
+#include <cstdint>
+
+namespace canopen_master
+{
+    /** Count of calls to operator new since the program started
+     *
+     * Linking AllocationCounter.cpp in an executable replaces the global
+     * operator new and delete to maintain this count
+     */
+    uint64_t getAllocationCount();
+}
+
+#endif
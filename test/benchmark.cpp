@@ -0,0 +1,321 @@
+#include "AllocationCounter.hpp"
+#include <canopen_master/StateMachine.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/PDO.hpp>
+#include <canopen_master/FrameRing.hpp>
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/FrameRecorder.hpp>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+
+/** Prevent the compiler from optimizing away the computation of a value */
+template<typename T>
+inline void doNotOptimize(T const& value)
+{
+    asm volatile("" : : "m"(value) : "memory");
+}
+
+/** Minimal benchmark runner
+ *
+ * Each benchmark is run with an increasing number of iterations until it
+ * lasts at least minTime, and reported as time and allocations per
+ * iteration
+ */
+struct Benchmark
+{
+    string filter;
+    double minTime = 0.2;
+
+    template<typename F>
+    void run(string const& name, F f)
+    {
+        if (name.find(filter) == string::npos)
+            return;
+
+        for (int i = 0; i < 1000; ++i)
+            f();
+
+        uint64_t iterations = 1000;
+        while (true) {
+            uint64_t allocations = getAllocationCount();
+            auto start = chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+                f();
+            double elapsed = chrono::duration<double>(
+                chrono::steady_clock::now() - start).count();
+            allocations = getAllocationCount() - allocations;
+
+            if (elapsed >= minTime) {
+                cout << left << setw(48) << name << right << fixed
+                    << setw(10) << setprecision(1) << elapsed * 1e9 / iterations << " ns/op"
+                    << setw(10) << setprecision(2) << double(allocations) / iterations << " allocs/op"
+                    << endl;
+                return;
+            }
+
+            double factor = elapsed > 0 ? minTime * 1.2 / elapsed : 100;
+            iterations *= max(2.0, min(100.0, factor));
+        }
+    }
+};
+
+static const base::Time TIME = base::Time::fromSeconds(1000);
+
+static canbus::Message makeMessage(uint32_t can_id, uint8_t size,
+                                   uint8_t const* data = nullptr)
+{
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = can_id;
+    msg.size = size;
+    msg.time = TIME;
+    if (data)
+        copy(data, data + size, msg.data);
+    return msg;
+}
+
+static void benchmarkProcess(Benchmark& benchmark)
+{
+    StateMachine machine(1);
+    machine.declare(0x2000, 1, 2);
+
+    auto heartbeat = makeMessage(0x701, 1);
+    heartbeat.data[0] = NODE_OPERATIONAL;
+    benchmark.run("process: heartbeat", [&]() {
+        doNotOptimize(machine.process(heartbeat));
+    });
+
+    auto notForMe = makeMessage(0x702, 1);
+    benchmark.run("process: other node", [&]() {
+        doNotOptimize(machine.process(notForMe));
+    });
+
+    auto sync = makeMessage(0x080, 0);
+    benchmark.run("process: SYNC", [&]() {
+        doNotOptimize(machine.process(sync));
+    });
+
+    auto emergencyNoError = makeMessage(0x081, 8);
+    benchmark.run("process: emergency (no error)", [&]() {
+        doNotOptimize(machine.process(emergencyNoError));
+    });
+
+    uint8_t emergencyData[8] = { 0x10, 0x23, 0x03 };
+    auto emergency = makeMessage(0x081, 8, emergencyData);
+    benchmark.run("process: emergency (error)", [&]() {
+        try { machine.process(emergency); }
+        catch(EmergencyMessageReceived const&) {}
+    });
+
+    uint8_t uploadData[8] = { 0x4B, 0x00, 0x20, 0x01, 0x34, 0x12 };
+    auto uploadReply = makeMessage(0x581, 8, uploadData);
+    benchmark.run("process: SDO upload reply", [&]() {
+        doNotOptimize(machine.process(uploadReply));
+    });
+
+    uint8_t downloadData[8] = { 0x60, 0x00, 0x20, 0x01 };
+    auto downloadReply = makeMessage(0x581, 8, downloadData);
+    benchmark.run("process: SDO download reply", [&]() {
+        doNotOptimize(machine.process(downloadReply));
+    });
+
+    uint8_t abortData[8] = { 0x80, 0x00, 0x20, 0x01, 0x00, 0x00, 0x02, 0x06 };
+    auto abort = makeMessage(0x581, 8, abortData);
+    benchmark.run("process: SDO abort", [&]() {
+        try { machine.process(abort); }
+        catch(SDODomainTransferAborted const&) {}
+    });
+}
+
+static void benchmarkPDO(Benchmark& benchmark)
+{
+    for (int count = 1; count <= 8; ++count) {
+        StateMachine machine(1);
+        PDOMapping mapping;
+        for (int i = 0; i < count; ++i)
+            mapping.add(0x2100, i + 1, 1);
+        machine.declareTPDOMapping(0, mapping);
+        machine.declareRPDOMapping(0, mapping);
+
+        uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        auto tpdo = makeMessage(0x181, count, data);
+        benchmark.run("process: TPDO, " + to_string(count) + " objects", [&]() {
+            doNotOptimize(machine.process(tpdo));
+        });
+        benchmark.run("getRPDOMessage: " + to_string(count) + " objects", [&]() {
+            doNotOptimize(machine.getRPDOMessage(0));
+        });
+    }
+
+    // Subscription dispatch with many subscribed objects, of which the
+    // PDO writes a single one
+    StateMachine machine(1);
+    PDOMapping mapping;
+    mapping.add(0x2100, 1, 1);
+    machine.declareTPDOMapping(0, mapping);
+    uint32_t sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        machine.subscribe(0x2100 + i, 1, [&](StateMachine::ObjectUpdate const& update) {
+            sum += update.data[0];
+        });
+    }
+    uint8_t data[8] = { 1 };
+    auto tpdo = makeMessage(0x181, 1, data);
+    benchmark.run("process: TPDO, 1 of 256 subscribed objects", [&]() {
+        doNotOptimize(machine.process(tpdo));
+    });
+    doNotOptimize(sum);
+}
+
+static void benchmarkDictionary(Benchmark& benchmark)
+{
+    StateMachine machine(1);
+    machine.declare(0x2000, 1, 2);
+    machine.declare(0x2000, 2, 4);
+    for (int i = 0; i < 100; ++i)
+        machine.declare(0x3000 + i, 0, 4);
+    machine.set<uint16_t>(0x2000, 1, 0x1234, TIME);
+    machine.set<int32_t>(0x2000, 2, -5, TIME);
+
+    benchmark.run("get<uint16_t>", [&]() {
+        doNotOptimize(machine.get<uint16_t>(0x2000, 1));
+    });
+    benchmark.run("get<int32_t>", [&]() {
+        doNotOptimize(machine.get<int32_t>(0x2000, 2));
+    });
+    uint16_t value = 0;
+    benchmark.run("set<uint16_t>", [&]() {
+        machine.set<uint16_t>(0x2000, 1, ++value, TIME);
+    });
+    benchmark.run("set<uint16_t> (system clock)", [&]() {
+        machine.set<uint16_t>(0x2000, 1, ++value);
+    });
+    MonotonicClock monotonic;
+    machine.setClock(monotonic);
+    benchmark.run("set<uint16_t> (monotonic clock)", [&]() {
+        machine.set<uint16_t>(0x2000, 1, ++value);
+    });
+    CachedClock cached(TIME);
+    machine.setClock(cached);
+    benchmark.run("set<uint16_t> (cached clock)", [&]() {
+        machine.set<uint16_t>(0x2000, 1, ++value);
+    });
+}
+
+static void benchmarkBuilders(Benchmark& benchmark)
+{
+    StateMachine machine(1);
+    benchmark.run("upload", [&]() {
+        doNotOptimize(machine.upload(0x2000, 1));
+    });
+    benchmark.run("download<uint32_t>", [&]() {
+        doNotOptimize(machine.download<uint32_t>(0x2000, 1, 0x12345678));
+    });
+
+    PDOMapping mapping;
+    for (int i = 0; i < 4; ++i)
+        mapping.add(0x2100, i + 1, 2);
+    auto parameters = PDOCommunicationParameters::Periodic(
+        base::Time::fromMilliseconds(10));
+    benchmark.run("makePDOConfigurationMessages: 4 objects", [&]() {
+        doNotOptimize(makePDOConfigurationMessages(true, 1, 0, parameters, mapping));
+    });
+    canbus::Message messages[MAX_PDO_CONFIGURATION_MESSAGES];
+    benchmark.run("makePDOConfigurationMessagesInto: 4 objects", [&]() {
+        doNotOptimize(makePDOConfigurationMessagesInto(true, 1, 0, parameters, mapping, messages));
+        doNotOptimize(messages);
+    });
+}
+
+static void benchmarkFrameRing(Benchmark& benchmark)
+{
+    FrameRing ring(1024);
+    auto msg = makeMessage(0x181, 8);
+    canbus::Message out;
+    benchmark.run("FrameRing: push + pop", [&]() {
+        ring.push(msg);
+        ring.pop(out);
+        doNotOptimize(out);
+    });
+
+    canbus::Message batch[32];
+    benchmark.run("FrameRing: 32 push + batch pop", [&]() {
+        for (int i = 0; i < 32; ++i)
+            ring.push(msg);
+        doNotOptimize(ring.pop(batch, 32));
+    });
+
+    // Cost per frame of the handoff to a consumer running on another thread
+    atomic<bool> quit(false);
+    thread consumer([&]() {
+        canbus::Message received[32];
+        while (!quit.load(memory_order_relaxed)) {
+            if (ring.pop(received, 32) == 0)
+                this_thread::yield();
+        }
+    });
+    benchmark.run("FrameRing: push to another thread", [&]() {
+        while (!ring.push(msg))
+            this_thread::yield();
+    });
+    quit = true;
+    consumer.join();
+
+    StateMachine machine(1);
+    Dispatcher dispatcher;
+    dispatcher.add(machine);
+    auto heartbeat = makeMessage(0x701, 1);
+    heartbeat.data[0] = NODE_OPERATIONAL;
+    benchmark.run("Dispatcher: heartbeat from ring", [&]() {
+        ring.push(heartbeat);
+        dispatcher.process(ring, [](canbus::Message const&,
+                                    StateMachine::Update const& update) {
+            doNotOptimize(update);
+        });
+    });
+}
+
+static void benchmarkFrameRecorder(Benchmark& benchmark)
+{
+    // One minute at 8000 frames/s
+    string path = "/tmp/canopen_master_benchmark.rec";
+    FrameRecorder recorder(path, FrameRecorder::getCapacityFor(
+        base::Time::fromSeconds(60), 8000));
+    unlink(path.c_str());
+    auto msg = makeMessage(0x181, 8);
+    benchmark.run("FrameRecorder: record", [&]() {
+        recorder.record(msg);
+    });
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark;
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        if (arg == "--min-time" && i + 1 < argc)
+            benchmark.minTime = stod(argv[++i]);
+        else if (arg == "--help" || arg == "-h") {
+            cout << "benchmark [--min-time SECONDS] [FILTER]\n"
+                << "  runs the benchmarks whose name contains FILTER" << endl;
+            return 0;
+        }
+        else
+            benchmark.filter = arg;
+    }
+
+    benchmarkProcess(benchmark);
+    benchmarkPDO(benchmark);
+    benchmarkDictionary(benchmark);
+    benchmarkBuilders(benchmark);
+    benchmarkFrameRing(benchmark);
+    benchmarkFrameRecorder(benchmark);
+    return 0;
+}
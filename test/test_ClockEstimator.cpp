@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <canopen_master/ClockEstimator.hpp>
+#include <canopen_master/TimeStamp.hpp>
+
+using namespace base;
+using namespace canopen_master;
+
+TEST(TimeStamp, it_encodes_the_time_of_day_since_1984) {
+    // 2020-01-01 12:00:00.123 UTC
+    Time time = Time::fromMilliseconds(1577880000123ULL);
+    auto msg = makeTimeStampMessage(time);
+    ASSERT_EQ(0x100, msg.can_id);
+    ASSERT_EQ(6, msg.size);
+    ASSERT_EQ(43200123, fromLittleEndian<uint32_t>(msg.data));
+    ASSERT_EQ(13149, fromLittleEndian<uint16_t>(msg.data + 4));
+}
+
+TEST(TimeStamp, it_decodes_a_TIME_message) {
+    Time time = Time::fromMilliseconds(1577880000123ULL);
+    ASSERT_EQ(time, parseTimeStampMessage(makeTimeStampMessage(time)));
+}
+
+TEST(TimeStamp, it_rejects_other_messages) {
+    canbus::Message msg;
+    msg.can_id = 0x80;
+    msg.size = 6;
+    ASSERT_THROW(parseTimeStampMessage(msg), std::invalid_argument);
+}
+
+TEST(ClockEstimator, it_estimates_offset_and_drift) {
+    ClockEstimator estimator;
+    Time host0 = Time::fromSeconds(1000);
+    // Device clock runs 100ppm fast, messages are delayed by 100 to 300us
+    for (int i = 0; i < 50; ++i) {
+        int64_t device = 5000000 + i * 100000;
+        int64_t delay = 100 + (i * 37) % 200;
+        Time host = host0 + Time::fromMicroseconds(i * 100000 / 1.0001 + delay);
+        estimator.update(device, host);
+    }
+    ASSERT_TRUE(estimator.isValid());
+    ASSERT_NEAR(-1e-4, estimator.getDrift(), 1e-5);
+
+    Time expected = host0 + Time::fromMicroseconds(60 * 100000 / 1.0001 + 100);
+    Time actual = estimator.toHostTime(5000000 + 60 * 100000);
+    ASSERT_NEAR(expected.toMicroseconds(), actual.toMicroseconds(), 20);
+}
+
+TEST(ClockEstimator, it_unwraps_device_counters) {
+    ClockEstimator estimator;
+    Time host0 = Time::fromSeconds(1000);
+    for (int i = 0; i < 10; ++i) {
+        uint16_t counter = 65000 + i * 200;
+        estimator.updateCounter(counter, 16, 1, host0 + Time::fromMicroseconds(i * 200));
+    }
+    ASSERT_NEAR(0, estimator.getDrift(), 1e-9);
+    ASSERT_EQ(65000 + 9 * 200, estimator.getLastDeviceTime());
+    ASSERT_EQ(host0 + Time::fromMicroseconds(10 * 200),
+              estimator.counterToHostTime((65000 + 10 * 200) % 65536, 16, 1));
+}
+
+TEST(ClockEstimator, it_estimates_the_drift_from_heartbeats) {
+    ClockEstimator estimator;
+    Time host0 = Time::fromSeconds(1000);
+    Time period = Time::fromMilliseconds(100);
+    for (int i = 0; i < 20; ++i) {
+        // Skip one heartbeat
+        if (i == 10)
+            continue;
+        estimator.updateHeartbeat(
+            host0 + Time::fromMicroseconds(i * 100000 * 1.001), period);
+    }
+    ASSERT_EQ(19 * 100000, estimator.getLastDeviceTime());
+    ASSERT_NEAR(1e-3, estimator.getDrift(), 1e-5);
+}
+
+TEST(ClockEstimator, it_rejects_a_null_heartbeat_period) {
+    ClockEstimator estimator;
+    ASSERT_THROW(estimator.updateHeartbeat(Time::fromSeconds(1000), Time()),
+                 std::invalid_argument);
+}
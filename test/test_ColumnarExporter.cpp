@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <canopen_master/ColumnarExporter.hpp>
+#include <canopen_master/Objects.hpp>
+#include <sys/resource.h>
+#include <csignal>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+
+struct ColumnarExporterTest : public ::testing::Test {
+    string path = "/tmp/canopen_master_test_" + to_string(getpid()) + ".cols";
+    StateMachine machine;
+    base::Time time = base::Time::fromSeconds(100);
+
+    ColumnarExporterTest()
+        : machine(2) {
+        PDOMapping mapping;
+        mapping.add(0x6000, 1, 2);
+        mapping.add(0x6000, 2, 4);
+        machine.declareTPDOMapping(0, mapping);
+    }
+
+    ~ColumnarExporterTest() {
+        unlink(path.c_str());
+    }
+
+    void receivePDO(int i) {
+        auto msg = canbus::Message::Zeroed();
+        msg.time = time + base::Time::fromMilliseconds(i);
+        msg.can_id = FUNCTION_PDO0_TRANSMIT + 2;
+        msg.size = 6;
+        toLittleEndian<int16_t>(msg.data, -i);
+        toLittleEndian<uint32_t>(msg.data + 2, i * 1000);
+        machine.process(msg);
+    }
+};
+
+TEST_F(ColumnarExporterTest, it_exports_one_time_series_per_object) {
+    {
+        ColumnarExporter exporter(path, 4);
+        ASSERT_EQ(0, exporter.add(machine, 0x6000, 1, COLUMN_INT16));
+        ASSERT_EQ(1, exporter.add(machine, 0x6000, 2, COLUMN_UINT32));
+        for (int i = 0; i < 10; ++i)
+            receivePDO(i);
+        machine.set<uint8_t>(ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID, 1, time);
+        ASSERT_EQ(2, exporter.add<ErrorRegister>(machine));
+        ASSERT_EQ(10, exporter.getSampleCount(0));
+        ASSERT_EQ(0, exporter.getSampleCount(2));
+    }
+
+    ColumnarReader reader(path);
+    ASSERT_EQ(3, reader.getColumnCount());
+    ASSERT_EQ(1, reader.find(2, 0x6000, 2));
+    ASSERT_EQ(2, reader.find<ErrorRegister>(2));
+    ASSERT_EQ(-1, reader.find(3, 0x6000, 2));
+
+    columnar::Column const& column = reader.getColumn(0);
+    ASSERT_EQ(COLUMN_INT16, column.type);
+    ASSERT_EQ(10, column.sampleCount);
+    ASSERT_EQ(3, column.blockCount);
+    int sample = 0;
+    for (size_t b = 0; b < column.blockCount; ++b) {
+        ColumnBlock block = reader.getBlock(0, b);
+        ASSERT_EQ(b < 2 ? 4 : 2, block.size);
+        int16_t const* values = block.as<int16_t>();
+        for (size_t i = 0; i < block.size; ++i, ++sample) {
+            ASSERT_EQ(toTimestamp(time + base::Time::fromMilliseconds(sample)),
+                      block.timestamps[i]);
+            ASSERT_EQ(-sample, values[i]);
+        }
+    }
+    ASSERT_EQ(9000u, reader.getBlock(1, 2).as<uint32_t>()[1]);
+    ASSERT_THROW(reader.getBlock(1, 0).as<int32_t>(), std::invalid_argument);
+    ASSERT_THROW(reader.getBlock(1, 3), std::out_of_range);
+    ASSERT_EQ(0, reader.getColumn(2).blockCount);
+}
+
+TEST_F(ColumnarExporterTest, files_are_readable_only_once_closed) {
+    ColumnarExporter exporter(path, 4);
+    exporter.add(machine, 0x6000, 1, COLUMN_INT16);
+    for (int i = 0; i < 10; ++i)
+        receivePDO(i);
+    exporter.flush();
+    ASSERT_THROW(ColumnarReader reader(path), std::runtime_error);
+
+    exporter.close();
+    // Not exported anymore
+    receivePDO(10);
+    ColumnarReader reader(path);
+    ASSERT_EQ(10, reader.getColumn(0).sampleCount);
+    ASSERT_THROW(exporter.add(machine, 0x6000, 2, COLUMN_UINT32), std::logic_error);
+}
+
+TEST_F(ColumnarExporterTest, it_counts_write_errors_instead_of_failing_the_processing) {
+    {
+        ColumnarExporter exporter(path, 4);
+        exporter.add(machine, 0x6000, 2, COLUMN_UINT32);
+        for (int i = 0; i < 4; ++i)
+            receivePDO(i);
+
+        // Let the next block be written only partially: header and first
+        // block are 16 + 48 bytes
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = 74;
+        auto previousHandler = signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &limited);
+        for (int i = 4; i < 8; ++i)
+            ASSERT_NO_THROW(receivePDO(i));
+        setrlimit(RLIMIT_FSIZE, &original);
+        signal(SIGXFSZ, previousHandler);
+
+        ASSERT_EQ(1, exporter.getWriteErrorCount());
+        ASSERT_EQ(4, exporter.getSampleCount(0));
+        for (int i = 8; i < 12; ++i)
+            receivePDO(i);
+    }
+
+    ColumnarReader reader(path);
+    columnar::Column const& column = reader.getColumn(0);
+    ASSERT_EQ(8, column.sampleCount);
+    ASSERT_EQ(2, column.blockCount);
+    ASSERT_EQ(3000u, reader.getBlock(0, 0).as<uint32_t>()[3]);
+    ASSERT_EQ(8000u, reader.getBlock(0, 1).as<uint32_t>()[0]);
+}
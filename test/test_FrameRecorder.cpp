@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <canopen_master/FrameRecorder.hpp>
+#include <canopen_master/FrameReaderThread.hpp>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+
+struct FrameRecorderTest : public ::testing::Test {
+    string path = "/tmp/canopen_master_test_" + to_string(getpid()) + ".rec";
+
+    ~FrameRecorderTest() {
+        unlink(path.c_str());
+    }
+
+    canbus::Message makeMessage(uint32_t can_id, uint8_t value) {
+        auto msg = canbus::Message::Zeroed();
+        msg.time = base::Time::fromMicroseconds(1000 + value);
+        msg.can_id = can_id;
+        msg.size = 2;
+        msg.data[0] = value;
+        msg.data[1] = ~value;
+        return msg;
+    }
+};
+
+TEST_F(FrameRecorderTest, it_keeps_the_last_frames_after_the_recorder_is_gone) {
+    {
+        FrameRecorder recorder(path, 4);
+        for (uint8_t i = 0; i < 6; ++i)
+            recorder.record(makeMessage(0x181, i), i == 5 ? FRAME_RECORD_TRANSMITTED : 0);
+        ASSERT_EQ(6, recorder.getRecordCount());
+    }
+
+    FrameRecordReader reader(path);
+    ASSERT_EQ(4, reader.getCapacity());
+    ASSERT_EQ(6, reader.getRecordCount());
+    ASSERT_EQ(4, reader.size());
+    for (uint8_t i = 0; i < 4; ++i) {
+        FrameRecord record = reader.get(i);
+        ASSERT_EQ(i + 3, record.sequence);
+        ASSERT_EQ(i == 3 ? FRAME_RECORD_TRANSMITTED : 0, record.flags);
+
+        canbus::Message msg = record.toMessage();
+        canbus::Message expected = makeMessage(0x181, i + 2);
+        ASSERT_EQ(expected.time, msg.time);
+        ASSERT_EQ(expected.can_id, msg.can_id);
+        ASSERT_EQ(expected.size, msg.size);
+        ASSERT_EQ(0, memcmp(expected.data, msg.data, 8));
+    }
+    ASSERT_THROW(reader.get(4), std::out_of_range);
+}
+
+TEST_F(FrameRecorderTest, it_rejects_files_that_are_not_recordings) {
+    ASSERT_THROW(FrameRecordReader reader(path), std::runtime_error);
+    ofstream(path) << string(256, 'x');
+    ASSERT_THROW(FrameRecordReader reader(path), std::runtime_error);
+    ASSERT_THROW(FrameRecorder recorder(path, 0), std::invalid_argument);
+    ASSERT_EQ(8000 * 60, FrameRecorder::getCapacityFor(base::Time::fromSeconds(60), 8000));
+}
+
+TEST_F(FrameRecorderTest, the_reader_thread_records_the_frames_it_queues) {
+    FrameRecorder recorder(path, 16);
+    FrameRing ring(16);
+    uint8_t value = 0;
+    FrameReaderThread thread([this, &value]() {
+        if (value == 10) {
+            this_thread::yield();
+            throw std::runtime_error("timeout");
+        }
+        return makeMessage(0x281, value++);
+    }, ring);
+    thread.setRecorder(&recorder);
+    thread.start();
+    canbus::Message msg;
+    for (int i = 0; i < 10; ++i) {
+        while (!ring.pop(msg))
+            this_thread::yield();
+    }
+    ASSERT_THROW(thread.setRecorder(nullptr), std::logic_error);
+    thread.stop();
+
+    FrameRecordReader reader(path);
+    ASSERT_EQ(10, reader.size());
+    ASSERT_EQ(9, reader.get(9).data[0]);
+}
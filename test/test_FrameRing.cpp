@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <canopen_master/FrameRing.hpp>
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/FrameReaderThread.hpp>
+#include <canopen_master/NMT.hpp>
+#include <sched.h>
+#include <thread>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+static canbus::Message makeMessage(uint32_t can_id, uint32_t seq = 0)
+{
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = can_id;
+    msg.size = 4;
+    msg.time = base::Time::fromSeconds(1000);
+    msg.data[0] = seq;
+    msg.data[1] = seq >> 8;
+    msg.data[2] = seq >> 16;
+    msg.data[3] = seq >> 24;
+    return msg;
+}
+
+static uint32_t getSeq(canbus::Message const& msg)
+{
+    return msg.data[0] | msg.data[1] << 8 | msg.data[2] << 16 |
+        static_cast<uint32_t>(msg.data[3]) << 24;
+}
+
+TEST(FrameRing, it_rounds_the_capacity_up_to_a_power_of_two) {
+    ASSERT_EQ(8, FrameRing(5).getCapacity());
+    ASSERT_EQ(8, FrameRing(8).getCapacity());
+    ASSERT_THROW(FrameRing(0), std::invalid_argument);
+}
+
+TEST(FrameRing, it_returns_the_frames_in_order) {
+    FrameRing ring(4);
+    ASSERT_TRUE(ring.empty());
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(ring.push(makeMessage(0x181, i)));
+    ASSERT_EQ(3, ring.size());
+
+    canbus::Message msg;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(ring.pop(msg));
+        ASSERT_EQ(i, getSeq(msg));
+    }
+    ASSERT_FALSE(ring.pop(msg));
+}
+
+TEST(FrameRing, it_drops_and_counts_frames_when_full) {
+    FrameRing ring(4);
+    for (int i = 0; i < 6; ++i)
+        ring.push(makeMessage(0x181, i));
+    ASSERT_EQ(4, ring.size());
+    ASSERT_EQ(4, ring.getPushCount());
+    ASSERT_EQ(2, ring.getOverflowCount());
+
+    canbus::Message messages[8];
+    ASSERT_EQ(4, ring.pop(messages, 8));
+    ASSERT_EQ(3, getSeq(messages[3]));
+}
+
+TEST(FrameRing, it_pops_in_batches_across_the_end_of_the_buffer) {
+    FrameRing ring(4);
+    canbus::Message messages[4];
+    uint32_t seq = 0;
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 3; ++i)
+            ring.push(makeMessage(0x181, seq + i));
+        ASSERT_EQ(2, ring.pop(messages, 2));
+        ASSERT_EQ(1, ring.pop(messages + 2, 4));
+        for (int i = 0; i < 3; ++i)
+            ASSERT_EQ(seq++, getSeq(messages[i]));
+    }
+}
+
+TEST(FrameRing, it_hands_frames_over_between_two_threads) {
+    const uint32_t count = 100000;
+    FrameRing ring(256);
+    thread producer([&ring, count]() {
+        for (uint32_t i = 0; i < count; ) {
+            if (ring.push(makeMessage(0x181, i)))
+                ++i;
+            else
+                this_thread::yield();
+        }
+    });
+
+    canbus::Message messages[32];
+    uint32_t expected = 0;
+    while (expected < count) {
+        size_t n = ring.pop(messages, 32);
+        if (n == 0)
+            this_thread::yield();
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_EQ(expected++, getSeq(messages[i]));
+    }
+    producer.join();
+    ASSERT_EQ(count, ring.getPushCount());
+}
+
+TEST(Dispatcher, it_routes_frames_to_the_state_machine_of_their_node) {
+    StateMachine node1(1), node2(2);
+    Dispatcher dispatcher;
+    dispatcher.add(node1);
+    dispatcher.add(node2);
+    ASSERT_EQ(2, dispatcher.getNodeCount());
+    ASSERT_THROW(dispatcher.add(node1), std::invalid_argument);
+
+    auto heartbeat = makeMessage(0x702);
+    heartbeat.size = 1;
+    heartbeat.data[0] = NODE_OPERATIONAL;
+    ASSERT_EQ(StateMachine::PROCESSED_HEARTBEAT, dispatcher.process(heartbeat).mode);
+    ASSERT_EQ(NODE_OPERATIONAL, node2.getState());
+    ASSERT_FALSE(node1.hasState());
+
+    ASSERT_EQ(StateMachine::PROCESSED_NOT_FOR_ME,
+              dispatcher.process(makeMessage(0x703)).mode);
+    ASSERT_EQ(StateMachine::PROCESSED_IGNORED_MESSAGE,
+              dispatcher.process(makeMessage(0x080)).mode);
+
+    dispatcher.remove(2);
+    ASSERT_EQ(nullptr, dispatcher.get(2));
+    ASSERT_EQ(StateMachine::PROCESSED_NOT_FOR_ME, dispatcher.process(heartbeat).mode);
+}
+
+TEST(Dispatcher, it_resumes_a_batch_after_an_exception) {
+    StateMachine node1(1);
+    Dispatcher dispatcher;
+    dispatcher.add(node1);
+
+    FrameRing ring(8);
+    auto emergency = makeMessage(0x081);
+    emergency.data[0] = 0x10;
+    emergency.data[1] = 0x23;
+    ring.push(emergency);
+    ring.push(makeMessage(0x701));
+
+    int count = 0;
+    auto handler = [&count](canbus::Message const&, Update const&) { ++count; };
+    ASSERT_THROW(dispatcher.process(ring, handler), EmergencyMessageReceived);
+    ASSERT_EQ(1, dispatcher.process(ring, handler));
+    ASSERT_EQ(1, count);
+    ASSERT_EQ(0, dispatcher.process(ring, handler));
+}
+
+TEST(FrameReaderThread, it_feeds_the_ring_from_its_own_thread) {
+    FrameRing ring(1024);
+    uint32_t calls = 0, seq = 0;
+    FrameReaderThread reader([&calls, &seq]() {
+        if (calls++ % 2)
+            throw std::runtime_error("timeout");
+        return makeMessage(0x181, seq++);
+    }, ring);
+    reader.start();
+
+    canbus::Message msg;
+    for (uint32_t i = 0; i < 100; ++i) {
+        while (!ring.pop(msg))
+            this_thread::yield();
+        ASSERT_EQ(i, getSeq(msg));
+    }
+    reader.stop();
+    ASSERT_FALSE(reader.isRunning());
+    ASSERT_GT(reader.getReadErrorCount(), 0);
+}
+
+TEST(FrameReaderThread, it_rejects_CPUs_out_of_the_affinity_mask) {
+    FrameRing ring(16);
+    FrameReaderThread reader([]() -> canbus::Message {
+        throw std::runtime_error("timeout");
+    }, ring);
+    ASSERT_THROW(reader.start(CPU_SETSIZE), std::invalid_argument);
+    ASSERT_FALSE(reader.isRunning());
+}
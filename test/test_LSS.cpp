@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <canopen_master/LSS.hpp>
+#include <canopen_master/Exceptions.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+/** Minimal CiA 305 LSS slave, enough to exercise the master side */
+struct FakeLSSSlave {
+    LSSAddress address;
+    uint8_t nodeId = LSS_UNCONFIGURED_NODE_ID;
+    uint8_t pendingNodeId = LSS_UNCONFIGURED_NODE_ID;
+    LSS_MODE mode = LSS_WAITING;
+    int lssPos = -1;
+
+    FakeLSSSlave(uint32_t vendor, uint32_t product, uint32_t revision, uint32_t serial)
+        : address({ { vendor, product, revision, serial } }) {
+    }
+
+    bool reply(uint8_t command, canbus::Message& reply) {
+        reply = canbus::Message::Zeroed();
+        reply.can_id = LSS_SLAVE_TO_MASTER;
+        reply.size = 8;
+        reply.data[0] = command;
+        return true;
+    }
+
+    bool process(canbus::Message const& msg, canbus::Message& out) {
+        switch (msg.data[0]) {
+            case LSS_SWITCH_STATE_GLOBAL:
+                mode = static_cast<LSS_MODE>(msg.data[1]);
+                // Real slaves apply the pending node ID on the next NMT
+                // reset communication, apply it right away instead
+                if (mode == LSS_WAITING && pendingNodeId != LSS_UNCONFIGURED_NODE_ID)
+                    nodeId = pendingNodeId;
+                return false;
+            case LSS_CONFIGURE_NODE_ID:
+                if (mode != LSS_CONFIGURATION)
+                    return false;
+                pendingNodeId = msg.data[1];
+                return reply(LSS_CONFIGURE_NODE_ID, out);
+            case LSS_FASTSCAN:
+                return processFastscan(msg, out);
+            default:
+                return false;
+        }
+    }
+
+    bool processFastscan(canbus::Message const& msg, canbus::Message& out) {
+        if (mode != LSS_WAITING || nodeId != LSS_UNCONFIGURED_NODE_ID)
+            return false;
+
+        uint32_t idNumber = fromLittleEndian<uint32_t>(msg.data + 1);
+        uint8_t bitChecked = msg.data[5];
+        uint8_t lssSub = msg.data[6];
+        uint8_t lssNext = msg.data[7];
+        if (bitChecked == 0x80) {
+            lssPos = 0;
+            return reply(LSS_IDENTIFY_SLAVE, out);
+        }
+        if (lssPos != lssSub)
+            return false;
+        if ((address.id[lssSub] ^ idNumber) >> bitChecked)
+            return false;
+
+        if (bitChecked == 0) {
+            if (lssNext < lssPos)
+                mode = LSS_CONFIGURATION;
+            lssPos = lssNext;
+        }
+        return reply(LSS_IDENTIFY_SLAVE, out);
+    }
+};
+
+/** Bus on which the master sends one query and waits for replies */
+struct LSSBus {
+    vector<FakeLSSSlave> slaves;
+    size_t frames = 0;
+
+    /** Send a query, and return whether at least one slave replied */
+    bool query(canbus::Message const& msg, canbus::Message& reply) {
+        ++frames;
+        bool replied = false;
+        for (auto& slave : slaves) {
+            canbus::Message r;
+            if (slave.process(msg, r)) {
+                reply = r;
+                replied = true;
+            }
+        }
+        return replied;
+    }
+
+    LSSFastscan scan() {
+        LSSFastscan scan;
+        while (!scan.isFinished()) {
+            canbus::Message reply;
+            if (query(scan.getQuery(), reply) && LSSFastscan::isReply(reply))
+                scan.processReply();
+            else
+                scan.processTimeout();
+        }
+        return scan;
+    }
+};
+
+TEST(LSS, it_creates_a_configure_node_id_message) {
+    auto msg = makeLSSConfigureNodeID(10);
+    ASSERT_EQ(0x7E5, msg.can_id);
+    ASSERT_EQ(8, msg.size);
+    ASSERT_EQ(0x11, msg.data[0]);
+    ASSERT_EQ(10, msg.data[1]);
+}
+
+TEST(LSS, it_rejects_invalid_node_ids) {
+    ASSERT_THROW(makeLSSConfigureNodeID(0), std::invalid_argument);
+    ASSERT_THROW(makeLSSConfigureNodeID(128), std::invalid_argument);
+}
+
+TEST(LSS, it_creates_the_switch_state_selective_sequence) {
+    LSSAddress address = { { 1, 2, 3, 4 } };
+    auto messages = makeLSSSwitchStateSelective(address);
+    ASSERT_EQ(4, messages.size());
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(0x40 + i, messages[i].data[0]);
+        ASSERT_EQ(i + 1, fromLittleEndian<uint32_t>(messages[i].data + 1));
+    }
+}
+
+TEST(LSS, it_throws_on_configuration_errors) {
+    canbus::Message msg;
+    msg.can_id = LSS_SLAVE_TO_MASTER;
+    msg.size = 8;
+    msg.data[0] = LSS_CONFIGURE_NODE_ID;
+    msg.data[1] = 1;
+    ASSERT_THROW(parseLSSConfigurationReply(msg), LSSError);
+    msg.data[1] = 0;
+    parseLSSConfigurationReply(msg);
+}
+
+TEST(LSS, it_parses_inquire_replies) {
+    canbus::Message msg;
+    msg.can_id = LSS_SLAVE_TO_MASTER;
+    msg.data[0] = LSS_INQUIRE_SERIAL;
+    toLittleEndian<uint32_t>(msg.data + 1, 0x12345678);
+    ASSERT_EQ(0x12345678, parseLSSInquireReply(msg));
+}
+
+TEST(LSSFastscan, it_finishes_immediately_if_there_are_no_unconfigured_slaves) {
+    LSSBus bus;
+    auto scan = bus.scan();
+    ASSERT_FALSE(scan.hasFoundSlave());
+    ASSERT_EQ(1, bus.frames);
+}
+
+TEST(LSSFastscan, it_finds_the_address_of_an_unconfigured_slave) {
+    LSSBus bus;
+    bus.slaves.push_back(FakeLSSSlave(0x1234, 0xFFFFFFFF, 0, 0x80000001));
+    auto scan = bus.scan();
+    ASSERT_TRUE(scan.hasFoundSlave());
+    ASSERT_EQ(bus.slaves[0].address, scan.getAddress());
+    ASSERT_EQ(LSS_CONFIGURATION, bus.slaves[0].mode);
+    ASSERT_EQ(1 + 4 * 33, bus.frames);
+    ASSERT_EQ(bus.frames, scan.getQueryCount());
+}
+
+TEST(LSSFastscan, it_assigns_node_ids_to_a_line_of_unconfigured_slaves) {
+    LSSBus bus;
+    bus.slaves.push_back(FakeLSSSlave(0x1234, 1, 1, 100));
+    bus.slaves.push_back(FakeLSSSlave(0x1234, 1, 1, 101));
+    bus.slaves.push_back(FakeLSSSlave(0x1234, 1, 2, 5));
+    bus.slaves.push_back(FakeLSSSlave(0x1234, 1, 1, 100));
+    bus.slaves.back().nodeId = 3; // already configured
+
+    uint8_t nodeId = 10;
+    while (true) {
+        auto scan = bus.scan();
+        if (!scan.hasFoundSlave())
+            break;
+
+        canbus::Message reply;
+        ASSERT_TRUE(bus.query(makeLSSConfigureNodeID(nodeId++), reply));
+        parseLSSConfigurationReply(reply);
+        bus.query(makeLSSSwitchStateGlobal(LSS_WAITING), reply);
+    }
+
+    ASSERT_EQ(13, nodeId);
+    // The fastscan finds the lowest addresses first
+    ASSERT_EQ(10, bus.slaves[0].nodeId);
+    ASSERT_EQ(11, bus.slaves[1].nodeId);
+    ASSERT_EQ(12, bus.slaves[2].nodeId);
+    ASSERT_EQ(3, bus.slaves[3].nodeId);
+}
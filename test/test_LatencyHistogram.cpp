@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <canopen_master/LatencyHistogram.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+TEST(LatencyHistogram, its_buckets_cover_the_range_without_gaps) {
+    ASSERT_EQ(0, LatencyHistogram::getBucketIndex(0));
+    ASSERT_EQ(31, LatencyHistogram::getBucketIndex(31));
+    ASSERT_EQ(LatencyHistogram::BUCKET_COUNT - 1,
+              LatencyHistogram::getBucketIndex(uint64_t(1) << 40));
+
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        uint64_t lower = LatencyHistogram::getBucketLowerBound(i);
+        uint64_t upper = LatencyHistogram::getBucketUpperBound(i);
+        ASSERT_EQ(i, LatencyHistogram::getBucketIndex(lower));
+        ASSERT_EQ(i, LatencyHistogram::getBucketIndex(upper));
+        ASSERT_LE(upper - lower, lower / 32);
+        if (i > 0) {
+            ASSERT_EQ(LatencyHistogram::getBucketUpperBound(i - 1) + 1, lower);
+        }
+    }
+}
+
+TEST(LatencyHistogram, it_computes_statistics_within_the_bucket_precision) {
+    LatencyHistogram histogram;
+    ASSERT_TRUE(histogram.getPercentile(0.5).isNull());
+    for (int i = 1; i <= 1000; ++i)
+        histogram.record(base::Time::fromMicroseconds(i * 10));
+    histogram.record(base::Time::fromMicroseconds(-5));
+
+    ASSERT_EQ(1001, histogram.getCount());
+    ASSERT_EQ(base::Time(), histogram.getMin());
+    ASSERT_EQ(base::Time::fromMicroseconds(10000), histogram.getMax());
+    ASSERT_NEAR(5000, histogram.getPercentile(0.5).toMicroseconds(), 5000 / 32);
+    ASSERT_NEAR(9900, histogram.getPercentile(0.99).toMicroseconds(), 9900 / 32);
+    ASSERT_EQ(base::Time::fromMicroseconds(10000), histogram.getPercentile(1));
+
+    LatencyHistogram copy(histogram);
+    ASSERT_EQ(1001, copy.getCount());
+    ASSERT_EQ(histogram.getPercentile(0.5), copy.getPercentile(0.5));
+}
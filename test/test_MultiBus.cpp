@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <canopen_master/MultiBus.hpp>
+#include <canopen_master/SyncProducer.hpp>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+/** Fake CAN interface, fed by the test */
+struct FakeInterface {
+    mutex lock;
+    deque<canbus::Message> received;
+    vector<canbus::Message> sent;
+
+    void receive(canbus::Message const& msg) {
+        lock_guard<mutex> guard(lock);
+        received.push_back(msg);
+    }
+
+    canbus::Message read() {
+        {
+            lock_guard<mutex> guard(lock);
+            if (!received.empty()) {
+                canbus::Message msg = received.front();
+                received.pop_front();
+                return msg;
+            }
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+        throw std::runtime_error("timeout");
+    }
+
+    void write(canbus::Message const& msg) {
+        lock_guard<mutex> guard(lock);
+        sent.push_back(msg);
+    }
+
+    size_t getSentCount() {
+        lock_guard<mutex> guard(lock);
+        return sent.size();
+    }
+};
+
+struct MultiBusTest : public ::testing::Test {
+    MultiBus multiBus;
+    FakeInterface interfaces[2];
+
+    MultiBusTest() {
+        for (auto& interface : interfaces) {
+            FakeInterface* i = &interface;
+            multiBus.addBus([i]() { return i->read(); },
+                            [i](canbus::Message const& msg) { i->write(msg); });
+        }
+    }
+
+    canbus::Message makeHeartbeat(uint8_t nodeId) {
+        auto msg = canbus::Message::Zeroed();
+        msg.can_id = 0x700 + nodeId;
+        msg.size = 1;
+        msg.time = base::Time::now();
+        msg.data[0] = NODE_OPERATIONAL;
+        return msg;
+    }
+
+    template<typename F>
+    void waitFor(F condition) {
+        for (int i = 0; i < 1000 && !condition(); ++i)
+            this_thread::sleep_for(chrono::milliseconds(1));
+        ASSERT_TRUE(condition());
+    }
+};
+
+TEST(NodeAddress, it_orders_by_bus_then_node) {
+    ASSERT_TRUE(NodeAddress(0, 5) < NodeAddress(1, 1));
+    ASSERT_TRUE(NodeAddress(1, 1) < NodeAddress(1, 2));
+    ASSERT_EQ(NodeAddress(1, 2), NodeAddress(1, 2));
+    ASSERT_NE(NodeAddress(0, 2), NodeAddress(1, 2));
+}
+
+TEST_F(MultiBusTest, it_addresses_nodes_by_bus_and_node_ID) {
+    StateMachine a(1), b(1);
+    ASSERT_EQ(NodeAddress(0, 1), multiBus.add(0, a));
+    ASSERT_EQ(NodeAddress(1, 1), multiBus.add(1, b));
+    ASSERT_EQ(&a, multiBus.get(NodeAddress(0, 1)));
+    ASSERT_EQ(&b, multiBus.get(NodeAddress(1, 1)));
+    ASSERT_EQ(nullptr, multiBus.get(NodeAddress(2, 1)));
+    ASSERT_THROW(multiBus.add(2, a), std::invalid_argument);
+}
+
+TEST_F(MultiBusTest, it_allocates_the_buses_on_cache_line_boundaries) {
+    for (uint8_t i = 0; i < multiBus.getBusCount(); ++i) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(&multiBus.getBus(i));
+        ASSERT_EQ(0, address % alignof(MultiBus::Bus));
+    }
+}
+
+TEST_F(MultiBusTest, it_processes_the_frames_of_each_bus_on_its_own_worker) {
+    StateMachine a(1), b(1);
+    multiBus.add(0, a);
+    multiBus.add(1, b);
+
+    mutex lock;
+    vector<pair<NodeAddress, thread::id>> processed;
+    multiBus.setHandler([&](NodeAddress const& address, canbus::Message const&,
+                            Update const& update) {
+        ASSERT_EQ(StateMachine::PROCESSED_HEARTBEAT, update.mode);
+        lock_guard<mutex> guard(lock);
+        processed.push_back(make_pair(address, this_thread::get_id()));
+    });
+    multiBus.start();
+    ASSERT_THROW(multiBus.add(0, a), std::logic_error);
+
+    interfaces[1].receive(makeHeartbeat(1));
+    waitFor([&]() { return multiBus.getBus(1).getProcessedCount() == 1; });
+    interfaces[0].receive(makeHeartbeat(1));
+    waitFor([&]() { return multiBus.getBus(0).getProcessedCount() == 1; });
+    multiBus.stop();
+
+    ASSERT_EQ(2, processed.size());
+    ASSERT_EQ(NodeAddress(1, 1), processed[0].first);
+    ASSERT_EQ(NodeAddress(0, 1), processed[1].first);
+    ASSERT_NE(processed[0].second, processed[1].second);
+    ASSERT_EQ(NODE_OPERATIONAL, a.getState());
+    ASSERT_EQ(NODE_OPERATIONAL, b.getState());
+}
+
+TEST_F(MultiBusTest, it_counts_processing_errors_and_keeps_going) {
+    StateMachine a(1);
+    multiBus.add(0, a);
+    multiBus.start();
+
+    auto emergency = makeHeartbeat(1);
+    emergency.can_id = 0x81;
+    emergency.size = 8;
+    emergency.data[0] = 0x10;
+    emergency.data[1] = 0x23;
+    interfaces[0].receive(emergency);
+    interfaces[0].receive(makeHeartbeat(1));
+    waitFor([&]() { return multiBus.getBus(0).getProcessedCount() == 1; });
+    ASSERT_EQ(1, multiBus.getBus(0).getErrorCount());
+}
+
+TEST_F(MultiBusTest, it_runs_periodic_tasks_on_their_bus) {
+    multiBus.schedule(1, base::Time::fromMilliseconds(2),
+        [](MultiBus::Bus& bus, base::Time const& time) {
+            bus.write(makeSyncMessage(0, time));
+        });
+    multiBus.start();
+    waitFor([&]() { return interfaces[1].getSentCount() >= 5; });
+    multiBus.stop();
+    ASSERT_EQ(0, interfaces[0].getSentCount());
+    ASSERT_EQ(0x80, interfaces[1].sent[0].can_id);
+}
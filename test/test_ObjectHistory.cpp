@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <canopen_master/ObjectHistory.hpp>
+#include <thread>
+
+using namespace std;
+using namespace canopen_master;
+
+static void push(ObjectHistory& history, uint32_t value)
+{
+    uint8_t data[4];
+    toLittleEndian(data, value);
+    history.push(value, data, 4);
+}
+
+TEST(ObjectHistory, it_returns_the_most_recent_samples_oldest_first) {
+    ObjectHistory history(3);
+    ObjectSample samples[4];
+    ASSERT_EQ(0, history.read(samples, 4));
+
+    push(history, 1);
+    push(history, 2);
+    ASSERT_EQ(2, history.read(samples, 4));
+    ASSERT_EQ(1, samples[0].as<uint32_t>());
+    ASSERT_EQ(2, samples[1].timestamp);
+
+    push(history, 3);
+    push(history, 4);
+    ASSERT_EQ(3, history.read(samples, 4));
+    ASSERT_EQ(2, samples[0].as<uint32_t>());
+    ASSERT_EQ(4, samples[2].as<uint32_t>());
+    ASSERT_EQ(4, history.getCount());
+    ASSERT_THROW(ObjectHistory(0), std::invalid_argument);
+}
+
+TEST(ObjectHistory, concurrent_readers_only_get_consistent_samples) {
+    ObjectHistory history(8);
+    atomic<bool> done(false);
+    bool consistent = true;
+    uint64_t reads = 0;
+    std::thread reader([&]() {
+        ObjectSample samples[8];
+        while (!done) {
+            size_t count = history.read(samples, 8);
+            for (size_t i = 0; i < count; ++i) {
+                // The value matches the timestamp, and samples are consecutive
+                if (samples[i].as<uint32_t>() != samples[i].timestamp ||
+                    (i > 0 && samples[i].timestamp != samples[i - 1].timestamp + 1)) {
+                    consistent = false;
+                }
+            }
+            ++reads;
+            this_thread::yield();
+        }
+    });
+
+    for (uint32_t i = 0; i < 200000; ++i) {
+        push(history, i);
+        if (i % 64 == 0)
+            this_thread::yield();
+    }
+    done = true;
+    reader.join();
+    ASSERT_TRUE(consistent);
+    ASSERT_GT(reads, 0);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <canopen_master/PDOPlanner.hpp>
+#include <canopen_master/StateMachine.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/Objects.hpp>
+
+using namespace base;
+using namespace canopen_master;
+
+struct PDOPlannerTest : public ::testing::Test {
+    PDOPlanner planner;
+};
+
+CANOPEN_DEFINE_OBJECT(0x6000, 1, Fast16_1, uint16_t);
+CANOPEN_DEFINE_OBJECT(0x6000, 2, Fast16_2, uint16_t);
+CANOPEN_DEFINE_OBJECT(0x6000, 3, Fast32, uint32_t);
+CANOPEN_DEFINE_OBJECT(0x6100, 1, Slow32_1, uint32_t);
+CANOPEN_DEFINE_OBJECT(0x6100, 2, Slow32_2, uint32_t);
+CANOPEN_DEFINE_OBJECT(0x6200, 0, Command, uint32_t);
+
+TEST_F(PDOPlannerTest, it_packs_objects_of_the_same_period_in_a_single_PDO) {
+    planner.addTPDO<Fast16_1>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast16_2>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+
+    auto plan = planner.plan();
+    ASSERT_EQ(1, plan.pdos.size());
+    ASSERT_TRUE(plan.pdos[0].transmit);
+    ASSERT_EQ(0, plan.pdos[0].pdoIndex);
+    ASSERT_EQ(3, plan.pdos[0].mapping.mappings.size());
+    ASSERT_EQ(8, plan.pdos[0].mapping.currentSize);
+    ASSERT_DOUBLE_EQ(100, plan.getFramesPerSecond());
+}
+
+TEST_F(PDOPlannerTest, it_fills_the_room_left_in_faster_PDOs_with_slower_objects) {
+    planner.addTPDO<Slow32_1>(Time::fromMilliseconds(100));
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+
+    auto plan = planner.plan();
+    ASSERT_EQ(1, plan.pdos.size());
+    ASSERT_EQ(Time::fromMilliseconds(10), plan.pdos[0].period);
+    ASSERT_EQ(0x6000, plan.pdos[0].mapping.mappings[0].objectId);
+    ASSERT_EQ(0x6100, plan.pdos[0].mapping.mappings[1].objectId);
+}
+
+TEST_F(PDOPlannerTest, it_opens_a_new_PDO_at_the_slower_rate_when_the_faster_ones_are_full) {
+    planner.addTPDO<Fast16_1>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast16_2>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+    planner.addTPDO<Slow32_1>(Time::fromMilliseconds(100));
+    planner.addTPDO<Slow32_2>(Time::fromMilliseconds(100));
+
+    auto plan = planner.plan();
+    ASSERT_EQ(2, plan.pdos.size());
+    ASSERT_EQ(1, plan.pdos[1].pdoIndex);
+    ASSERT_EQ(Time::fromMilliseconds(100), plan.pdos[1].period);
+    ASSERT_EQ(PDO_ASYNCHRONOUS, plan.pdos[1].parameters.transmission_mode);
+    ASSERT_EQ(Time::fromMilliseconds(100), plan.pdos[1].parameters.timer_period);
+    ASSERT_DOUBLE_EQ(110, plan.getFramesPerSecond());
+}
+
+TEST_F(PDOPlannerTest, it_allocates_RPDOs_separately) {
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+    planner.addRPDO<Command>(Time::fromMilliseconds(10));
+
+    auto plan = planner.plan();
+    ASSERT_EQ(2, plan.pdos.size());
+    ASSERT_FALSE(plan.pdos[1].transmit);
+    ASSERT_EQ(0, plan.pdos[1].pdoIndex);
+    ASSERT_EQ(PDO_ASYNCHRONOUS, plan.pdos[1].parameters.transmission_mode);
+}
+
+TEST_F(PDOPlannerTest, it_plans_synchronous_PDOs_as_multiples_of_the_sync_period) {
+    planner.setSyncPeriod(Time::fromMilliseconds(1));
+    planner.addTPDO<Fast32>(Time::fromMicroseconds(2500));
+
+    auto plan = planner.plan();
+    ASSERT_EQ(PDO_SYNCHRONOUS, plan.pdos[0].parameters.transmission_mode);
+    ASSERT_EQ(2, plan.pdos[0].parameters.sync_period);
+    ASSERT_EQ(Time::fromMilliseconds(2), plan.pdos[0].period);
+}
+
+TEST_F(PDOPlannerTest, it_rejects_periods_faster_than_the_sync) {
+    planner.setSyncPeriod(Time::fromMilliseconds(1));
+    planner.addTPDO<Fast32>(Time::fromMicroseconds(500));
+    ASSERT_THROW(planner.plan(), PDOPlanningFailed);
+}
+
+TEST_F(PDOPlannerTest, it_throws_if_the_objects_do_not_fit_in_the_device_PDOs) {
+    PDOLimits limits;
+    limits.maxTPDO = 1;
+    PDOPlanner planner(limits);
+    planner.addTPDO<Slow32_1>(Time::fromMilliseconds(100));
+    planner.addTPDO<Slow32_2>(Time::fromMilliseconds(100));
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(100));
+    ASSERT_THROW(planner.plan(), PDOPlanningFailed);
+}
+
+TEST_F(PDOPlannerTest, it_honors_the_maximum_number_of_mapped_objects) {
+    PDOLimits limits;
+    limits.maxMappedObjects = 1;
+    PDOPlanner planner(limits);
+    planner.addTPDO<Fast16_1>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast16_2>(Time::fromMilliseconds(10));
+    ASSERT_EQ(2, planner.plan().pdos.size());
+}
+
+TEST_F(PDOPlannerTest, it_configures_the_planned_PDOs_and_disables_the_unused_ones) {
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+    auto plan = planner.plan();
+
+    StateMachine machine(2);
+    auto messages = plan.configure(machine);
+    auto expected = machine.configurePDO(
+        true, 0, plan.pdos[0].parameters, plan.pdos[0].mapping);
+    ASSERT_EQ(expected.size() + 7, messages.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i].can_id, messages[i].can_id);
+        ASSERT_EQ(0, memcmp(expected[i].data, messages[i].data, 8));
+    }
+    auto disable = machine.disablePDO(true, 1);
+    ASSERT_EQ(0, memcmp(disable.data, messages[expected.size()].data, 8));
+}
+
+TEST_F(PDOPlannerTest, it_declares_the_planned_TPDOs_on_the_state_machine) {
+    planner.addTPDO<Fast16_1>(Time::fromMilliseconds(10));
+    planner.addTPDO<Fast32>(Time::fromMilliseconds(10));
+    auto plan = planner.plan();
+
+    StateMachine machine(2);
+    plan.declare(machine);
+
+    canbus::Message msg;
+    msg.time = Time::now();
+    msg.can_id = FUNCTION_PDO0_TRANSMIT + 2;
+    msg.size = 6;
+    uint8_t data[] = { 0x78, 0x56, 0x34, 0x12, 0x02, 0x01 };
+    memcpy(msg.data, data, 6);
+    machine.process(msg);
+    ASSERT_EQ(0x12345678, machine.get<uint32_t>(0x6000, 3));
+    ASSERT_EQ(0x0102, machine.get<uint16_t>(0x6000, 1));
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <canopen_master/ProtocolCounters.hpp>
+#include <canopen_master/ShardedDispatcher.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+static canbus::Message makeMessage(uint32_t canId, uint8_t size, uint8_t data0 = 0)
+{
+    canbus::Message msg;
+    msg.time = base::Time::fromSeconds(1);
+    msg.can_id = canId;
+    msg.size = size;
+    fill(msg.data, msg.data + 8, 0);
+    msg.data[0] = data0;
+    return msg;
+}
+
+TEST(ProtocolCounters, it_counts_the_events_of_each_node) {
+    ProtocolCounters counters;
+    StateMachine node2(2), node3(3);
+    node2.setProtocolCounters(&counters);
+    node3.setProtocolCounters(&counters);
+    ASSERT_EQ(&counters, node2.getProtocolCounters());
+
+    node2.process(makeMessage(0x702, 1, NODE_OPERATIONAL));
+    node2.process(makeMessage(0x702, 1, NODE_OPERATIONAL));
+    // Not for this node, counted by node3 only
+    node2.process(makeMessage(0x703, 1, NODE_OPERATIONAL));
+    node3.process(makeMessage(0x703, 1, NODE_OPERATIONAL));
+    // TPDO without mapping
+    node3.process(makeMessage(0x183, 8));
+    // SDO abort and a SDO command the state machine does not handle
+    ASSERT_THROW(node3.process(makeMessage(0x583, 8, 0x80)), SDODomainTransferAborted);
+    node3.process(makeMessage(0x583, 8, 0x20));
+    canbus::Message emcy = makeMessage(0x083, 8, 0x10);
+    emcy.data[1] = 0x10;
+    ASSERT_THROW(node3.process(emcy), EmergencyMessageReceived);
+
+    NodeProtocolCounters c2 = counters.get(2);
+    ASSERT_EQ(2, c2[COUNTER_FRAMES]);
+    ASSERT_EQ(2, c2[COUNTER_BYTES]);
+    ASSERT_EQ(2, c2[COUNTER_HEARTBEATS]);
+    ASSERT_EQ(0, c2[COUNTER_UNEXPECTED_PDOS]);
+
+    NodeProtocolCounters c3 = counters.get(3);
+    ASSERT_EQ(5, c3[COUNTER_FRAMES]);
+    ASSERT_EQ(33, c3[COUNTER_BYTES]);
+    ASSERT_EQ(1, c3[COUNTER_HEARTBEATS]);
+    ASSERT_EQ(1, c3[COUNTER_UNEXPECTED_PDOS]);
+    ASSERT_EQ(1, c3[COUNTER_SDO_ABORTS]);
+    ASSERT_EQ(1, c3[COUNTER_IGNORED_SDOS]);
+    ASSERT_EQ(1, c3[COUNTER_EMERGENCIES]);
+
+    ProtocolCountersSnapshot snapshot = counters.snapshot();
+    ASSERT_EQ(7, snapshot.getTotal(COUNTER_FRAMES));
+    ASSERT_EQ(3, snapshot.getTotal(COUNTER_HEARTBEATS));
+    ASSERT_EQ(0, snapshot.nodes[4][COUNTER_FRAMES]);
+}
+
+TEST(ProtocolCounters, it_stops_counting_once_the_counters_are_unset) {
+    ProtocolCounters counters;
+    StateMachine machine(2);
+    machine.setProtocolCounters(&counters);
+    machine.process(makeMessage(0x702, 1, NODE_OPERATIONAL));
+    machine.setProtocolCounters(nullptr);
+    machine.process(makeMessage(0x702, 1, NODE_OPERATIONAL));
+    ASSERT_EQ(1, counters.get(2, COUNTER_FRAMES));
+    ASSERT_THROW(counters.get(128), std::invalid_argument);
+}
+
+TEST(ProtocolCounters, it_counts_the_frames_of_unregistered_nodes) {
+    ProtocolCounters counters;
+    StateMachine node2(2);
+    Dispatcher dispatcher;
+    dispatcher.add(node2);
+    dispatcher.setProtocolCounters(&counters);
+    dispatcher.process(makeMessage(0x702, 1, NODE_OPERATIONAL));
+    dispatcher.process(makeMessage(0x703, 1, NODE_OPERATIONAL));
+    dispatcher.process(makeMessage(0x183, 8));
+    // Broadcasts are not from a node
+    dispatcher.process(makeMessage(0x080, 0));
+
+    ShardedDispatcher sharded(2);
+    StateMachine node4(4);
+    sharded.add(node4);
+    sharded.setProtocolCounters(&counters);
+    sharded.route(makeMessage(0x704, 1, NODE_OPERATIONAL));
+    sharded.route(makeMessage(0x705, 1, NODE_OPERATIONAL));
+
+    ASSERT_EQ(0, counters.get(2, COUNTER_UNREGISTERED_FRAMES));
+    ASSERT_EQ(2, counters.get(3, COUNTER_UNREGISTERED_FRAMES));
+    ASSERT_EQ(0, counters.get(4, COUNTER_UNREGISTERED_FRAMES));
+    ASSERT_EQ(1, counters.get(5, COUNTER_UNREGISTERED_FRAMES));
+    ASSERT_EQ(0, counters.snapshot().getTotal(COUNTER_FRAMES));
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <canopen_master/Reactor.hpp>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+struct ReactorTest : public ::testing::Test {
+    Reactor reactor;
+    int pipeFDs[2];
+
+    ReactorTest() {
+        if (pipe(pipeFDs) == -1)
+            throw std::runtime_error("failed to create pipe");
+    }
+    ~ReactorTest() {
+        close(pipeFDs[0]);
+        close(pipeFDs[1]);
+    }
+
+    void writeMessage(canbus::Message const& msg) {
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(msg)), write(pipeFDs[1], &msg, sizeof(msg)));
+    }
+    canbus::Message readMessage() {
+        canbus::Message msg;
+        if (read(pipeFDs[0], &msg, sizeof(msg)) != sizeof(msg))
+            throw std::runtime_error("failed to read message");
+        return msg;
+    }
+};
+
+TEST_F(ReactorTest, it_calls_the_callback_of_readable_descriptors) {
+    int calls = 0;
+    reactor.watch(pipeFDs[0], [&]() { readMessage(); ++calls; });
+    ASSERT_EQ(0, reactor.runOnce(base::Time()));
+
+    writeMessage(canbus::Message::Zeroed());
+    ASSERT_EQ(1, reactor.runOnce(base::Time()));
+    ASSERT_EQ(1, calls);
+    ASSERT_THROW(reactor.watch(pipeFDs[0], []() {}), std::invalid_argument);
+
+    reactor.unwatch(pipeFDs[0]);
+    writeMessage(canbus::Message::Zeroed());
+    ASSERT_EQ(0, reactor.runOnce(base::Time()));
+}
+
+TEST_F(ReactorTest, it_dispatches_frames_to_the_state_machines) {
+    StateMachine machine(3);
+    Dispatcher dispatcher;
+    dispatcher.add(machine);
+
+    vector<StateMachine::UPDATE_EVENT> modes;
+    reactor.watch(pipeFDs[0], [this]() { return readMessage(); }, dispatcher,
+        [&](canbus::Message const&, Update const& update) {
+            modes.push_back(update.mode);
+        });
+
+    auto heartbeat = canbus::Message::Zeroed();
+    heartbeat.can_id = FUNCTION_NMT_HEARTBEAT + 3;
+    heartbeat.size = 1;
+    heartbeat.data[0] = NODE_OPERATIONAL;
+    heartbeat.time = base::Time::fromSeconds(1);
+    writeMessage(heartbeat);
+    heartbeat.can_id = FUNCTION_NMT_HEARTBEAT + 4;
+    writeMessage(heartbeat);
+    while (modes.size() < 2)
+        reactor.runOnce();
+
+    ASSERT_EQ(StateMachine::PROCESSED_HEARTBEAT, modes[0]);
+    ASSERT_EQ(StateMachine::PROCESSED_NOT_FOR_ME, modes[1]);
+    ASSERT_EQ(NODE_OPERATIONAL, machine.getState());
+}
+
+TEST_F(ReactorTest, it_calls_periodic_timers_until_they_are_removed) {
+    int calls = 0;
+    int timer = reactor.addTimer(base::Time::fromMilliseconds(1),
+                                 base::Time::fromMilliseconds(1),
+                                 [&]() {
+        if (++calls == 3)
+            reactor.stop();
+    });
+    reactor.run();
+    ASSERT_EQ(3, calls);
+
+    reactor.removeTimer(timer);
+    ASSERT_EQ(0, reactor.runOnce(base::Time::fromMilliseconds(5)));
+    ASSERT_THROW(reactor.setTimer(timer, base::Time::fromMilliseconds(1)),
+                 std::invalid_argument);
+}
+
+TEST_F(ReactorTest, it_handles_timeouts_with_rearmed_one_shot_timers) {
+    bool timedOut = false;
+    int timeout = reactor.addTimer(base::Time::fromMilliseconds(20), base::Time(),
+                                   [&]() { timedOut = true; });
+    reactor.watch(pipeFDs[0], [&]() {
+        readMessage();
+        reactor.setTimer(timeout, base::Time::fromMilliseconds(20));
+    });
+
+    // Activity keeps re-arming the timeout
+    for (int i = 0; i < 5; ++i) {
+        writeMessage(canbus::Message::Zeroed());
+        reactor.runOnce(base::Time::fromMilliseconds(5));
+        ASSERT_FALSE(timedOut);
+    }
+
+    reactor.cancelTimer(timeout);
+    ASSERT_EQ(0, reactor.runOnce(base::Time::fromMilliseconds(30)));
+
+    reactor.setTimer(timeout, base::Time::fromMilliseconds(1));
+    ASSERT_EQ(1, reactor.runOnce());
+    ASSERT_TRUE(timedOut);
+}
+
+TEST_F(ReactorTest, it_lets_callbacks_remove_their_own_watch) {
+    int calls = 0;
+    reactor.watch(pipeFDs[0], [&]() {
+        ++calls;
+        reactor.unwatch(pipeFDs[0]);
+    });
+    writeMessage(canbus::Message::Zeroed());
+    ASSERT_EQ(1, reactor.runOnce());
+    ASSERT_EQ(0, reactor.runOnce(base::Time()));
+    ASSERT_EQ(1, calls);
+}
+
+TEST_F(ReactorTest, it_can_be_stopped_from_another_thread) {
+    std::thread stopper([this]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        reactor.stop();
+    });
+    reactor.run();
+    stopper.join();
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <canopen_master/Replay.hpp>
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+
+struct ReplayTest : public ::testing::Test {
+    string path = "/tmp/canopen_master_test_" + to_string(getpid()) + ".log";
+
+    ~ReplayTest() {
+        unlink(path.c_str());
+    }
+
+    /** A log of 100s with a PDO from node 2 every second, and heartbeats
+     * of node 3 from t=50s */
+    void writeCandumpLog() {
+        ofstream log(path);
+        for (int i = 0; i < 100; ++i) {
+            log << "(" << 1000 + i << ".000000) can0 182#"
+                << hex << setw(2) << setfill('0') << i << "00" << dec << "\n";
+            if (i >= 50)
+                log << "(" << 1000 + i << ".500000) can0 703#05\n";
+        }
+    }
+
+    StateMachine& addNode(Replay& replay) {
+        StateMachine& node = replay.addNode(2);
+        PDOMapping mapping;
+        mapping.add(0x6000, 1, 2);
+        node.declareTPDOMapping(0, mapping);
+        return node;
+    }
+
+    base::Time at(double seconds) {
+        return base::Time::fromSeconds(1000) + base::Time::fromMicroseconds(seconds * 1e6);
+    }
+};
+
+TEST_F(ReplayTest, it_parses_candump_logs) {
+    ofstream(path) << "(1436509052.249713) can0 181#0102030405060708\n"
+                   << "\n"
+                   << "(1436509052.5) vcan1 12345678#R\n"
+                   << "(1436509053.000001) can0 701#\n"
+                   << "(1436509053.1) can0 7";
+    CandumpReplayLog log(path);
+    canbus::Message msg;
+    ASSERT_TRUE(log.next(msg));
+    ASSERT_EQ(base::Time::fromMicroseconds(1436509052249713), msg.time);
+    ASSERT_EQ(0x181, msg.can_id);
+    ASSERT_EQ(8, msg.size);
+    ASSERT_EQ(8, msg.data[7]);
+    uint64_t position = log.tell();
+
+    ASSERT_TRUE(log.next(msg));
+    ASSERT_EQ(base::Time::fromMicroseconds(1436509052500000), msg.time);
+    ASSERT_EQ(0x12345678, msg.can_id);
+    ASSERT_EQ(0, msg.size);
+    ASSERT_TRUE(log.next(msg));
+    ASSERT_EQ(0x701, msg.can_id);
+    ASSERT_EQ(0, msg.size);
+    // The truncated last line is ignored
+    ASSERT_FALSE(log.next(msg));
+
+    log.seek(position);
+    ASSERT_TRUE(log.next(msg));
+    ASSERT_EQ(0x12345678, msg.can_id);
+
+    ofstream(path) << "(1436509052.249713) can0 181#0102030405060708090A\n";
+    CandumpReplayLog invalid(path);
+    ASSERT_THROW(invalid.next(msg), std::runtime_error);
+}
+
+TEST_F(ReplayTest, it_rebuilds_the_state_of_the_nodes_at_any_time) {
+    writeCandumpLog();
+    auto log = ReplayLog::open(path);
+    Replay replay(*log, base::Time::fromSeconds(10));
+    addNode(replay);
+    ASSERT_EQ(at(0), replay.getStartTime());
+
+    ASSERT_EQ(150, replay.run());
+    ASSERT_EQ(10, replay.getCheckpointCount());
+    ASSERT_EQ(99, replay.getNode(2)->get<uint16_t>(0x6000, 1));
+    ASSERT_EQ(NODE_OPERATIONAL, replay.getNode(3)->getState());
+
+    replay.seek(at(35.5));
+    ASSERT_EQ(36, replay.getFrameCount());
+    ASSERT_EQ(35, replay.getNode(2)->get<uint16_t>(0x6000, 1));
+    ASSERT_EQ(nullptr, replay.getNode(3));
+
+    replay.seek(at(60));
+    ASSERT_EQ(71, replay.getFrameCount());
+    ASSERT_EQ(60, replay.getNode(2)->get<uint16_t>(0x6000, 1));
+    ASSERT_EQ(NODE_OPERATIONAL, replay.getNode(3)->getState());
+
+    replay.seek(base::Time::fromSeconds(999));
+    ASSERT_EQ(0, replay.getFrameCount());
+    ASSERT_THROW(replay.getNode(2)->get<uint16_t>(0x6000, 1), ObjectNotRead);
+    ASSERT_TRUE(replay.step());
+    ASSERT_EQ(0, replay.getNode(2)->get<uint16_t>(0x6000, 1));
+    ASSERT_EQ(0, replay.getErrorCount());
+}
+
+TEST_F(ReplayTest, it_does_not_create_nodes_for_LSS_frames) {
+    ofstream(path) << "(1000.000000) can0 7E5#4C00000000000000\n"
+                   << "(1000.100000) can0 7E4#5000000000000000\n"
+                   << "(1000.200000) can0 702#7F\n";
+    auto log = ReplayLog::open(path);
+    Replay replay(*log);
+    ASSERT_EQ(3, replay.run());
+    ASSERT_EQ(nullptr, replay.getNode(100));
+    ASSERT_EQ(nullptr, replay.getNode(101));
+    ASSERT_EQ(NODE_PRE_OPERATIONAL, replay.getNode(2)->getState());
+    ASSERT_EQ(0, replay.getErrorCount());
+}
+
+TEST_F(ReplayTest, it_replays_recordings_at_a_multiple_of_the_recorded_rate) {
+    {
+        FrameRecorder recorder(path, 16);
+        auto msg = canbus::Message::Zeroed();
+        msg.can_id = 0x702;
+        msg.size = 1;
+        msg.data[0] = NODE_PRE_OPERATIONAL;
+        for (int i = 0; i < 10; ++i) {
+            msg.time = at(i * 0.01);
+            recorder.record(msg);
+        }
+    }
+
+    auto log = ReplayLog::open(path);
+    Replay replay(*log);
+    int heartbeats = 0;
+    replay.setHandler([&heartbeats](canbus::Message const&, StateMachine::Update const& update) {
+        heartbeats += (update.mode == StateMachine::PROCESSED_HEARTBEAT);
+    });
+    auto start = chrono::steady_clock::now();
+    ASSERT_EQ(10, replay.run(2));
+    ASSERT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(45));
+    ASSERT_EQ(10, heartbeats);
+    ASSERT_EQ(NODE_PRE_OPERATIONAL, replay.getNode(2)->getState());
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SDOClient.hpp>
+#include <canopen_master/SimulatedBus.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/Objects.hpp>
+#include <canopen_master/SDO.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+struct SDOClientTest : public ::testing::Test {
+    SimulatedBus bus;
+    StateMachine machine;
+    SDOClient sdo;
+    vector<canbus::Message> written;
+
+    SDOClientTest()
+        : machine(1)
+        , sdo(machine, [this](canbus::Message const& msg) {
+            written.push_back(msg);
+            bus.write(msg);
+        }) {
+        machine.setClock(bus.getClock());
+        SimulatedNode& node = bus.addNode(1);
+        node.declare<DeviceType>(0x20192);
+        node.declare(0x2000, 1, 2, 0x1234);
+    }
+
+    void run() {
+        canbus::Message msg;
+        while (bus.read(msg, base::Time::fromMilliseconds(10)))
+            sdo.process(msg);
+    }
+};
+
+TEST_F(SDOClientTest, it_runs_the_transactions_of_a_node_one_at_a_time) {
+    vector<string> completed;
+    sdo.upload<DeviceType>([&](exception_ptr error) {
+        ASSERT_FALSE(error);
+        completed.push_back("device type");
+    });
+    sdo.upload(0x2000, 1, [&](exception_ptr error) {
+        ASSERT_FALSE(error);
+        completed.push_back("upload");
+    });
+    sdo.download(machine.download<uint16_t>(0x2000, 1, 0x4321), [&](exception_ptr error) {
+        ASSERT_FALSE(error);
+        completed.push_back("download");
+    });
+    ASSERT_EQ(1, written.size());
+    ASSERT_EQ(3, sdo.getPendingCount());
+
+    run();
+    ASSERT_EQ(3, written.size());
+    ASSERT_EQ(0, sdo.getPendingCount());
+    ASSERT_EQ(vector<string>({ "device type", "upload", "download" }), completed);
+    ASSERT_EQ(0x20192, machine.get<uint32_t>(0x1000, 0));
+    ASSERT_EQ(0x1234, machine.get<uint16_t>(0x2000, 1));
+    ASSERT_EQ(0x4321, bus.getNode(1).get(0x2000, 1));
+}
+
+TEST_F(SDOClientTest, it_lets_completions_queue_the_next_step) {
+    bool done = false;
+    sdo.upload<DeviceType>([&](exception_ptr) {
+        sdo.download<ProducerHeartbeatTime>(100, [&](exception_ptr error) {
+            done = !error;
+        });
+    });
+    run();
+    ASSERT_TRUE(done);
+    ASSERT_EQ(100, bus.getNode(1).get<ProducerHeartbeatTime>());
+}
+
+TEST_F(SDOClientTest, it_passes_aborts_to_the_completion) {
+    exception_ptr thrown, reported;
+    sdo.upload(0x2001, 0, [&](exception_ptr error) { thrown = error; });
+    run();
+
+    machine.setThrowOnDeviceErrors(false);
+    sdo.upload(0x2001, 0, [&](exception_ptr error) { reported = error; });
+    run();
+
+    ASSERT_THROW(rethrow_exception(thrown), SDODomainTransferAborted);
+    try {
+        rethrow_exception(reported);
+        FAIL();
+    }
+    catch(SDODomainTransferAborted const& e) {
+        ASSERT_EQ(0x2001, e.objectId);
+    }
+}
+
+TEST_F(SDOClientTest, it_fails_transactions_without_reply_after_the_timeout) {
+    StateMachine missing(2);
+    missing.setClock(bus.getClock());
+    SDOClient missingSDO(missing, [this](canbus::Message const& msg) { bus.write(msg); });
+
+    exception_ptr first;
+    bool secondSent = false;
+    missingSDO.upload<DeviceType>([&](exception_ptr error) { first = error; });
+    missingSDO.upload<DeviceType>([&](exception_ptr) { secondSent = true; });
+
+    bus.run(base::Time::fromMilliseconds(50));
+    missingSDO.checkTimeouts(bus.getTime());
+    ASSERT_FALSE(first);
+
+    bus.run(base::Time::fromMilliseconds(60));
+    missingSDO.checkTimeouts(bus.getTime());
+    ASSERT_THROW(rethrow_exception(first), SDOTimeout);
+    ASSERT_FALSE(secondSent);
+    ASSERT_EQ(1, missingSDO.getPendingCount());
+}
+
+TEST_F(SDOClientTest, it_completes_the_transactions_in_order_when_a_write_fails) {
+    vector<string> completed;
+    SDOClient failing(machine, [&](canbus::Message const& msg) {
+        if (getSDOObjectID(msg) == 0x2000)
+            throw std::runtime_error("write failed");
+        bus.write(msg);
+    });
+    failing.upload<DeviceType>([&](exception_ptr error) {
+        ASSERT_FALSE(error);
+        completed.push_back("device type");
+    });
+    failing.upload(0x2000, 1, [&](exception_ptr error) {
+        ASSERT_THROW(rethrow_exception(error), std::runtime_error);
+        completed.push_back("failed");
+    });
+    failing.upload<DeviceType>([&](exception_ptr error) {
+        ASSERT_FALSE(error);
+        completed.push_back("device type again");
+    });
+
+    canbus::Message msg;
+    while (bus.read(msg, base::Time::fromMilliseconds(10)))
+        failing.process(msg);
+    ASSERT_EQ(vector<string>({ "device type", "failed", "device type again" }),
+              completed);
+    ASSERT_EQ(0, failing.getPendingCount());
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SDOCoroutine.hpp>
+#include <canopen_master/SimulatedBus.hpp>
+#include <canopen_master/Dispatcher.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/Objects.hpp>
+
+using namespace std;
+using namespace canopen_master;
+
+struct SDOCoroutineTest : public ::testing::Test {
+    SimulatedBus bus;
+    vector<unique_ptr<StateMachine>> machines;
+    vector<unique_ptr<SDOClient>> clients;
+    vector<uint8_t> writtenNodes;
+
+    SDOCoroutineTest() {
+        for (uint8_t nodeId = 1; nodeId <= 2; ++nodeId) {
+            bus.addNode(nodeId).declare<DeviceType>(0x20190 + nodeId);
+            machines.push_back(unique_ptr<StateMachine>(new StateMachine(nodeId)));
+            machines.back()->setClock(bus.getClock());
+            clients.push_back(unique_ptr<SDOClient>(new SDOClient(
+                *machines.back(), [this](canbus::Message const& msg) {
+                    writtenNodes.push_back(getNodeID(msg));
+                    bus.write(msg);
+                })));
+        }
+    }
+
+    void run() {
+        canbus::Message msg;
+        while (bus.read(msg, base::Time::fromMilliseconds(10))) {
+            uint8_t nodeId = getNodeID(msg);
+            if (nodeId >= 1 && nodeId <= clients.size())
+                clients[nodeId - 1]->process(msg);
+        }
+    }
+};
+
+static SDOTask configureHeartbeat(SDOClient& sdo, uint16_t period) {
+    co_await download<ProducerHeartbeatTime>(sdo, period);
+    co_await upload<ProducerHeartbeatTime>(sdo);
+}
+
+static SDOTask bringUp(SDOClient& sdo, uint32_t& deviceType) {
+    deviceType = co_await upload<DeviceType>(sdo);
+    co_await configureHeartbeat(sdo, 100);
+}
+
+TEST_F(SDOCoroutineTest, it_interleaves_the_bring_up_of_several_nodes) {
+    uint32_t deviceTypes[2] = { 0, 0 };
+    SDOTask first = bringUp(*clients[0], deviceTypes[0]);
+    SDOTask second = bringUp(*clients[1], deviceTypes[1]);
+    ASSERT_FALSE(first.isDone());
+    ASSERT_EQ(vector<uint8_t>({ 1, 2 }), writtenNodes);
+
+    run();
+    ASSERT_TRUE(first.isDone());
+    ASSERT_TRUE(second.isDone());
+    first.get();
+    second.get();
+    ASSERT_EQ(0x20191, deviceTypes[0]);
+    ASSERT_EQ(0x20192, deviceTypes[1]);
+    ASSERT_EQ(100, machines[1]->get<uint16_t>(0x1017, 0));
+    ASSERT_EQ(100, bus.getNode(1).get<ProducerHeartbeatTime>());
+    ASSERT_EQ(vector<uint8_t>({ 1, 2, 1, 2, 1, 2 }), writtenNodes);
+}
+
+static SDOTask uploadUnknown(SDOClient& sdo, bool& caught) {
+    try {
+        co_await upload(sdo, 0x2001, 0);
+    }
+    catch(SDODomainTransferAborted const&) {
+        caught = true;
+    }
+    co_await upload(sdo, 0x2001, 0);
+}
+
+TEST_F(SDOCoroutineTest, it_throws_SDO_errors_in_the_coroutine) {
+    bool caught = false;
+    SDOTask task = uploadUnknown(*clients[0], caught);
+    ASSERT_THROW(task.get(), std::logic_error);
+
+    run();
+    ASSERT_TRUE(caught);
+    ASSERT_THROW(task.get(), SDODomainTransferAborted);
+}
+
+TEST_F(SDOCoroutineTest, it_does_not_suspend_if_the_request_cannot_be_written) {
+    SDOClient failing(*machines[0], [](canbus::Message const&) {
+        throw std::runtime_error("write failed");
+    });
+    uint32_t deviceType;
+    SDOTask task = bringUp(failing, deviceType);
+    ASSERT_TRUE(task.isDone());
+    ASSERT_THROW(task.get(), std::runtime_error);
+}
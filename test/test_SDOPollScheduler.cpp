@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SDOPollScheduler.hpp>
+#include <canopen_master/SDO.hpp>
+
+using namespace base;
+using namespace canopen_master;
+
+struct SDOPollSchedulerTest : public ::testing::Test {
+    StateMachine node2;
+    StateMachine node3;
+    SDOPollScheduler scheduler;
+    Time now;
+
+    SDOPollSchedulerTest()
+        : node2(2)
+        , node3(3)
+        , scheduler(1000000)
+        , now(Time::fromSeconds(1000)) {
+    }
+
+    canbus::Message reply(uint8_t nodeId, canbus::Message const& request) {
+        canbus::Message msg;
+        msg.time = now;
+        msg.can_id = FUNCTION_SDO_TRANSMIT + nodeId;
+        msg.size = 8;
+        msg.data[0] = 0x4F;
+        msg.data[1] = request.data[1];
+        msg.data[2] = request.data[2];
+        msg.data[3] = request.data[3];
+        msg.data[4] = 0x42;
+        return msg;
+    }
+
+    void answer(StateMachine& node, canbus::Message const& request) {
+        auto update = node.process(reply(node.getNodeID(), request));
+        scheduler.process(node.getNodeID(), update, now);
+    }
+};
+
+TEST_F(SDOPollSchedulerTest, it_issues_an_upload_for_a_due_object) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_EQ(0x602, msg.can_id);
+    ASSERT_EQ(SDO_INITIATE_DOMAIN_UPLOAD, getSDOCommand(msg).command);
+    ASSERT_EQ(0x2000, getSDOObjectID(msg));
+    ASSERT_EQ(1, getSDOObjectSubID(msg));
+    ASSERT_TRUE(scheduler.isPending(2));
+}
+
+TEST_F(SDOPollSchedulerTest, it_keeps_at_most_one_pending_request_per_node) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    scheduler.add(node2, 0x2000, 2, Time::fromMilliseconds(100));
+    scheduler.add(node3, 0x2000, 1, Time::fromMilliseconds(100));
+    canbus::Message first, second, msg;
+    ASSERT_TRUE(scheduler.poll(now, first));
+    ASSERT_TRUE(scheduler.poll(now, second));
+    ASSERT_EQ(0x602, first.can_id);
+    ASSERT_EQ(0x603, second.can_id);
+    ASSERT_FALSE(scheduler.poll(now, msg));
+
+    answer(node2, first);
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_EQ(0x602, msg.can_id);
+    ASSERT_EQ(2, getSDOObjectSubID(msg));
+}
+
+TEST_F(SDOPollSchedulerTest, it_serves_shorter_periods_first) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    scheduler.add(node2, 0x2000, 2, Time::fromMilliseconds(10));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_EQ(2, getSDOObjectSubID(msg));
+}
+
+TEST_F(SDOPollSchedulerTest, it_serves_higher_priorities_first) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100), 1);
+    scheduler.add(node2, 0x2000, 2, Time::fromMilliseconds(10));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_EQ(1, getSDOObjectSubID(msg));
+}
+
+TEST_F(SDOPollSchedulerTest, it_waits_for_the_object_period_before_polling_again) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    answer(node2, msg);
+    ASSERT_FALSE(scheduler.poll(now + Time::fromMilliseconds(99), msg));
+    ASSERT_TRUE(scheduler.poll(now + Time::fromMilliseconds(100), msg));
+}
+
+TEST_F(SDOPollSchedulerTest, it_limits_the_polling_to_the_bus_load_budget) {
+    // 270 bits per transaction, 20 transactions per second
+    SDOPollScheduler scheduler(10800, 0.5);
+    ASSERT_DOUBLE_EQ(20, scheduler.getTransactionsPerSecond());
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(1));
+    scheduler.add(node3, 0x2000, 1, Time::fromMilliseconds(1));
+
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_FALSE(scheduler.poll(now, msg));
+    ASSERT_FALSE(scheduler.poll(now + Time::fromMilliseconds(49), msg));
+    ASSERT_TRUE(scheduler.poll(now + Time::fromMilliseconds(50), msg));
+}
+
+TEST_F(SDOPollSchedulerTest, it_removes_the_reserved_traffic_from_the_budget) {
+    SDOPollScheduler scheduler(10800, 0.5);
+    scheduler.setReservedFramesPerSecond(40);
+    ASSERT_DOUBLE_EQ(0, scheduler.getTransactionsPerSecond());
+}
+
+TEST_F(SDOPollSchedulerTest, it_reports_staleness) {
+    scheduler.setSDOTimeout(Time::fromMilliseconds(10));
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    ASSERT_TRUE(scheduler.isStale(2, 0x2000, 1, now));
+    ASSERT_TRUE(scheduler.getAge(2, 0x2000, 1, now).isNull());
+
+    canbus::Message msg;
+    scheduler.poll(now, msg);
+    answer(node2, msg);
+    ASSERT_FALSE(scheduler.isStale(2, 0x2000, 1, now + Time::fromMilliseconds(110)));
+    ASSERT_TRUE(scheduler.isStale(2, 0x2000, 1, now + Time::fromMilliseconds(111)));
+    ASSERT_EQ(Time::fromMilliseconds(50),
+              scheduler.getAge(2, 0x2000, 1, now + Time::fromMilliseconds(50)));
+    ASSERT_EQ(1, scheduler.getStaleCount(now + Time::fromMilliseconds(111)));
+}
+
+TEST_F(SDOPollSchedulerTest, it_frees_the_node_on_timeout) {
+    scheduler.setSDOTimeout(Time::fromMilliseconds(10));
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(1));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    ASSERT_FALSE(scheduler.poll(now + Time::fromMilliseconds(10), msg));
+    ASSERT_TRUE(scheduler.poll(now + Time::fromMilliseconds(11), msg));
+    ASSERT_EQ(1, scheduler.getStatus()[0].timeouts);
+}
+
+TEST_F(SDOPollSchedulerTest, it_frees_the_node_on_abort) {
+    scheduler.add(node2, 0x2000, 1, Time::fromMilliseconds(100));
+    canbus::Message msg;
+    ASSERT_TRUE(scheduler.poll(now, msg));
+    scheduler.abort(2);
+    ASSERT_FALSE(scheduler.isPending(2));
+    ASSERT_EQ(1, scheduler.getStatus()[0].aborts);
+}
+
+TEST_F(SDOPollSchedulerTest, it_rejects_invalid_node_IDs) {
+    StateMachine node(200);
+    ASSERT_THROW(scheduler.add(node, 0x2000, 1, Time::fromMilliseconds(100)),
+                 std::invalid_argument);
+    ASSERT_TRUE(scheduler.getStatus().empty());
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <canopen_master/ShardedDispatcher.hpp>
+#include <canopen_master/SyncProducer.hpp>
+#include <mutex>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+struct ShardedDispatcherTest : public ::testing::Test {
+    static const int NODE_COUNT = 8;
+    ShardedDispatcher dispatcher;
+    vector<unique_ptr<StateMachine>> machines;
+    base::Time time = base::Time::fromSeconds(1000);
+
+    ShardedDispatcherTest()
+        : dispatcher(4, 64) {
+        PDOMapping mapping;
+        mapping.add(0x2000, 0, 4);
+        for (int i = 1; i <= NODE_COUNT; ++i) {
+            machines.push_back(unique_ptr<StateMachine>(new StateMachine(i)));
+            machines.back()->declareTPDOMapping(0, mapping);
+            dispatcher.add(*machines.back());
+        }
+    }
+
+    canbus::Message makePDO(uint8_t nodeId, uint32_t value) {
+        auto msg = canbus::Message::Zeroed();
+        msg.can_id = FUNCTION_PDO0_TRANSMIT + nodeId;
+        msg.size = 4;
+        msg.time = time;
+        for (int i = 0; i < 4; ++i)
+            msg.data[i] = value >> (8 * i);
+        return msg;
+    }
+
+    template<typename F>
+    void waitFor(F condition) {
+        for (int i = 0; i < 5000 && !condition(); ++i)
+            this_thread::sleep_for(chrono::milliseconds(1));
+        ASSERT_TRUE(condition());
+    }
+};
+
+TEST_F(ShardedDispatcherTest, it_assigns_nodes_to_shards) {
+    ASSERT_EQ(1, dispatcher.getShard(1));
+    ASSERT_EQ(0, dispatcher.getShard(8));
+    ASSERT_EQ(-1, dispatcher.getShard(9));
+    ASSERT_EQ(machines[2].get(), dispatcher.get(3));
+
+    StateMachine duplicate(3);
+    ASSERT_THROW(dispatcher.add(duplicate), std::invalid_argument);
+    StateMachine other(9);
+    ASSERT_THROW(dispatcher.add(other, 4), std::invalid_argument);
+}
+
+TEST_F(ShardedDispatcherTest, it_drops_frames_it_cannot_route) {
+    ASSERT_FALSE(dispatcher.route(makePDO(9, 0)));
+    auto nmt = makePDO(0, 0);
+    nmt.can_id = 0;
+    ASSERT_FALSE(dispatcher.route(nmt));
+    ASSERT_EQ(2, dispatcher.getDroppedCount());
+
+    // The shard rings have a capacity of 64
+    FrameRing input(128);
+    for (int i = 0; i < 65; ++i)
+        input.push(makePDO(1, i));
+    ASSERT_EQ(65, dispatcher.route(input, 100));
+    ASSERT_EQ(3, dispatcher.getDroppedCount());
+}
+
+TEST_F(ShardedDispatcherTest, it_preserves_the_order_of_the_frames_of_a_node) {
+    mutex lock;
+    vector<uint32_t> lastValues(NODE_COUNT + 1, 0);
+    bool ordered = true;
+    dispatcher.setHandler([&](size_t shard, canbus::Message const& msg,
+                              Update const& update) {
+        uint8_t nodeId = getNodeID(msg);
+        uint32_t value = machines[nodeId - 1]->get<uint32_t>(0x2000, 0);
+        lock_guard<mutex> guard(lock);
+        ordered = ordered && update.mode == StateMachine::PROCESSED_PDO &&
+            shard == static_cast<size_t>(dispatcher.getShard(nodeId)) &&
+            value == lastValues[nodeId] + 1;
+        lastValues[nodeId] = value;
+    });
+    dispatcher.start();
+
+    for (uint32_t value = 1; value <= 100; ++value) {
+        for (int nodeId = 1; nodeId <= NODE_COUNT; ++nodeId) {
+            while (!dispatcher.route(makePDO(nodeId, value)))
+                this_thread::yield();
+        }
+    }
+
+    waitFor([&]() {
+        uint64_t total = 0;
+        for (size_t i = 0; i < dispatcher.getShardCount(); ++i)
+            total += dispatcher.getProcessedCount(i);
+        return total == 800;
+    });
+    dispatcher.stop();
+    ASSERT_TRUE(ordered);
+}
+
+TEST_F(ShardedDispatcherTest, it_gives_a_coherent_view_of_all_nodes_at_each_SYNC) {
+    vector<uint64_t> cycles;
+    bool coherent = true;
+    dispatcher.setSyncHandler([&](uint64_t cycle, base::Time const&) {
+        cycles.push_back(cycle);
+        for (auto& machine : machines) {
+            coherent = coherent &&
+                machine->get<uint32_t>(0x2000, 0) == cycle * 10 &&
+                machine->getSyncCycle() == cycle;
+        }
+    });
+    dispatcher.start();
+
+    for (uint32_t cycle = 1; cycle <= 20; ++cycle) {
+        for (uint32_t i = 1; i <= 10; ++i) {
+            for (int nodeId = 1; nodeId <= NODE_COUNT; ++nodeId) {
+                while (!dispatcher.route(makePDO(nodeId, (cycle - 1) * 10 + i)))
+                    this_thread::yield();
+            }
+        }
+        dispatcher.route(makeSyncMessage(0, time));
+    }
+
+    waitFor([&]() { return dispatcher.getSyncCycle() == 20; });
+    dispatcher.stop();
+    ASSERT_EQ(20, cycles.size());
+    ASSERT_EQ(20, cycles.back());
+    ASSERT_TRUE(coherent);
+}
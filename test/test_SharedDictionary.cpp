@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SharedDictionary.hpp>
+#include <canopen_master/Objects.hpp>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+
+struct SharedDictionaryTest : public ::testing::Test {
+    string name = "/canopen_master_test_" + to_string(getpid());
+    StateMachine machine;
+    base::Time time = base::Time::fromSeconds(100);
+
+    SharedDictionaryTest()
+        : machine(2) {
+        PDOMapping mapping;
+        mapping.add(0x6000, 1, 2);
+        mapping.add(0x6000, 2, 4);
+        machine.declareTPDOMapping(0, mapping);
+    }
+
+    void receivePDO(int16_t first, uint32_t second) {
+        auto msg = canbus::Message::Zeroed();
+        msg.time = time;
+        msg.can_id = FUNCTION_PDO0_TRANSMIT + 2;
+        msg.size = 6;
+        toLittleEndian(msg.data, first);
+        toLittleEndian(msg.data + 2, second);
+        machine.process(msg);
+    }
+};
+
+TEST_F(SharedDictionaryTest, it_publishes_the_objects_written_by_the_state_machine) {
+    SharedDictionary shared(name, 8);
+    machine.set<uint8_t>(ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID, 4, time);
+    ASSERT_EQ(0, shared.add<ErrorRegister>(machine));
+    ASSERT_EQ(1, shared.add(machine, 0x6000, 1));
+    ASSERT_EQ(2, shared.add(machine, 0x6000, 2));
+
+    SharedDictionaryReader reader(name);
+    ASSERT_EQ(3, reader.getEntryCount());
+    ASSERT_EQ(1, reader.find(2, 0x6000, 1));
+    ASSERT_EQ(-1, reader.find(3, 0x6000, 1));
+    ASSERT_EQ(0, reader.find<ErrorRegister>(2));
+
+    ASSERT_EQ(4, reader.get<uint8_t>(0));
+    SharedObjectValue value;
+    ASSERT_FALSE(reader.read(1, value));
+    ASSERT_THROW(reader.get<int16_t>(1), ObjectNotRead);
+
+    receivePDO(-5, 0x12345678);
+    ASSERT_TRUE(reader.read(1, value));
+    ASSERT_EQ(toTimestamp(time), value.timestamp);
+    ASSERT_EQ(-5, value.as<int16_t>());
+    ASSERT_EQ(0x12345678u, reader.get<uint32_t>(2));
+    ASSERT_THROW(reader.get<uint32_t>(3), std::out_of_range);
+}
+
+TEST_F(SharedDictionaryTest, it_rejects_segments_that_are_not_shared_dictionaries) {
+    ASSERT_THROW(SharedDictionaryReader reader(name), std::runtime_error);
+
+    {
+        SharedDictionary shared(name, 1);
+        shared.add(machine, 0x6000, 1);
+        ASSERT_THROW(shared.add(machine, 0x6000, 2), std::length_error);
+    }
+    // The segment is removed with the writer
+    ASSERT_THROW(SharedDictionaryReader reader(name), std::runtime_error);
+}
+
+TEST_F(SharedDictionaryTest, readers_always_see_consistent_entries) {
+    SharedDictionary shared(name, 1);
+    shared.add(machine, 0x6000, 2);
+    SharedDictionaryReader reader(name);
+
+    atomic<bool> done(false);
+    bool consistent = true;
+    std::thread readerThread([&]() {
+        SharedObjectValue value;
+        while (!done) {
+            // The writer sets the value to the timestamp's lower bits
+            if (reader.read(0, value))
+                consistent = consistent && value.as<uint32_t>() == static_cast<uint32_t>(value.timestamp);
+            this_thread::yield();
+        }
+    });
+
+    for (int i = 1; i <= 100000; ++i) {
+        uint8_t data[4];
+        toLittleEndian<uint32_t>(data, i);
+        shared.write(0, data, 4, i);
+        if (i % 100 == 0)
+            this_thread::yield();
+    }
+    done = true;
+    readerThread.join();
+    ASSERT_TRUE(consistent);
+    ASSERT_EQ(100000, reader.get<uint32_t>(0));
+}
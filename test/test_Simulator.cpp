@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SimulatedBus.hpp>
+#include <canopen_master/StateMachine.hpp>
+#include <canopen_master/Exceptions.hpp>
+#include <canopen_master/NMT.hpp>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+struct SimulatorTest : public ::testing::Test {
+    SimulatedBus bus;
+    StateMachine machine;
+
+    SimulatorTest()
+        : machine(1) {
+        bus.addNode(1).declare(0x2000, 1, 2, 0x1234);
+    }
+
+    /** Process the boot-up message */
+    void boot() {
+        ASSERT_EQ(StateMachine::PROCESSED_HEARTBEAT, processReply().mode);
+    }
+
+    /** Wait for the next reply for the node under test */
+    Update processReply() {
+        canbus::Message msg;
+        while (bus.read(msg, base::Time::fromMilliseconds(10))) {
+            Update update = machine.process(msg);
+            if (update.mode != StateMachine::PROCESSED_NOT_FOR_ME)
+                return update;
+        }
+        throw std::runtime_error("timed out waiting for a reply");
+    }
+
+    void execute(vector<canbus::Message> const& messages) {
+        for (auto const& msg : messages) {
+            bus.write(msg);
+            processReply();
+        }
+    }
+};
+
+TEST_F(SimulatorTest, it_sends_a_bootup_message) {
+    canbus::Message msg;
+    ASSERT_TRUE(bus.read(msg, base::Time::fromMilliseconds(1)));
+    ASSERT_EQ(0x701, msg.can_id);
+    ASSERT_EQ(0, msg.data[0]);
+    ASSERT_EQ(NODE_PRE_OPERATIONAL, bus.getNode(1).getState());
+}
+
+TEST_F(SimulatorTest, it_answers_SDO_uploads_and_downloads) {
+    boot();
+    bus.write(machine.upload(0x2000, 1));
+    ASSERT_TRUE(processReply().hasUpdatedObject(0x2000, 1));
+    ASSERT_EQ(0x1234, machine.get<uint16_t>(0x2000, 1));
+
+    bus.write(machine.download<uint16_t>(0x2000, 1, 0x4321));
+    ASSERT_EQ(StateMachine::PROCESSED_SDO_INITIATE_DOWNLOAD, processReply().mode);
+    ASSERT_EQ(0x4321, bus.getNode(1).get(0x2000, 1));
+}
+
+TEST_F(SimulatorTest, it_aborts_SDO_transfers_of_unknown_objects) {
+    boot();
+    bus.write(machine.upload(0x2001, 0));
+    ASSERT_THROW(processReply(), SDODomainTransferAborted);
+}
+
+TEST_F(SimulatorTest, it_produces_heartbeats) {
+    bus.getNode(1).setHeartbeatPeriod(base::Time::fromMilliseconds(100));
+    bus.run(base::Time::fromSeconds(1.05));
+
+    int count = 0;
+    canbus::Message msg;
+    while (bus.read(msg)) {
+        if (machine.process(msg).mode == StateMachine::PROCESSED_HEARTBEAT)
+            ++count;
+    }
+    ASSERT_EQ(11, count); // including the boot-up message
+    ASSERT_EQ(NODE_PRE_OPERATIONAL, machine.getState());
+}
+
+TEST_F(SimulatorTest, it_produces_TPDOs_configured_by_the_master) {
+    boot();
+    PDOMapping mapping;
+    mapping.add(0x2000, 1, 2);
+    execute(machine.configurePDO(true, 0, PDOCommunicationParameters::Sync(2), mapping));
+    machine.declareTPDOMapping(0, mapping);
+
+    uint16_t value = 0;
+    bus.getNode(1).setUpdateHandler([&value](SimulatedNode& node, base::Time const&) {
+        node.set(0x2000, 1, ++value);
+    });
+    bus.write(makeModuleControlCommand(NODE_START, 0));
+    bus.setSyncPeriod(base::Time::fromMilliseconds(1));
+    bus.run(base::Time::fromSeconds(0.0105));
+
+    int count = 0;
+    canbus::Message msg;
+    while (bus.read(msg)) {
+        auto update = machine.process(msg);
+        if (update.mode == StateMachine::PROCESSED_PDO) {
+            ++count;
+            ASSERT_EQ(count, machine.get<uint16_t>(0x2000, 1));
+        }
+    }
+    ASSERT_EQ(5, count);
+}
+
+TEST_F(SimulatorTest, it_receives_RPDOs) {
+    bus.getNode(1).declare(0x2010, 0, 4);
+    PDOMapping mapping;
+    mapping.add(0x2010, 0, 4);
+    bus.getNode(1).configureRPDO(1, mapping);
+    bus.getNode(1).setState(NODE_OPERATIONAL);
+
+    machine.declareRPDOMapping(1, mapping);
+    machine.set<uint32_t>(0x2010, 0, 0x12345678);
+    bus.write(machine.getRPDOMessage(1));
+    bus.run(base::Time::fromMilliseconds(1));
+    ASSERT_EQ(0x12345678, bus.getNode(1).get(0x2010, 0));
+}
+
+TEST_F(SimulatorTest, it_sends_emergencies) {
+    boot();
+    bus.getNode(1).raiseEmergency(0x2310, 0x03);
+    ASSERT_THROW(processReply(), EmergencyMessageReceived);
+    ASSERT_EQ(0x03, machine.get<uint8_t>(0x1001, 0));
+}
+
+TEST_F(SimulatorTest, it_provides_a_clock_in_virtual_time) {
+    machine.setClock(bus.getClock());
+    bus.run(base::Time::fromMilliseconds(5));
+    machine.set<uint16_t>(0x2000, 1, 10);
+    ASSERT_EQ(base::Time::fromSeconds(1000.005), machine.timestamp(0x2000, 1));
+}
+
+TEST(SimulatedBus, it_gives_priority_to_the_lowest_CAN_ID) {
+    SimulatedBus bus;
+    for (int i = 10; i > 0; --i)
+        bus.addNode(i);
+    bus.run(base::Time::fromMilliseconds(10));
+
+    canbus::Message msg;
+    base::Time lastTime;
+    for (int i = 1; i <= 10; ++i) {
+        ASSERT_TRUE(bus.read(msg));
+        ASSERT_EQ(0x700 + i, msg.can_id);
+        ASSERT_GT(msg.time, lastTime);
+        lastTime = msg.time;
+    }
+}
+
+TEST(SimulatedBus, it_accounts_for_the_bus_load) {
+    SimulatedBus bus(500000);
+    bus.addNode(1).setHeartbeatPeriod(base::Time::fromMilliseconds(1));
+    bus.run(base::Time::fromSeconds(1));
+    // The last heartbeat is still being transmitted
+    ASSERT_EQ(1000, bus.getFrameCount());
+    double expected = 1000 * SimulatedBus::getFrameBits(1) / 500000.0;
+    ASSERT_NEAR(expected, bus.getBusLoad(), 1e-3);
+}
+
+TEST(SimulatedBus, it_is_deterministic) {
+    vector<canbus::Message> runs[2];
+    for (auto& received : runs) {
+        SimulatedBus bus;
+        for (int i = 1; i <= 100; ++i) {
+            auto& node = bus.addNode(i);
+            node.declare(0x2000, 0, 4);
+            PDOMapping mapping;
+            mapping.add(0x2000, 0, 4);
+            node.configureTPDO(0, PDOCommunicationParameters::Sync(1), mapping);
+            node.configureTPDO(1, PDOCommunicationParameters::Periodic(
+                base::Time::fromMilliseconds(i % 7 + 3)), mapping);
+            node.setHeartbeatPeriod(base::Time::fromMilliseconds(100));
+        }
+        bus.write(makeModuleControlCommand(NODE_START, 0));
+        bus.setSyncPeriod(base::Time::fromMilliseconds(10));
+        bus.run(base::Time::fromSeconds(1));
+
+        canbus::Message msg;
+        while (bus.read(msg))
+            received.push_back(msg);
+    }
+
+    ASSERT_EQ(runs[0].size(), runs[1].size());
+    ASSERT_GT(runs[0].size(), 10000);
+    for (size_t i = 0; i < runs[0].size(); ++i) {
+        ASSERT_EQ(runs[0][i].can_id, runs[1][i].can_id);
+        ASSERT_EQ(runs[0][i].time, runs[1][i].time);
+    }
+}
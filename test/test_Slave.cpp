@@ -93,4 +93,31 @@ TEST_F(SlaveTest, it_allows_adding_offset_to_id_and_subid_in_get_and_set) {
     ASSERT_EQ(0x12345678, state_machine.get<uint32_t>(0x101, 3));
     auto value = slave.get<Test_100_1>(1, 2);
     ASSERT_EQ(0x12345678, value);
-}
\ No newline at end of file
+}
+TEST_F(SlaveTest, it_timestamps_objects_with_the_state_machine_clock) {
+    CachedClock clock(Time::fromSeconds(100));
+    state_machine.setClock(clock);
+    slave.set<Test_100_1>(0x12345678);
+    slave.set<Test_100_1>(0x12345678, 1, 2);
+    ASSERT_EQ(clock.now(), slave.timestamp<Test_100_1>());
+    ASSERT_EQ(clock.now(), slave.timestamp<Test_100_1>(1, 2));
+}
+
+TEST_F(SlaveTest, it_subscribes_to_an_object) {
+    uint32_t value = 0;
+    auto id = slave.subscribe<Test_100_1>([&](uint32_t v, Time const&) { value = v; }, 0x100);
+
+    canbus::Message msg = canbus::Message::Zeroed();
+    msg.time = Time::fromSeconds(10);
+    msg.can_id = 0x580 + 42;
+    msg.size = 8;
+    uint8_t reply[8] = { 0x43, 0x00, 0x02, 0x01, 0x78, 0x56, 0x34, 0x12 };
+    std::copy(reply, reply + 8, msg.data);
+    slave.process(msg);
+    ASSERT_EQ(0x12345678u, value);
+
+    slave.unsubscribe(id);
+    msg.data[4] = 0;
+    slave.process(msg);
+    ASSERT_EQ(0x12345678u, value);
+}
@@ -86,6 +86,56 @@ TEST(StateMachine, processThrowsOnAnEmergencyMessage)
         machine.get<uint8_t>(ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID));
 }
 
+TEST(StateMachine, processReportsEmergenciesAsUpdatesIfThrowOnDeviceErrorsIsFalse)
+{
+    StateMachine machine(2);
+    machine.setThrowOnDeviceErrors(false);
+    canbus::Message msg;
+    msg.time = base::Time::now();
+    msg.can_id = 0x082;
+    msg.data[0] = 0x10;
+    msg.data[1] = 0x10;
+    msg.data[2] = 0xFA;
+    auto update = machine.process(msg);
+    ASSERT_EQ(StateMachine::PROCESSED_EMERGENCY, update.mode);
+    ASSERT_TRUE(update.hasUpdatedObject(
+        ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID));
+    ASSERT_EQ(0x1010, machine.getLastEmergency().code);
+    ASSERT_EQ(0xFA, machine.getLastEmergency().errorRegister);
+}
+
+TEST(StateMachine, processTimestampsEmergenciesWithTheirReceptionTime)
+{
+    StateMachine machine(2);
+    machine.setThrowOnDeviceErrors(false);
+    canbus::Message msg;
+    msg.time = base::Time::fromSeconds(1000);
+    msg.can_id = 0x082;
+    msg.data[0] = 0x10;
+    msg.data[1] = 0x10;
+    msg.data[2] = 0xFA;
+    machine.process(msg);
+    ASSERT_EQ(msg.time, machine.timestamp(
+        ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID));
+}
+
+TEST(StateMachine, processTimestampsEmergenciesWithTheClockIfTheyHaveNoTime)
+{
+    CachedClock clock;
+    clock.setTime(base::Time::fromSeconds(2000));
+    StateMachine machine(2);
+    machine.setClock(clock);
+    machine.setThrowOnDeviceErrors(false);
+    canbus::Message msg;
+    msg.can_id = 0x082;
+    msg.data[0] = 0x10;
+    msg.data[1] = 0x10;
+    msg.data[2] = 0xFA;
+    ASSERT_EQ(StateMachine::PROCESSED_EMERGENCY, machine.process(msg).mode);
+    ASSERT_EQ(clock.now(), machine.timestamp(
+        ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID));
+}
+
 TEST(StateMachine, processDoesNotThrowOnAnEmergencyWithZeroCode)
 {
     StateMachine machine(2);
@@ -259,6 +309,43 @@ TEST(StateMachine, setRejectsZeroUpdateTime)
     ASSERT_THROW(machine.set(0x12, 0x1, value, base::Time()), std::invalid_argument);
 }
 
+TEST(StateMachine, setTimestampsObjectsWithTheClock)
+{
+    StateMachine machine(2);
+    ASSERT_EQ(&SystemClock::instance(), &machine.getClock());
+
+    CachedClock clock(base::Time::fromSeconds(100));
+    machine.setClock(clock);
+    machine.set<uint16_t>(0x12, 0x1, 0x1234);
+    ASSERT_EQ(base::Time::fromSeconds(100), machine.timestamp(0x12, 0x1));
+
+    clock.advance(base::Time::fromMilliseconds(1));
+    machine.set<uint16_t>(0x12, 0x1, 0x1234);
+    ASSERT_EQ(base::Time::fromSeconds(100.001), machine.timestamp(0x12, 0x1));
+    ASSERT_EQ(base::Time::fromSeconds(100.001), machine.now());
+}
+
+TEST(StateMachine, setTimestampedKeepsNanosecondTimestamps)
+{
+    StateMachine machine(2);
+    Timestamp timestamp = 100000000123;
+    machine.setTimestamped<uint16_t>(0x12, 0x1, 0x1234, timestamp);
+    ASSERT_EQ(timestamp, machine.getTimestamp(0x12, 0x1));
+    ASSERT_EQ(base::Time::fromMicroseconds(100000000), machine.timestamp(0x12, 0x1));
+    ASSERT_EQ(0, machine.getTimestamp(0x12, 0x2));
+    ASSERT_THROW(machine.setTimestamped<uint16_t>(0x12, 0x1, 0, 0), std::invalid_argument);
+}
+
+TEST(StateMachine, syncTimestampsTheMessageWithTheGivenClock)
+{
+    CachedClock clock(base::Time::fromSeconds(100));
+    canbus::Message msg = StateMachine::sync(clock, 5);
+    ASSERT_EQ(0x80, msg.can_id);
+    ASSERT_EQ(1, msg.size);
+    ASSERT_EQ(5, msg.data[0]);
+    ASSERT_EQ(base::Time::fromSeconds(100), msg.time);
+}
+
 TEST(StateMachine, getFailsOnADeclaredButUnreadObject)
 {
     StateMachine machine(2);
@@ -381,6 +468,25 @@ TEST(StateMachine, processSDOAbort)
     ASSERT_THROW(machine.process(msg), SDODomainTransferAborted);
 }
 
+TEST(StateMachine, processReportsSDOAbortsAsUpdatesIfThrowOnDeviceErrorsIsFalse)
+{
+    canbus::Message msg;
+    msg.can_id = 0x582;
+    msg.data[0] = static_cast<uint8_t>(SDO_ABORT_DOMAIN_TRANSFER << 5);
+    msg.data[1] = 0xFE;
+    msg.data[2] = 0x03;
+    msg.data[3] = 0x10;
+    msg.data[4] = 0x05;
+    msg.data[5] = 0x00;
+    msg.data[6] = 0x03;
+    msg.data[7] = 0x05;
+
+    StateMachine machine(2);
+    machine.setThrowOnDeviceErrors(false);
+    ASSERT_EQ(Update(StateMachine::PROCESSED_SDO_ABORT, 0x03FE, 0x10), machine.process(msg));
+    ASSERT_EQ(0x05030005, machine.getLastSDOAbortCode());
+}
+
 TEST(StateMachine, ignoresSDOAbortForAnotherNode)
 {
     canbus::Message msg;
@@ -455,6 +561,27 @@ TEST(StateMachine, processPDO)
     ASSERT_EQ(2, machine.sizeOf(0x6401, 0x01));
     ASSERT_EQ(0x01, machine.get<uint8_t>(0x6000, 0x02));
     ASSERT_EQ(0x0302, machine.get<uint16_t>(0x6401, 0x01));
+    ASSERT_EQ(toTimestamp(msg.time), machine.getTimestamp(0x6000, 0x02));
+    ASSERT_EQ(msg.time, machine.timestamp(0x6401, 0x01));
+}
+
+TEST(StateMachine, processPDORejectsZeroUpdateTime)
+{
+    PDOMapping mappings;
+    mappings.add(0x6000, 0x02, 1);
+    StateMachine machine(2);
+    machine.declareTPDOMapping(1, mappings);
+
+    canbus::Message msg;
+    msg.time = base::Time();
+    msg.can_id = FUNCTION_PDO1_TRANSMIT + 2;
+    ASSERT_THROW(machine.process(msg), std::invalid_argument);
+}
+
+TEST(StateMachine, getRPDOMessageThrowsOnAnInvalidIndex)
+{
+    StateMachine machine(2);
+    ASSERT_THROW(machine.getRPDOMessage(MAX_PDO), std::invalid_argument);
 }
 
 TEST(StateMachine, processPDOIfNoMappingExists)
@@ -661,6 +788,48 @@ TEST(StateMachine, configurePDO)
     ASSERT_EQ(0x282, fromLittleEndian<uint32_t>(msg[8].data + 4));
 }
 
+TEST(StateMachine, configurePDO_into_a_buffer)
+{
+    auto parameters = PDOCommunicationParameters::Periodic(
+        base::Time::fromMilliseconds(10));
+    PDOMapping mappings;
+    for (int i = 0; i < 8; ++i)
+        mappings.add(0x6000, i, 1);
+
+    StateMachine machine(2);
+    machine.setQuirks(StateMachine::PDO_COBID_MESSAGE_RESERVED_BIT_QUIRK);
+    vector<canbus::Message> expected = machine.configurePDO(true, 1, parameters, mappings);
+
+    canbus::Message buffer[MAX_PDO_CONFIGURATION_MESSAGES];
+    size_t count = machine.configurePDO(true, 1, parameters, mappings, buffer);
+    ASSERT_EQ(MAX_PDO_CONFIGURATION_MESSAGES, count);
+    ASSERT_EQ(expected.size(), count);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(expected[i].can_id, buffer[i].can_id);
+        ASSERT_EQ(expected[i].size, buffer[i].size);
+        ASSERT_TRUE(equal(expected[i].data, expected[i].data + 8, buffer[i].data));
+    }
+}
+
+TEST(StateMachine, makePDOConfigurationMessagesInto_matches_the_vector_version)
+{
+    auto parameters = PDOCommunicationParameters::Sync(1);
+    PDOMapping mappings;
+    mappings.add(0x6000, 1, 2);
+
+    // A literal 0 for the quirk must resolve to the vector version
+    vector<canbus::Message> expected =
+        makePDOConfigurationMessages(true, 2, 1, parameters, mappings, 0);
+    canbus::Message buffer[MAX_PDO_CONFIGURATION_MESSAGES];
+    size_t count = makePDOConfigurationMessagesInto(
+        true, 2, 1, parameters, mappings, buffer);
+    ASSERT_EQ(expected.size(), count);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(expected[i].can_id, buffer[i].can_id);
+        ASSERT_TRUE(equal(expected[i].data, expected[i].data + 8, buffer[i].data));
+    }
+}
+
 TEST(StateMachine, configurePDO_COBID_MESSAGE_RESERVED_BIT_QUIRK)
 {
     PDOCommunicationParameters parameters;
@@ -788,3 +957,344 @@ TEST(Update, it_accepts_an_object_sub_id_offset_when_queries_with_a_dictionary_t
     update.addUpdate(15, 20);
     ASSERT_TRUE(update.hasUpdatedObject<DictionaryObject>(5, 0));
 }
+
+struct SynchronousPDOTest : public ::testing::Test {
+    StateMachine machine;
+    base::Time syncTime;
+
+    SynchronousPDOTest()
+        : machine(2)
+        , syncTime(base::Time::fromSeconds(100)) {
+        PDOMapping mapping;
+        mapping.add(0x6000, 0x02, 1);
+        machine.declareTPDOMapping(1, mapping, PDOCommunicationParameters::Sync(2));
+    }
+
+    void sync(uint64_t cycle) {
+        syncTime = base::Time::fromSeconds(100) + base::Time::fromMilliseconds(cycle);
+        machine.setSyncCycle(cycle, syncTime);
+    }
+
+    Update receive(base::Time delay = base::Time::fromMicroseconds(100)) {
+        canbus::Message msg;
+        msg.time = syncTime + delay;
+        msg.can_id = FUNCTION_PDO1_TRANSMIT + 2;
+        msg.size = 1;
+        return machine.process(msg);
+    }
+};
+
+TEST_F(SynchronousPDOTest, it_attributes_the_PDO_to_the_last_SYNC_cycle)
+{
+    sync(2);
+    Update update = receive();
+    ASSERT_EQ(StateMachine::PROCESSED_PDO, update.mode);
+    ASSERT_EQ(2, update.sync_cycle);
+    ASSERT_EQ(0, update.flags);
+    ASSERT_EQ(2, machine.getTPDOStatistics(1).lastCycle);
+    sync(3);
+    ASSERT_EQ(1, machine.getTPDOAge(1));
+}
+
+TEST_F(SynchronousPDOTest, it_flags_duplicate_PDOs)
+{
+    sync(2);
+    receive();
+    ASSERT_EQ(StateMachine::PDO_DUPLICATE, receive().flags);
+    ASSERT_EQ(1, machine.getTPDOStatistics(1).duplicates);
+}
+
+TEST_F(SynchronousPDOTest, it_flags_missed_PDOs)
+{
+    sync(2);
+    receive();
+    sync(4);
+    ASSERT_EQ(0, receive().flags);
+    sync(10);
+    ASSERT_EQ(StateMachine::PDO_MISSED, receive().flags);
+    ASSERT_EQ(2, machine.getTPDOStatistics(1).missed);
+    ASSERT_EQ(3, machine.getTPDOStatistics(1).received);
+}
+
+TEST_F(SynchronousPDOTest, it_flags_PDOs_received_after_the_synchronous_window)
+{
+    machine.setSyncWindow(base::Time::fromMicroseconds(500));
+    sync(2);
+    ASSERT_EQ(0, receive(base::Time::fromMicroseconds(500)).flags);
+    sync(4);
+    ASSERT_EQ(StateMachine::PDO_LATE, receive(base::Time::fromMicroseconds(501)).flags);
+    ASSERT_EQ(1, machine.getTPDOStatistics(1).late);
+}
+
+TEST_F(SynchronousPDOTest, it_does_not_track_asynchronous_PDOs)
+{
+    PDOMapping mapping;
+    mapping.add(0x6000, 0x02, 1);
+    machine.declareTPDOMapping(1, mapping);
+    sync(2);
+    receive();
+    Update update = receive();
+    ASSERT_EQ(0, update.flags);
+    ASSERT_EQ(0, update.sync_cycle);
+}
+
+TEST_F(SynchronousPDOTest, it_records_latency_histograms)
+{
+    ASSERT_THROW(machine.getSyncToTPDOHistogram(1), std::logic_error);
+    machine.enableLatencyStatistics();
+    ASSERT_THROW(machine.getTPDOJitterHistogram(4), std::out_of_range);
+
+    // Intervals of 2000, 2100 and 1900us
+    int delays[] = { 100, 100, 200, 100 };
+    for (int i = 0; i < 4; ++i) {
+        sync(2 * (i + 1));
+        receive(base::Time::fromMicroseconds(delays[i]));
+    }
+    LatencyHistogram const& sync = machine.getSyncToTPDOHistogram(1);
+    ASSERT_EQ(4, sync.getCount());
+    ASSERT_EQ(base::Time::fromMicroseconds(125), sync.getMean());
+    ASSERT_NEAR(100, sync.getPercentile(0.5).toMicroseconds(), 100 / 32);
+    ASSERT_EQ(base::Time::fromMicroseconds(200), sync.getMax());
+
+    LatencyHistogram const& jitter = machine.getTPDOJitterHistogram(1);
+    ASSERT_EQ(2, jitter.getCount());
+    ASSERT_EQ(base::Time::fromMicroseconds(100), jitter.getMin());
+    ASSERT_EQ(base::Time::fromMicroseconds(200), jitter.getMax());
+}
+
+TEST(StateMachine, it_records_the_round_trip_time_of_SDO_transactions)
+{
+    StateMachine machine(1);
+    machine.enableLatencyStatistics();
+    base::Time time = base::Time::fromSeconds(100);
+    machine.notifySent(machine.upload(0x1000, 0), time);
+
+    uint8_t reply[8] = { 0x43, 0x00, 0x10, 0x00, 0x92, 0x01, 0x02, 0x00 };
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = 0x581;
+    msg.size = 8;
+    std::copy(reply, reply + 8, msg.data);
+    msg.time = time + base::Time::fromMilliseconds(3);
+    machine.process(msg);
+    // Replies without a request are not counted
+    machine.process(msg);
+
+    LatencyHistogram const& histogram = machine.getSDORoundTripHistogram();
+    ASSERT_EQ(1, histogram.getCount());
+    ASSERT_EQ(base::Time::fromMilliseconds(3), histogram.getMax());
+}
+
+TEST(StateMachine, it_does_not_record_the_round_trip_time_of_a_reply_to_another_object)
+{
+    StateMachine machine(1);
+    machine.enableLatencyStatistics();
+    base::Time time = base::Time::fromSeconds(100);
+    machine.notifySent(machine.upload(0x1000, 1), time);
+
+    uint8_t reply[8] = { 0x43, 0x00, 0x10, 0x00, 0x92, 0x01, 0x02, 0x00 };
+    auto msg = canbus::Message::Zeroed();
+    msg.can_id = 0x581;
+    msg.size = 8;
+    std::copy(reply, reply + 8, msg.data);
+    msg.time = time + base::Time::fromMilliseconds(3);
+    machine.process(msg);
+    ASSERT_EQ(0, machine.getSDORoundTripHistogram().getCount());
+
+    // The request is still pending
+    msg.data[3] = 0x01;
+    msg.time = time + base::Time::fromMilliseconds(5);
+    machine.process(msg);
+    LatencyHistogram const& histogram = machine.getSDORoundTripHistogram();
+    ASSERT_EQ(1, histogram.getCount());
+    ASSERT_EQ(base::Time::fromMilliseconds(5), histogram.getMax());
+}
+
+struct SubscriptionTest : public ::testing::Test {
+    StateMachine machine;
+    base::Time time = base::Time::fromSeconds(100);
+
+    SubscriptionTest()
+        : machine(2) {
+        PDOMapping mapping;
+        mapping.add(0x6000, 1, 2);
+        mapping.add(0x6000, 2, 1);
+        machine.declareTPDOMapping(1, mapping);
+    }
+
+    Update receivePDO(int16_t first, int8_t second) {
+        auto msg = canbus::Message::Zeroed();
+        msg.time = time;
+        msg.can_id = FUNCTION_PDO1_TRANSMIT + 2;
+        msg.size = 3;
+        msg.data[0] = first & 0xFF;
+        msg.data[1] = (first >> 8) & 0xFF;
+        msg.data[2] = second;
+        return machine.process(msg);
+    }
+};
+
+CANOPEN_DEFINE_OBJECT(0x6000, 2, SubscribedObject, int8_t);
+
+TEST_F(SubscriptionTest, it_calls_only_the_subscribers_of_the_written_objects)
+{
+    vector<string> calls;
+    machine.subscribe(0x6000, 1, [&](StateMachine::ObjectUpdate const& update) {
+        calls.push_back("first");
+        ASSERT_EQ(0x6000, update.objectId);
+        ASSERT_EQ(1, update.subId);
+        ASSERT_EQ(-2, update.as<int16_t>());
+        ASSERT_EQ(toTimestamp(time), update.timestamp);
+        // Both objects are written before the callbacks are called
+        ASSERT_EQ(-3, machine.get<int8_t>(0x6000, 2));
+    });
+    machine.subscribe(0x7000, 0, [&](StateMachine::ObjectUpdate const&) {
+        calls.push_back("other");
+    });
+    machine.subscribe<SubscribedObject>([&](int8_t value, base::Time const& t) {
+        calls.push_back("second " + to_string(value));
+        ASSERT_EQ(time, t);
+    });
+
+    receivePDO(-2, -3);
+    ASSERT_EQ(vector<string>({ "first", "second -3" }), calls);
+
+    // Local writes do not notify
+    machine.set<int8_t>(0x6000, 2, 5, time);
+    ASSERT_EQ(2, calls.size());
+}
+
+TEST_F(SubscriptionTest, it_removes_subscriptions)
+{
+    int calls = 0;
+    auto id = machine.subscribe(0x6000, 1, [&](StateMachine::ObjectUpdate const&) {
+        ++calls;
+    });
+    receivePDO(1, 1);
+    machine.unsubscribe(id);
+    receivePDO(1, 1);
+    ASSERT_EQ(1, calls);
+}
+
+TEST_F(SubscriptionTest, it_handles_subscriptions_to_undeclared_objects)
+{
+    uint32_t value = 0;
+    machine.subscribe<DeviceType>([&](uint32_t v, base::Time const&) { value = v; });
+    ASSERT_FALSE(machine.has(0x1000, 0));
+
+    canbus::Message msg;
+    msg.time = time;
+    msg.can_id = 0x582;
+    uint8_t reply[8] = { 0x43, 0x00, 0x10, 0x00, 0x92, 0x01, 0x02, 0x00 };
+    std::copy(reply, reply + 8, msg.data);
+    machine.process(msg);
+    ASSERT_EQ(0x20192, value);
+    ASSERT_EQ(0x20192, machine.get<uint32_t>(0x1000, 0));
+}
+
+TEST_F(SubscriptionTest, it_keeps_the_size_of_objects_declared_after_subscribing)
+{
+    int16_t value = 0;
+    uint32_t size = 0;
+    machine.subscribe(0x2000, 1, [&](StateMachine::ObjectUpdate const& update) {
+        value = update.as<int16_t>();
+        size = update.size;
+    });
+    machine.declare(0x2000, 1, 2);
+    ASSERT_EQ(2, machine.sizeOf(0x2000, 1));
+
+    // Expedited upload reply that does not state its size
+    canbus::Message msg;
+    msg.time = time;
+    msg.can_id = 0x582;
+    uint8_t reply[8] = { 0x42, 0x00, 0x20, 0x01, 0xFE, 0xFF, 0x12, 0x34 };
+    std::copy(reply, reply + 8, msg.data);
+    machine.process(msg);
+    ASSERT_EQ(-2, value);
+    ASSERT_EQ(2, size);
+    ASSERT_EQ(-2, machine.get<int16_t>(0x2000, 1));
+    ASSERT_THROW(machine.set<int32_t>(0x2000, 1, 0, time), ProtocolError);
+}
+
+TEST_F(SubscriptionTest, it_notifies_objects_written_before_an_exception)
+{
+    uint8_t errorRegister = 0;
+    machine.subscribe<ErrorRegister>([&](uint8_t value, base::Time const&) {
+        errorRegister = value;
+    });
+
+    canbus::Message msg;
+    msg.time = time;
+    msg.can_id = FUNCTION_EMERGENCY + 2;
+    msg.size = 8;
+    uint8_t data[8] = { 0x10, 0x23, 0x03, 0, 0, 0, 0, 0 };
+    std::copy(data, data + 8, msg.data);
+    ASSERT_THROW(machine.process(msg), EmergencyMessageReceived);
+    ASSERT_EQ(3, errorRegister);
+}
+
+struct HistoryTest : public SubscriptionTest {};
+
+TEST_F(HistoryTest, it_keeps_the_last_values_of_the_objects_with_a_history)
+{
+    ObjectHistory const& history = machine.enableHistory<SubscribedObject>(4);
+    ASSERT_EQ(&history, &machine.enableHistory(0x6000, 2, 8));
+    ASSERT_EQ(&history, &machine.getHistory(0x6000, 2));
+    ASSERT_THROW(machine.getHistory(0x6000, 1), std::invalid_argument);
+
+    for (int i = 0; i < 6; ++i) {
+        time = base::Time::fromSeconds(100 + i);
+        receivePDO(i, -i);
+    }
+    ASSERT_EQ(6, history.getCount());
+
+    ObjectSample samples[8];
+    ASSERT_EQ(4, history.read(samples, 8));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(toTimestamp(base::Time::fromSeconds(102 + i)), samples[i].timestamp);
+        ASSERT_EQ(-2 - i, samples[i].as<int8_t>());
+        ASSERT_EQ(-2 - i, samples[i].as<int32_t>());
+    }
+    ASSERT_EQ(2, history.read(samples, 2));
+    ASSERT_EQ(-5, samples[1].as<int8_t>());
+}
+
+TEST(StateMachine, it_keeps_the_size_of_objects_mapped_after_enabling_their_history)
+{
+    StateMachine machine(2);
+    ObjectHistory const& history = machine.enableHistory(0x6001, 1, 4);
+    PDOMapping mapping;
+    mapping.add(0x6001, 1, 2);
+    machine.declareTPDOMapping(1, mapping);
+    ASSERT_EQ(2, machine.sizeOf(0x6001, 1));
+
+    auto msg = canbus::Message::Zeroed();
+    msg.time = base::Time::fromSeconds(100);
+    msg.can_id = FUNCTION_PDO1_TRANSMIT + 2;
+    msg.size = 2;
+    msg.data[0] = 0xFE;
+    msg.data[1] = 0xFF;
+    machine.process(msg);
+    ObjectSample sample;
+    ASSERT_EQ(1, history.read(&sample, 1));
+    ASSERT_EQ(2, sample.size);
+
+    // An upload reply with another size is rejected
+    msg.can_id = 0x582;
+    uint8_t reply[8] = { 0x43, 0x01, 0x60, 0x01, 0, 0, 0, 0 };
+    std::copy(reply, reply + 8, msg.data);
+    ASSERT_THROW(machine.process(msg), ProtocolError);
+}
+
+TEST_F(HistoryTest, copies_of_the_state_machine_have_their_own_histories)
+{
+    machine.enableHistory(0x6000, 1, 4);
+    receivePDO(1, 0);
+    StateMachine copy(machine);
+    receivePDO(2, 0);
+
+    ObjectSample samples[4];
+    ASSERT_EQ(1, copy.getHistory(0x6000, 1).read(samples, 4));
+    ASSERT_EQ(1, samples[0].as<int16_t>());
+    machine = copy;
+    ASSERT_EQ(1, machine.getHistory(0x6000, 1).getCount());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <canopen_master/SyncProducer.hpp>
+#include <canopen_master/StateMachine.hpp>
+
+using namespace base;
+using namespace canopen_master;
+
+TEST(SyncProducer, it_creates_a_SYNC_message_without_counter) {
+    auto msg = makeSyncMessage(0, Time::fromSeconds(10));
+    ASSERT_EQ(0x80, msg.can_id);
+    ASSERT_EQ(0, msg.size);
+    ASSERT_EQ(Time::fromSeconds(10), msg.time);
+    ASSERT_FALSE(hasSyncCounter(msg));
+}
+
+TEST(SyncProducer, it_creates_a_SYNC_message_with_counter) {
+    auto msg = StateMachine::sync(12);
+    ASSERT_EQ(0x80, msg.can_id);
+    ASSERT_EQ(1, msg.size);
+    ASSERT_TRUE(hasSyncCounter(msg));
+    ASSERT_EQ(12, getSyncCounter(msg));
+}
+
+TEST(SyncProducer, it_wraps_the_counter_at_the_overflow_value) {
+    ASSERT_EQ(0, SyncProducer::getCounter(1, 0));
+    ASSERT_EQ(1, SyncProducer::getCounter(1, 3));
+    ASSERT_EQ(3, SyncProducer::getCounter(3, 3));
+    ASSERT_EQ(1, SyncProducer::getCounter(4, 3));
+}
+
+TEST(SyncProducer, it_rejects_invalid_counter_overflow_values) {
+    ASSERT_THROW(SyncProducer(Time::fromMilliseconds(1), 1), std::invalid_argument);
+    ASSERT_THROW(SyncProducer(Time::fromMilliseconds(1), 241), std::invalid_argument);
+}
+
+TEST(SyncProducer, it_produces_SYNCs_at_the_requested_period) {
+    SyncProducer producer(Time::fromMilliseconds(1), 4);
+    producer.setSpinTime(Time::fromMicroseconds(50));
+
+    Time start = Time::now();
+    for (int i = 0; i < 10; ++i) {
+        auto msg = producer.wait();
+        ASSERT_EQ(SyncProducer::getCounter(i + 1, 4), getSyncCounter(msg));
+    }
+    Time duration = Time::now() - start;
+
+    ASSERT_EQ(10, producer.getCycle());
+    ASSERT_EQ(2, producer.getCounter());
+    ASSERT_GE(duration, Time::fromMilliseconds(10));
+
+    auto const& stats = producer.getStatistics();
+    ASSERT_EQ(10, stats.cycles);
+    ASSERT_GE(stats.minLatency, 0);
+    ASSERT_LE(stats.minLatency, stats.maxLatency);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "AllocationCounter.hpp"
+#include <canopen_master/StateMachine.hpp>
+#include <canopen_master/Objects.hpp>
+#include <canopen_master/ColumnarExporter.hpp>
+#include <canopen_master/ProtocolCounters.hpp>
+#include <unistd.h>
+
+using namespace std;
+using namespace canopen_master;
+typedef StateMachine::Update Update;
+
+/** Steady-state paths that must not touch the heap once objects and PDOs
+ * have been declared
+ *
+ * These tests are in a separate executable as they replace the global
+ * operator new
+ */
+struct AllocationsTest : public ::testing::Test {
+    StateMachine machine;
+    base::Time time = base::Time::fromSeconds(1000);
+
+    AllocationsTest()
+        : machine(1) {
+        machine.setThrowOnDeviceErrors(false);
+        machine.declare(0x2000, 1, 2);
+        machine.declare(ErrorRegister::OBJECT_ID, ErrorRegister::OBJECT_SUB_ID, 1);
+
+        PDOMapping mapping;
+        for (int i = 0; i < 8; ++i)
+            mapping.add(0x2100, i + 1, 1);
+        machine.declareTPDOMapping(0, mapping, PDOCommunicationParameters::Sync(1));
+        machine.declareRPDOMapping(0, mapping);
+        for (int i = 0; i < 8; ++i)
+            machine.set<uint8_t>(0x2100, i + 1, i, time);
+    }
+
+    canbus::Message makeMessage(uint32_t can_id, std::vector<uint8_t> const& data) {
+        auto msg = canbus::Message::Zeroed();
+        msg.can_id = can_id;
+        msg.size = data.size();
+        msg.time = time;
+        copy(data.begin(), data.end(), msg.data);
+        return msg;
+    }
+
+    /** Count the allocations done by f after a first warm-up call */
+    template<typename F>
+    uint64_t countAllocations(F f) {
+        f();
+        uint64_t count = getAllocationCount();
+        for (int i = 0; i < 100; ++i)
+            f();
+        return getAllocationCount() - count;
+    }
+
+    uint64_t countProcessAllocations(canbus::Message const& msg,
+                                     StateMachine::UPDATE_EVENT expected) {
+        return countAllocations([&]() {
+            ASSERT_EQ(expected, machine.process(msg).mode);
+        });
+    }
+};
+
+TEST_F(AllocationsTest, the_counter_detects_allocations) {
+    ASSERT_EQ(100, countAllocations([]() {
+        // volatile prevents the compiler from eliding the allocation
+        int* volatile ptr = new int;
+        delete ptr;
+    }));
+}
+
+TEST_F(AllocationsTest, heartbeat_processing_does_not_allocate) {
+    auto msg = makeMessage(0x701, { NODE_OPERATIONAL });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_HEARTBEAT));
+}
+
+TEST_F(AllocationsTest, TPDO_processing_does_not_allocate) {
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countAllocations([&]() {
+        machine.setSyncCycle(machine.getSyncCycle() + 1, time);
+        ASSERT_EQ(StateMachine::PROCESSED_PDO, machine.process(msg).mode);
+    }));
+}
+
+TEST_F(AllocationsTest, subscription_dispatch_does_not_allocate) {
+    uint32_t sum = 0;
+    for (int i = 0; i < 8; ++i) {
+        machine.subscribe(0x2100, i + 1, [&](StateMachine::ObjectUpdate const& update) {
+            sum += update.as<uint8_t>();
+        });
+    }
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_PDO));
+    ASSERT_EQ(101 * 36, sum);
+}
+
+TEST_F(AllocationsTest, history_recording_does_not_allocate) {
+    for (int i = 0; i < 8; ++i)
+        machine.enableHistory(0x2100, i + 1, 16);
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_PDO));
+    ASSERT_EQ(101, machine.getHistory(0x2100, 8).getCount());
+}
+
+TEST_F(AllocationsTest, latency_recording_does_not_allocate) {
+    machine.enableLatencyStatistics();
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countAllocations([&]() {
+        machine.setSyncCycle(machine.getSyncCycle() + 1, time);
+        msg.time = msg.time + base::Time::fromMilliseconds(1);
+        ASSERT_EQ(StateMachine::PROCESSED_PDO, machine.process(msg).mode);
+    }));
+    ASSERT_EQ(101, machine.getSyncToTPDOHistogram(0).getCount());
+}
+
+TEST_F(AllocationsTest, protocol_counting_does_not_allocate) {
+    ProtocolCounters counters;
+    machine.setProtocolCounters(&counters);
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_PDO));
+    ASSERT_EQ(101, counters.get(1, COUNTER_FRAMES));
+}
+
+TEST_F(AllocationsTest, columnar_export_does_not_allocate_per_sample) {
+    string path = "/tmp/canopen_master_test_" + to_string(getpid()) + ".cols";
+    ColumnarExporter exporter(path, 1024);
+    for (int i = 0; i < 8; ++i)
+        exporter.add(machine, 0x2100, i + 1, COLUMN_UINT8);
+    auto msg = makeMessage(0x181, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_PDO));
+    ASSERT_EQ(101, exporter.getSampleCount(7));
+    exporter.close();
+    unlink(path.c_str());
+}
+
+TEST_F(AllocationsTest, SDO_upload_reply_processing_does_not_allocate) {
+    auto msg = makeMessage(0x581, { 0x4B, 0x00, 0x20, 0x01, 0x34, 0x12, 0, 0 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_SDO));
+}
+
+TEST_F(AllocationsTest, SDO_download_reply_processing_does_not_allocate) {
+    auto msg = makeMessage(0x581, { 0x60, 0x00, 0x20, 0x01, 0, 0, 0, 0 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_SDO_INITIATE_DOWNLOAD));
+}
+
+TEST_F(AllocationsTest, SDO_abort_processing_does_not_allocate) {
+    auto msg = makeMessage(0x581, { 0x80, 0x00, 0x20, 0x01, 0x00, 0x00, 0x02, 0x06 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_SDO_ABORT));
+    ASSERT_EQ(0x06020000, machine.getLastSDOAbortCode());
+}
+
+TEST_F(AllocationsTest, emergency_processing_does_not_allocate) {
+    auto msg = makeMessage(0x81, { 0x10, 0x23, 0x03, 0, 0, 0, 0, 0 });
+    ASSERT_EQ(0, countProcessAllocations(msg, StateMachine::PROCESSED_EMERGENCY));
+    ASSERT_EQ(0x2310, machine.getLastEmergency().code);
+
+    auto noError = makeMessage(0x81, { 0, 0, 0, 0, 0, 0, 0, 0 });
+    ASSERT_EQ(0, countProcessAllocations(noError, StateMachine::PROCESSED_EMERGENCY_NO_ERROR));
+}
+
+TEST_F(AllocationsTest, RPDO_generation_does_not_allocate) {
+    ASSERT_EQ(0, countAllocations([&]() {
+        ASSERT_EQ(8, machine.getRPDOMessage(0).size);
+    }));
+}
+
+TEST_F(AllocationsTest, dictionary_access_does_not_allocate) {
+    ASSERT_EQ(0, countAllocations([&]() {
+        machine.set<uint16_t>(0x2000, 1, 10, time);
+        ASSERT_EQ(10, machine.get<uint16_t>(0x2000, 1));
+    }));
+}
+
+TEST_F(AllocationsTest, message_construction_does_not_allocate) {
+    ASSERT_EQ(0, countAllocations([&]() {
+        machine.upload(0x2000, 1);
+        machine.download<uint16_t>(0x2000, 1, 10);
+    }));
+}
+
+TEST_F(AllocationsTest, PDO_configuration_into_a_buffer_does_not_allocate) {
+    PDOMapping mapping;
+    mapping.add(0x2000, 1, 2);
+    auto parameters = PDOCommunicationParameters::Sync(1);
+    canbus::Message messages[MAX_PDO_CONFIGURATION_MESSAGES];
+    ASSERT_EQ(0, countAllocations([&]() {
+        machine.configurePDO(true, 1, parameters, mapping, messages);
+        machine.configurePDOParameters(true, 1, parameters, messages);
+        machine.configurePDOMapping(true, 1, mapping, messages);
+    }));
+}